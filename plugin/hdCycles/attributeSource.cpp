@@ -19,6 +19,7 @@
 
 #include "attributeSource.h"
 #include "basisCurves.h"
+#include "utils.h"
 
 #include <pxr/base/gf/vec2f.h>
 #include <pxr/base/gf/vec2i.h>
@@ -292,7 +293,11 @@ HdBbAttributeSource::_CheckValid() const
 VtValue
 HdBbAttributeSource::UncheckedCastToFloat(const VtValue& input_value)
 {
-    VtValue value = input_value;
+    // double and half arrays are converted with the array conversion kernels
+    VtValue value = array_to_float_array(input_value);
+    if (IsHoldingFloat(value)) {
+        return value;
+    }
 
     HdTupleType tuple_type = HdGetValueTupleType(value);
     size_t count = HdGetComponentCount(tuple_type.type);
@@ -192,11 +192,10 @@ HdCyclesBasisCurves::_PopulateMotion(HdSceneDelegate* sceneDelegate, const SdfPa
             continue;
 
         VtVec3fArray pp;
-        pp = motion_samples.values.data()[i].Get<VtVec3fArray>();
+        pp = array_to_float_array(motion_samples.values.data()[i]).Get<VtVec3fArray>();
 
-        for (size_t j = 0; j < m_points.size(); ++j, ++mP) {
-            *mP = vec3f_to_float3(pp[j]);
-        }
+        vec3f_to_float3(pp.cdata(), mP, m_points.size());
+        mP += m_points.size();
     }
 }
 
@@ -204,6 +203,7 @@ void
 HdCyclesBasisCurves::_AddColors(TfToken name, VtValue value, HdInterpolation interpolation)
 {
     ccl::ustring attribName = ccl::ustring(name.GetString());
+    value = array_to_float_array(value);
 
     int vecSize = 0;
     size_t numColors = 0;
@@ -241,7 +241,11 @@ HdCyclesBasisCurves::_AddColors(TfToken name, VtValue value, HdInterpolation int
 
             ccl::float3* fdata = attr_vcol->data_float3();
 
-            if (fdata) {
+            if (fdata && vecSize == 3) {
+                vec3f_to_float3(colors3f.cdata(), fdata, numColors);
+            } else if (fdata && vecSize == 4) {
+                vec4f_to_float3(colors4f.cdata(), fdata, numColors);
+            } else if (fdata) {
                 size_t i = 0;
 
                 for (size_t curve = 0; curve < numColors; curve++) {
@@ -306,6 +310,7 @@ void
 HdCyclesBasisCurves::_AddUVS(TfToken name, VtValue value, HdInterpolation interpolation)
 {
     ccl::ustring attribName = ccl::ustring(name.GetString());
+    value = array_to_float_array(value);
 
     // convert uniform uv attrib
 
@@ -473,15 +478,16 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderP
                 // special primvars
                 //
                 if (description.name == HdTokens->points) {
+                    // double and half data is converted with the array conversion kernels
                     VtValue value = sceneDelegate->Get(id, HdTokens->points);
-                    m_points = value.Get<VtVec3fArray>();
+                    m_points = array_to_float_array(value).Get<VtVec3fArray>();
                     generate_new_curve = true;
                     continue;
                 }
 
                 if (description.name == HdTokens->widths) {
                     VtValue value = sceneDelegate->Get(id, HdTokens->widths);
-                    m_widths = value.Get<VtFloatArray>();
+                    m_widths = array_to_float_array(value).Get<VtFloatArray>();
                     m_widthsInterpolation = description.interpolation;
                     generate_new_curve = true;
                     continue;
@@ -489,7 +495,7 @@ HdCyclesBasisCurves::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderP
 
                 if (description.name == HdTokens->normals) {
                     VtValue value = sceneDelegate->Get(id, HdTokens->normals);
-                    m_normals = value.Get<VtVec3fArray>();
+                    m_normals = array_to_float_array(value).Get<VtVec3fArray>();
                     generate_new_curve = true;
                     continue;
                 }
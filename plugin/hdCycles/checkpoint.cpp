@@ -0,0 +1,278 @@
+//  Copyright 2021 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "checkpoint.h"
+
+#include <pxr/base/gf/half.h>
+#include <pxr/base/tf/diagnostic.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+constexpr char HdCyclesCheckpointMagic[8] = { 'H', 'D', 'C', 'Y', 'C', 'K', 'P', 'T' };
+constexpr uint32_t HdCyclesCheckpointVersion = 1;
+
+// Values per blend task
+constexpr size_t HdCyclesBlendGrainSize = 64 * 1024;
+
+template<typename T>
+void
+WriteValue(std::ofstream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool
+ReadValue(std::ifstream& in, T& value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+}  // namespace
+
+bool
+HdCyclesCheckpoint::Read(const std::string& path)
+{
+    Clear();
+
+    std::ifstream in { path, std::ios::binary };
+    if (!in) {
+        return false;
+    }
+
+    char magic[sizeof(HdCyclesCheckpointMagic)];
+    uint32_t version = 0;
+    int32_t samples = 0;
+    uint32_t numLayers = 0;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, HdCyclesCheckpointMagic, sizeof(magic)) != 0
+        || !ReadValue(in, version) || version != HdCyclesCheckpointVersion || !ReadValue(in, samples)
+        || !ReadValue(in, numLayers)) {
+        TF_WARN("Invalid checkpoint %s", path.c_str());
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numLayers; ++i) {
+        uint32_t nameLength = 0;
+        int32_t format = 0;
+        Layer layer;
+        if (!ReadValue(in, nameLength)) {
+            break;
+        }
+
+        std::string name(nameLength, '\0');
+        uint64_t dataSize = 0;
+        if (!in.read(&name[0], nameLength) || !ReadValue(in, format) || !ReadValue(in, layer.width)
+            || !ReadValue(in, layer.height) || !ReadValue(in, dataSize)) {
+            break;
+        }
+
+        layer.format = static_cast<HdFormat>(format);
+        if (layer.format <= HdFormatInvalid || layer.format >= HdFormatCount
+            || dataSize != static_cast<uint64_t>(layer.width) * layer.height * HdDataSizeOfFormat(layer.format)) {
+            break;
+        }
+
+        layer.data.resize(dataSize);
+        if (!in.read(reinterpret_cast<char*>(layer.data.data()), static_cast<std::streamsize>(dataSize))) {
+            break;
+        }
+
+        m_layers[name] = std::move(layer);
+    }
+
+    if (m_layers.size() != numLayers) {
+        TF_WARN("Truncated checkpoint %s", path.c_str());
+        Clear();
+        return false;
+    }
+
+    m_samples = samples;
+    return true;
+}
+
+bool
+HdCyclesCheckpoint::Write(const std::string& path) const
+{
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out { tmpPath, std::ios::binary | std::ios::trunc };
+        if (!out) {
+            TF_WARN("Unable to write checkpoint %s", tmpPath.c_str());
+            return false;
+        }
+
+        out.write(HdCyclesCheckpointMagic, sizeof(HdCyclesCheckpointMagic));
+        WriteValue(out, HdCyclesCheckpointVersion);
+        WriteValue(out, static_cast<int32_t>(m_samples));
+        WriteValue(out, static_cast<uint32_t>(m_layers.size()));
+
+        for (const auto& entry : m_layers) {
+            const Layer& layer = entry.second;
+            WriteValue(out, static_cast<uint32_t>(entry.first.size()));
+            out.write(entry.first.data(), static_cast<std::streamsize>(entry.first.size()));
+            WriteValue(out, static_cast<int32_t>(layer.format));
+            WriteValue(out, layer.width);
+            WriteValue(out, layer.height);
+            WriteValue(out, static_cast<uint64_t>(layer.data.size()));
+            out.write(reinterpret_cast<const char*>(layer.data.data()),
+                      static_cast<std::streamsize>(layer.data.size()));
+        }
+
+        if (!out.flush()) {
+            TF_WARN("Unable to write checkpoint %s", tmpPath.c_str());
+            return false;
+        }
+    }
+
+    // Rename does not replace existing files on every platform
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(path.c_str());
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            TF_WARN("Unable to replace checkpoint %s", path.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+HdCyclesCheckpoint::Clear()
+{
+    m_samples = 0;
+    m_displayed = false;
+    m_layers.clear();
+}
+
+int
+HdCyclesCheckpoint::GetRangeStart() const
+{
+    return IsEmpty() ? -1 : m_samples;
+}
+
+int
+HdCyclesCheckpoint::GetRangeSamples(int totalSamples) const
+{
+    return IsEmpty() ? -1 : std::max(totalSamples - m_samples, 1);
+}
+
+bool
+HdCyclesCheckpoint::Reset()
+{
+    if (IsEmpty() || !m_displayed) {
+        return false;
+    }
+
+    Clear();
+    return true;
+}
+
+void
+HdCyclesCheckpoint::SetLayer(const std::string& name, HdFormat format, unsigned int width, unsigned int height,
+                             const void* data)
+{
+    Layer& layer = m_layers[name];
+    layer.format = format;
+    layer.width = width;
+    layer.height = height;
+
+    const auto bytes = static_cast<const uint8_t*>(data);
+    layer.data.assign(bytes, bytes + static_cast<size_t>(width) * height * HdDataSizeOfFormat(format));
+}
+
+const HdCyclesCheckpoint::Layer*
+HdCyclesCheckpoint::GetLayer(const std::string& name) const
+{
+    auto it = m_layers.find(name);
+    return it != m_layers.end() ? &it->second : nullptr;
+}
+
+const HdCyclesCheckpoint::Layer*
+HdCyclesCheckpoint::GetBlendLayer(const std::string& name, HdFormat format, unsigned int width,
+                                  unsigned int height) const
+{
+    const Layer* layer = GetLayer(name);
+    if (!layer || layer->format != format || layer->width != width || layer->height != height) {
+        return nullptr;
+    }
+
+    const HdFormat componentFormat = HdGetComponentFormat(format);
+    if (componentFormat != HdFormatFloat32 && componentFormat != HdFormatFloat16) {
+        return nullptr;
+    }
+
+    return layer;
+}
+
+float
+HdCyclesCheckpoint::GetBlendWeight(int samples) const
+{
+    if (m_samples <= 0 || samples <= 0) {
+        return 0.0f;
+    }
+
+    return static_cast<float>(m_samples) / static_cast<float>(m_samples + samples);
+}
+
+bool
+HdCyclesCheckpoint::Blend(const std::string& name, HdFormat format, unsigned int width, unsigned int height,
+                          int samples, void* data) const
+{
+    const Layer* layer = GetBlendLayer(name, format, width, height);
+    if (!layer || m_samples <= 0 || samples <= 0) {
+        return false;
+    }
+
+    const HdFormat componentFormat = HdGetComponentFormat(format);
+    const float layerWeight = GetBlendWeight(samples);
+    const float weight = 1.0f - layerWeight;
+    const size_t numValues = static_cast<size_t>(width) * height * HdGetComponentCount(format);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, numValues, HdCyclesBlendGrainSize),
+                      [&](const tbb::blocked_range<size_t>& r) {
+                          if (componentFormat == HdFormatFloat32) {
+                              auto src = reinterpret_cast<const float*>(layer->data.data());
+                              auto dst = static_cast<float*>(data);
+                              for (size_t i = r.begin(); i < r.end(); ++i) {
+                                  dst[i] = src[i] * layerWeight + dst[i] * weight;
+                              }
+                          } else {
+                              auto src = reinterpret_cast<const GfHalf*>(layer->data.data());
+                              auto dst = static_cast<GfHalf*>(data);
+                              for (size_t i = r.begin(); i < r.end(); ++i) {
+                                  const float value = static_cast<float>(dst[i]);
+                                  dst[i] = static_cast<float>(src[i]) * layerWeight + value * weight;
+                              }
+                          }
+                      });
+
+    return true;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,145 @@
+//  Copyright 2021 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef HD_CYCLES_CHECKPOINT_H
+#define HD_CYCLES_CHECKPOINT_H
+
+#include "api.h"
+
+#include <pxr/imaging/hd/types.h>
+#include <pxr/pxr.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/**
+ * @brief Render buffers and sample count of a progressive render saved to disk.
+ * A render resumed from a checkpoint only renders the remaining samples and
+ * blends them with the saved layers.
+ *
+ */
+class HdCyclesCheckpoint {
+public:
+    struct Layer {
+        HdFormat format;
+        unsigned int width;
+        unsigned int height;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * @brief Read checkpoint from file, previous content is discarded
+     *
+     * @param path
+     * @return false if the file doesn't exist or is not a valid checkpoint
+     */
+    bool Read(const std::string& path);
+
+    /**
+     * @brief Write checkpoint next to the path and rename it,
+     * an interrupted write keeps the previous checkpoint intact
+     *
+     * @param path
+     * @return true if the checkpoint was written
+     */
+    bool Write(const std::string& path) const;
+
+    void Clear();
+    bool IsEmpty() const { return m_layers.empty(); }
+
+    int GetSamples() const { return m_samples; }
+    void SetSamples(int samples) { m_samples = samples; }
+
+    /**
+     * @brief First sample of the resumed render range
+     *
+     * @return -1 if there is nothing to resume, all samples are rendered
+     */
+    int GetRangeStart() const;
+
+    /**
+     * @brief Number of samples left to render after the checkpoint
+     *
+     * @param totalSamples Number of samples of the full render
+     * @return -1 if there is nothing to resume, all samples are rendered
+     */
+    int GetRangeSamples(int totalSamples) const;
+
+    /**
+     * @brief The resumed render has been displayed, the scene it was saved from is now being rendered
+     *
+     */
+    void SetDisplayed() { m_displayed = true; }
+
+    /**
+     * @brief The session is reset. Resets before the resumed render was displayed are part of the startup
+     * and keep the checkpoint. Later resets follow scene or camera edits, the checkpoint is cleared
+     * and following renders start over with all samples.
+     *
+     * @return true if the checkpoint was cleared
+     */
+    bool Reset();
+
+    void SetLayer(const std::string& name, HdFormat format, unsigned int width, unsigned int height, const void* data);
+    const Layer* GetLayer(const std::string& name) const;
+
+    /**
+     * @brief Layer that render buffer pixels of the format and size are blended with
+     *
+     * @return nullptr if there is no matching layer or the format is not float, pixels are kept as rendered
+     */
+    const Layer* GetBlendLayer(const std::string& name, HdFormat format, unsigned int width,
+                               unsigned int height) const;
+
+    /**
+     * @brief Weight of the layers when blended with pixels rendered with the number of samples
+     *
+     * @param samples Number of samples the pixels were rendered with
+     * @return Weight of the layers, the pixels get the rest. 0 if either has no samples
+     */
+    float GetBlendWeight(int samples) const;
+
+    /**
+     * @brief Blend render buffer pixels with the layer, weighted by the number of samples of each.
+     * Only float formats are blended, values of other formats are kept.
+     *
+     * @param name Name of the layer
+     * @param format Format of the data, must match the layer
+     * @param width Width of the data, must match the layer
+     * @param height Height of the data, must match the layer
+     * @param samples Number of samples the data was rendered with
+     * @param data Pixels to blend in place
+     * @return true if the layer was blended
+     */
+    bool Blend(const std::string& name, HdFormat format, unsigned int width, unsigned int height, int samples,
+               void* data) const;
+
+private:
+    int m_samples = 0;
+    bool m_displayed = false;
+    std::unordered_map<std::string, Layer> m_layers;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif  // HD_CYCLES_CHECKPOINT_H
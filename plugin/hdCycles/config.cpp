@@ -105,6 +105,7 @@ HdCyclesConfig::HdCyclesConfig()
     enable_subdivision = HdCyclesEnvValue<bool>("HD_CYCLES_ENABLE_SUBDIVISION", false);
     subdivision_dicing_rate = HdCyclesEnvValue<float>("HD_CYCLES_SUBDIVISION_DICING_RATE", 1.0);
     max_subdivision = HdCyclesEnvValue<int>("HD_CYCLES_MAX_SUBDIVISION", 12);
+    subdivision_evaluator = HdCyclesEnvValue<std::string>("HD_CYCLES_SUBDIVISION_EVALUATOR", "TBB");
     enable_dof = HdCyclesEnvValue<bool>("HD_CYCLES_ENABLE_DOF", true);
 
     render_width = HdCyclesEnvValue<int>("HD_CYCLES_RENDER_WIDTH", 1280);
@@ -132,6 +133,9 @@ HdCyclesConfig::HdCyclesConfig()
     default_point_style      = HdCyclesEnvValue<int>("HD_CYCLES_DEFAULT_POINT_STYLE", ccl::POINT_CLOUD_POINT_SPHERE);
     default_point_resolution = HdCyclesEnvValue<int>("HD_CYCLES_DEFAULT_POINT_RESOLUTION", 16);
 
+    checkpoint_path = HdCyclesEnvValue<std::string>("HD_CYCLES_CHECKPOINT_PATH", "");
+    checkpoint_interval = HdCyclesEnvValue<float>("HD_CYCLES_CHECKPOINT_INTERVAL", 300.0f);
+
     texture_use_cache = HdCyclesEnvValue<bool>("HD_BLACKBIRD_TEXTURE_USE_CACHE", false);
     texture_cache_size = HdCyclesEnvValue<int>("HD_BLACKBIRD_TEXTURE_CACHE_SIZE", 4096);
     texture_tile_size = HdCyclesEnvValue<int>("HD_BLACKBIRD_TEXTURE_TILE_SIZE", 64);
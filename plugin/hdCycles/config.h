@@ -155,6 +155,13 @@ public:
      */
     HdCyclesEnvValue<int> max_subdivision;
 
+    /**
+     * @brief Evaluator used for subdivision primvar refinement (CPU, TBB)
+     * CPU is single threaded, TBB evaluates stencils in parallel
+     * 
+     */
+    HdCyclesEnvValue<std::string> subdivision_evaluator;
+
     /**
      * @brief Enable dpeth of field for cycles
      * 
@@ -204,6 +211,19 @@ public:
      */
     HdCyclesEnvValue<int> default_point_resolution;
 
+    /**
+     * @brief Checkpoint file of progressive renders, the render resumes from it if it exists.
+     * Empty disables checkpoints
+     *
+     */
+    HdCyclesEnvValue<std::string> checkpoint_path;
+
+    /**
+     * @brief Seconds between checkpoints
+     *
+     */
+    HdCyclesEnvValue<float> checkpoint_interval;
+
     /* ======= Cycles Settings ======= */
 
     /**
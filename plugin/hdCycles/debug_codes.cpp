@@ -30,6 +30,8 @@ TF_REGISTRY_FUNCTION(TfDebug)
 {
     TF_DEBUG_ENVIRONMENT_SYMBOL(
         HDCYCLES_MESH, "Print warnings when syncing cycles meshes");
+    TF_DEBUG_ENVIRONMENT_SYMBOL(
+        HDCYCLES_SYNC_TIMINGS, "Print per stage timings when syncing rprims");
 }
 
 PXR_NAMESPACE_CLOSE_SCOPE
\ No newline at end of file
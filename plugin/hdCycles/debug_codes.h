@@ -31,7 +31,8 @@ PXR_NAMESPACE_OPEN_SCOPE
 
 // clang-format off
 TF_DEBUG_CODES(
-	HDCYCLES_MESH
+	HDCYCLES_MESH,
+	HDCYCLES_SYNC_TIMINGS
 )
 // clang-format on
 
@@ -0,0 +1,256 @@
+//  Copyright 2020 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include "instanceArray.h"
+
+#include "renderParam.h"
+#include "transformSource.h"
+#include "utils.h"
+
+#include <render/scene.h>
+#include <util/util_hash.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Instances per task, writing a Cycles object is cheap
+constexpr size_t HdCyclesInstanceGrainSize = 1024;
+
+template<typename F>
+void
+ParallelForInstances(size_t size, F&& func)
+{
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, size, HdCyclesInstanceGrainSize),
+                      [&func](const tbb::blocked_range<size_t>& r) {
+                          for (size_t i = r.begin(); i < r.end(); ++i) {
+                              func(i);
+                          }
+                      });
+}
+
+}  // namespace
+
+HdCyclesInstanceArray::HdCyclesInstanceArray(HdCyclesRenderParam* renderParam)
+    : m_renderParam(renderParam)
+    , m_numMotionSteps(0)
+    , m_objectsInScene(false)
+    , m_namesDirty(false)
+{
+}
+
+HdCyclesInstanceArray::~HdCyclesInstanceArray() { Clear(); }
+
+void
+HdCyclesInstanceArray::Resize(size_t size)
+{
+    m_transforms.resize(size, ccl::transform_identity());
+    m_visibility.resize(size, 0);
+    m_colors.resize(size, ccl::make_float3(0.0f, 0.0f, 0.0f));
+    m_randomIds.resize(size, 0);
+}
+
+void
+HdCyclesInstanceArray::SetTransforms(
+    const HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>& instanceTransforms,
+    const HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>& prototypeTransforms,
+    const ccl::Transform& objectTransform, unsigned int motionSteps)
+{
+    const size_t size = (instanceTransforms.count > 0) ? instanceTransforms.values[0].size() : 0;
+    Resize(size);
+    m_motion.clear();
+    m_numMotionSteps = 0;
+    if (size == 0) {
+        return;
+    }
+
+    const bool hasPrototypeTransform = prototypeTransforms.count > 1
+                                       || (prototypeTransforms.count == 1
+                                           && prototypeTransforms.values[0] != GfMatrix4d(1));
+
+    // Combined transforms of all instances at one time sample, the prototype transform is resampled once
+    auto combineSample = [&](size_t sample, ccl::Transform* transforms) {
+        const GfMatrix4d prototypeTransform = hasPrototypeTransform
+                                                  ? prototypeTransforms.Resample(instanceTransforms.times[sample])
+                                                  : GfMatrix4d(1);
+        const VtMatrix4dArray& sampleTransforms = instanceTransforms.values[sample];
+        ParallelForInstances(size, [&](size_t i) {
+            const GfMatrix4d& instanceTransform = sampleTransforms[i];
+            const GfMatrix4d transform = hasPrototypeTransform ? prototypeTransform * instanceTransform
+                                                               : instanceTransform;
+            transforms[i] = mat4d_to_transform(transform) * objectTransform;
+        });
+    };
+
+    // Frame centered motion blur only, all samples must cover every instance
+    const auto numSamples = static_cast<unsigned int>(instanceTransforms.count);
+    bool useMotion = motionSteps > 1 && numSamples > 1;
+    if (useMotion) {
+        const float shutterOpen = instanceTransforms.times[0];
+        const float shutterClose = instanceTransforms.times[numSamples - 1];
+        useMotion = std::abs(std::abs(shutterClose) - std::abs(shutterOpen)) <= 1e-5f;
+        for (unsigned int i = 0; i < numSamples && useMotion; ++i) {
+            useMotion = instanceTransforms.values[i].size() == size;
+        }
+    }
+
+    if (!useMotion) {
+        combineSample(0, m_transforms.data());
+        return;
+    }
+
+    // Input samples are combined sample major, then resampled for all instances in one batch
+    std::vector<ccl::Transform> samples(numSamples * size);
+    for (unsigned int i = 0; i < numSamples; ++i) {
+        combineSample(i, samples.data() + i * size);
+    }
+
+    const HdCyclesResampleWeightArray weights
+        = HdCyclesTransformSource::ComputeResampleWeights(instanceTransforms.times.data(), numSamples, motionSteps);
+    m_numMotionSteps = static_cast<unsigned int>(weights.count);
+    m_motion.resize(m_numMotionSteps * size);
+    HdCyclesTransformSource::ResampleUniform(weights, samples.data(), size, m_motion.data());
+
+    // Center step is the object transform, used where motion is ignored
+    const ccl::Transform* center = m_motion.data() + (m_numMotionSteps / 2) * size;
+    std::copy_n(center, size, m_transforms.data());
+}
+
+void
+HdCyclesInstanceArray::SetVisibility(unsigned int visibility)
+{
+    std::fill(m_visibility.begin(), m_visibility.end(), visibility);
+}
+
+void
+HdCyclesInstanceArray::SetColors(const VtVec3fArray& colors, const ccl::float3& fallback)
+{
+    if (colors.size() != m_colors.size()) {
+        std::fill(m_colors.begin(), m_colors.end(), fallback);
+        return;
+    }
+
+    ParallelForInstances(m_colors.size(), [&](size_t i) {
+        const GfVec3f& color = colors[i];
+        m_colors[i] = ccl::make_float3(color[0], color[1], color[2]);
+    });
+}
+
+void
+HdCyclesInstanceArray::SetInstancerId(const SdfPath& instancerId)
+{
+    if (instancerId != m_instancerId) {
+        m_instancerId = instancerId;
+        m_namesDirty = true;
+    }
+
+    const ccl::uint seed = ccl::hash_string(m_instancerId.GetText());
+    ParallelForInstances(m_randomIds.size(), [&](size_t i) {
+        m_randomIds[i] = ccl::hash_uint2(seed, static_cast<ccl::uint>(i));
+    });
+}
+
+void
+HdCyclesInstanceArray::Commit(ccl::Scene* scene, ccl::Geometry* geometry, const ccl::Object& prototype)
+{
+    // Objects are only reallocated when the number of instances changes, otherwise they are rewritten in place
+    const bool reallocate = m_objects.size() != m_transforms.size();
+    if (reallocate) {
+        if (m_objectsInScene) {
+            m_renderParam->RemoveObjectArray(m_objects);
+            m_objectsInScene = false;
+        }
+
+        std::vector<ccl::Object> objects(m_transforms.size());
+        m_objects.swap(objects);
+        m_namesDirty = true;
+    }
+
+    if (m_objects.empty()) {
+        return;
+    }
+
+    const bool writeNames = m_namesDirty;
+    const std::string& instancerPath = m_instancerId.GetString();
+    ParallelForInstances(m_objects.size(), [&](size_t i) {
+        ccl::Object& object = m_objects[i];
+        object.tfm = m_transforms[i];
+        object.geometry = geometry;
+        object.pass_id = -1;
+        object.visibility = m_visibility[i];
+        object.color = m_colors[i];
+        object.random_id = m_randomIds[i];
+        object.lightgroup = prototype.lightgroup;
+        object.velocity_scale = prototype.velocity_scale;
+
+        // Motion is skipped for instances that do not move
+        bool isStatic = true;
+        for (unsigned int step = 0; step < m_numMotionSteps && isStatic; ++step) {
+            isStatic = m_motion[step * m_objects.size() + i] == m_transforms[i];
+        }
+
+        object.motion.resize(isStatic ? 0 : m_numMotionSteps);
+        for (unsigned int step = 0; step < object.motion.size(); ++step) {
+            object.motion[step] = m_motion[step * m_objects.size() + i];
+        }
+
+        if (writeNames) {
+            object.asset_name = ccl::ustring(instancerPath + "/" + std::to_string(i));
+        }
+    });
+    m_namesDirty = false;
+
+    if (reallocate) {
+        m_renderParam->AddObjectArray(m_objects);
+        m_objectsInScene = true;
+    } else {
+        // Tags the object manager, all objects are uploaded again
+        m_objects.front().tag_update(scene);
+    }
+}
+
+void
+HdCyclesInstanceArray::Clear()
+{
+    if (m_objectsInScene) {
+        m_renderParam->RemoveObjectArray(m_objects);
+        m_objectsInScene = false;
+    }
+
+    std::vector<ccl::Object> objects;
+    m_objects.swap(objects);
+
+    Resize(0);
+    m_motion.clear();
+    m_numMotionSteps = 0;
+    m_transforms.shrink_to_fit();
+    m_motion.shrink_to_fit();
+    m_visibility.shrink_to_fit();
+    m_colors.shrink_to_fit();
+    m_randomIds.shrink_to_fit();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,140 @@
+//  Copyright 2020 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#ifndef HD_CYCLES_INSTANCE_ARRAY_H
+#define HD_CYCLES_INSTANCE_ARRAY_H
+
+#include "api.h"
+#include "hdcycles.h"
+
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/imaging/hd/timeSampleArray.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/sdf/path.h>
+
+#include <render/object.h>
+#include <util/util_transform.h>
+
+#include <vector>
+
+namespace ccl {
+class Geometry;
+class Scene;
+}  // namespace ccl
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+class HdCyclesRenderParam;
+
+/**
+ * @brief Point instances of a single prototype.
+ * Per instance data is kept in SoA arrays, only the transform, visibility, color and random id are stored.
+ * Cycles objects are allocated in one block, added to the scene in bulk and rewritten from the arrays
+ * when the instancer changes. They are only reallocated when the number of instances changes.
+ *
+ */
+class HdCyclesInstanceArray {
+public:
+    explicit HdCyclesInstanceArray(HdCyclesRenderParam* renderParam);
+    ~HdCyclesInstanceArray();
+
+    HdCyclesInstanceArray(const HdCyclesInstanceArray&) = delete;
+    HdCyclesInstanceArray& operator=(const HdCyclesInstanceArray&) = delete;
+
+    size_t GetSize() const { return m_transforms.size(); }
+    bool IsEmpty() const { return m_transforms.empty(); }
+
+    /**
+     * @brief Resize the instance arrays, new instances are invisible until the arrays are set
+     *
+     * @param size Number of instances
+     */
+    void Resize(size_t size);
+
+    /**
+     * @brief Set instance transforms from the instancer, combined with the prototype transforms
+     *
+     * @param instanceTransforms Instancer transforms of this prototype
+     * @param prototypeTransforms Prototype transform samples, applied before the instance transform
+     * @param objectTransform Prototype object transform, applied after the instance transform
+     * @param motionSteps Number of motion transforms per instance, 0 disables motion blur
+     */
+    void SetTransforms(const HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>& instanceTransforms,
+                       const HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>& prototypeTransforms,
+                       const ccl::Transform& objectTransform, unsigned int motionSteps = 0);
+
+    /**
+     * @brief Set the same visibility for all instances
+     *
+     */
+    void SetVisibility(unsigned int visibility);
+
+    /**
+     * @brief Set instance colors, instances without a value keep the fallback color
+     *
+     * @param colors Per instance colors, ignored if the size doesn't match
+     * @param fallback Color of the prototype
+     */
+    void SetColors(const VtVec3fArray& colors, const ccl::float3& fallback);
+
+    /**
+     * @brief Set the random id of every instance from the instancer path and the instance index
+     *
+     */
+    void SetInstancerId(const SdfPath& instancerId);
+
+    /**
+     * @brief Write the arrays to the Cycles objects and add them to the scene if they were reallocated.
+     * Must be called under the scene lock
+     *
+     * @param scene Cycles scene
+     * @param geometry Geometry of the prototype
+     * @param prototype Object settings shared by all instances are copied from it
+     */
+    void Commit(ccl::Scene* scene, ccl::Geometry* geometry, const ccl::Object& prototype);
+
+    /**
+     * @brief Remove all instances from the scene and release the arrays
+     *
+     */
+    void Clear();
+
+private:
+    HdCyclesRenderParam* m_renderParam;
+
+    std::vector<ccl::Transform> m_transforms;
+    // Uniformly resampled motion transforms, laid out as m_motion[step * size + instance]
+    std::vector<ccl::Transform> m_motion;
+    unsigned int m_numMotionSteps;
+    std::vector<unsigned int> m_visibility;
+    std::vector<ccl::float3> m_colors;
+    std::vector<unsigned int> m_randomIds;
+
+    SdfPath m_instancerId;
+
+    // Cycles objects, allocated once per number of instances
+    std::vector<ccl::Object> m_objects;
+    bool m_objectsInScene;
+    bool m_namesDirty;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif  // HD_CYCLES_INSTANCE_ARRAY_H
@@ -25,6 +25,11 @@
 #include <pxr/base/gf/rotation.h>
 #include <pxr/imaging/hd/sceneDelegate.h>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+
 PXR_NAMESPACE_OPEN_SCOPE
 
 // TODO: Use HdInstancerTokens when Houdini updates USD to 20.02
@@ -47,19 +52,21 @@ HdCyclesInstancer::Sync()
     const SdfPath& instancerId = GetId();
     auto& changeTracker = GetDelegate()->GetRenderIndex().GetChangeTracker();
 
-    // Use the double-checked locking pattern to check if this instancer's
-    // primvars are dirty.
-    int dirtyBits = changeTracker.GetInstancerDirtyBits(instancerId);
-    if (!HdChangeTracker::IsAnyPrimvarDirty(dirtyBits, instancerId)) {
+    // Use the double-checked locking pattern to check if this instancer is dirty
+    HdDirtyBits dirtyBits = changeTracker.GetInstancerDirtyBits(instancerId);
+    if (dirtyBits == HdChangeTracker::Clean) {
         return;
     }
 
     std::lock_guard<std::mutex> lock(m_syncMutex);
     dirtyBits = changeTracker.GetInstancerDirtyBits(instancerId);
-    if (!HdChangeTracker::IsAnyPrimvarDirty(dirtyBits, instancerId)) {
+    if (dirtyBits == HdChangeTracker::Clean) {
         return;
     }
 
+    // Primvars, instancer transform or instance indices changed
+    m_transformsDirty = true;
+
     auto primvarDescs = GetDelegate()->GetPrimvarDescriptors(instancerId, HdInterpolationInstance);
     for (auto& desc : primvarDescs) {
         if (!HdChangeTracker::IsPrimvarDirty(dirtyBits, instancerId, desc.name)) {
@@ -158,10 +165,25 @@ AccumulateSampleTimes(HdTimeSampleArray<T1, C> const& in, HdTimeSampleArray<T2,
     }
 }
 
-// Apply transforms referenced by instanceIndices
+// Instances per composition task
+constexpr size_t HdCyclesInstanceGrainSize = 1024;
+
+template<typename F>
+void
+ParallelForInstances(size_t numInstances, F&& func)
+{
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, numInstances, HdCyclesInstanceGrainSize),
+                      [&func](const tbb::blocked_range<size_t>& r) {
+                          for (size_t i = r.begin(); i < r.end(); ++i) {
+                              func(i);
+                          }
+                      });
+}
+
+// Apply transforms to all instances, instances past the end of the primvar are kept
 template<typename Op, typename T>
 void
-ApplyTransform(VtValue const& allTransformsValue, VtIntArray const& instanceIndices, GfMatrix4d* transforms)
+ApplyTransform(VtValue const& allTransformsValue, size_t numInstances, GfMatrix4d* transforms)
 {
     auto& allTransforms = allTransformsValue.Get<VtArray<T>>();
     if (allTransforms.empty()) {
@@ -169,16 +191,15 @@ ApplyTransform(VtValue const& allTransformsValue, VtIntArray const& instanceIndi
         return;
     }
 
-    for (size_t i = 0; i < instanceIndices.size(); ++i) {
-        transforms[i] = Op {}(allTransforms[instanceIndices[i]]) * transforms[i];
-    }
+    ParallelForInstances(std::min(numInstances, allTransforms.size()),
+                         [&](size_t i) { transforms[i] = Op {}(allTransforms[i]) * transforms[i]; });
 }
 
-// Apply interpolated transforms referenced by instanceIndices
+// Apply interpolated transforms to all instances
 template<typename Op, typename T>
 void
 ApplyTransform(float alpha, VtValue const& allTransformsValue0, VtValue const& allTransformsValue1,
-               VtIntArray const& instanceIndices, GfMatrix4d* transforms)
+               size_t numInstances, GfMatrix4d* transforms)
 {
     auto& allTransforms0 = allTransformsValue0.Get<VtArray<T>>();
     auto& allTransforms1 = allTransformsValue1.Get<VtArray<T>>();
@@ -187,17 +208,17 @@ ApplyTransform(float alpha, VtValue const& allTransformsValue0, VtValue const& a
         return;
     }
 
-    for (size_t i = 0; i < instanceIndices.size(); ++i) {
-        auto transform = HdResampleNeighbors(alpha, allTransforms0[instanceIndices[i]],
-                                             allTransforms1[instanceIndices[i]]);
+    const size_t size = std::min(numInstances, std::min(allTransforms0.size(), allTransforms1.size()));
+    ParallelForInstances(size, [&](size_t i) {
+        auto transform = HdResampleNeighbors(alpha, allTransforms0[i], allTransforms1[i]);
         transforms[i] = Op {}(transform)*transforms[i];
-    }
+    });
 }
 
 template<typename Op, typename T>
 void
-ApplyTransform(HdTimeSampleArray<VtValue, HD_CYCLES_MOTION_STEPS> const& samples, VtIntArray const& instanceIndices,
-               float time, GfMatrix4d* transforms)
+ApplyTransform(HdTimeSampleArray<VtValue, HD_CYCLES_MOTION_STEPS> const& samples, size_t numInstances, float time,
+               GfMatrix4d* transforms)
 {
     using size_type = typename decltype(samples.values)::size_type;
 
@@ -205,7 +226,7 @@ ApplyTransform(HdTimeSampleArray<VtValue, HD_CYCLES_MOTION_STEPS> const& samples
     for (; i < samples.count; ++i) {
         if (samples.times[i] == time) {
             // Exact time match
-            return ApplyTransform<Op, T>(samples.values[i], instanceIndices, transforms);
+            return ApplyTransform<Op, T>(samples.values[i], numInstances, transforms);
         }
         if (samples.times[i] > time) {
             break;
@@ -214,21 +235,32 @@ ApplyTransform(HdTimeSampleArray<VtValue, HD_CYCLES_MOTION_STEPS> const& samples
 
     if (i == 0) {
         // time is before the first sample.
-        return ApplyTransform<Op, T>(samples.values[0], instanceIndices, transforms);
+        return ApplyTransform<Op, T>(samples.values[0], numInstances, transforms);
     } else if (i == samples.count) {
         // time is after the last sample.
-        return ApplyTransform<Op, T>(samples.values[static_cast<size_type>(samples.count) - 1], instanceIndices,
+        return ApplyTransform<Op, T>(samples.values[static_cast<size_type>(samples.count) - 1], numInstances,
                                      transforms);
     } else if (samples.times[i] == samples.times[i - 1]) {
         // Neighboring samples have identical parameter.
         // Arbitrarily choose a sample.
         TF_WARN("overlapping samples at %f; using first sample", samples.times[i]);
-        return ApplyTransform<Op, T>(samples.values[i - 1], instanceIndices, transforms);
+        return ApplyTransform<Op, T>(samples.values[i - 1], numInstances, transforms);
     } else {
         // Linear blend of neighboring samples.
         float alpha = (samples.times[i] - time) / (samples.times[i] - samples.times[i - 1]);
-        return ApplyTransform<Op, T>(alpha, samples.values[i - 1], samples.values[i], instanceIndices, transforms);
+        return ApplyTransform<Op, T>(alpha, samples.values[i - 1], samples.values[i], numInstances, transforms);
+    }
+}
+
+// Number of instances of the largest primvar
+size_t
+GetNumInstances(HdTimeSampleArray<VtValue, HD_CYCLES_MOTION_STEPS> const& samples)
+{
+    size_t numInstances = 0;
+    for (size_t i = 0; i < samples.count; ++i) {
+        numInstances = std::max(numInstances, samples.values[i].GetArraySize());
     }
+    return numInstances;
 }
 
 struct TranslateOp {
@@ -257,15 +289,14 @@ struct TransformOp {
 
 }  // namespace
 
-HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>
-HdCyclesInstancer::SampleInstanceTransforms(SdfPath const& prototypeId)
+void
+HdCyclesInstancer::_SampleLocalTransforms(HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>& sa,
+                                          HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>& instancerXform,
+                                          size_t& numInstances)
 {
     HdSceneDelegate* delegate = GetDelegate();
     const SdfPath& instancerId = GetId();
 
-    VtIntArray instanceIndices = delegate->GetInstanceIndices(instancerId, prototypeId);
-
-    HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS> instancerXform;
     HdTimeSampleArray<VtValue, HD_CYCLES_MOTION_STEPS> instanceXforms;
     HdTimeSampleArray<VtValue, HD_CYCLES_MOTION_STEPS> translates;
     HdTimeSampleArray<VtValue, HD_CYCLES_MOTION_STEPS> rotates;
@@ -276,6 +307,9 @@ HdCyclesInstancer::SampleInstanceTransforms(SdfPath const& prototypeId)
     delegate->SamplePrimvar(instancerId, _tokens->scale, &scales);
     delegate->SamplePrimvar(instancerId, _tokens->rotate, &rotates);
 
+    numInstances = std::max({ GetNumInstances(instanceXforms), GetNumInstances(translates), GetNumInstances(scales),
+                              GetNumInstances(rotates) });
+
     using size_type = typename decltype(instancerXform.values)::size_type;
 
     // Hydra might give us falsely varying instancerXform, i.e. more than one time sample with the sample matrix
@@ -296,7 +330,6 @@ HdCyclesInstancer::SampleInstanceTransforms(SdfPath const& prototypeId)
     // As a simple resampling strategy, find the input with the max #
     // of samples and use its sample placement.  In practice we expect
     // them to all be the same, i.e. to not require resampling.
-    HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> sa;
     sa.Resize(0);
     AccumulateSampleTimes(instancerXform, &sa);
     AccumulateSampleTimes(instanceXforms, &sa);
@@ -313,90 +346,173 @@ HdCyclesInstancer::SampleInstanceTransforms(SdfPath const& prototypeId)
         }
 
         auto& transforms = sa.values[i];
-        transforms = VtMatrix4dArray(instanceIndices.size(), xf);
+        transforms = VtMatrix4dArray(numInstances, xf);
 
         if (translates.count > 0 && translates.values[0].IsArrayValued()) {
             auto& type = translates.values[0].GetElementTypeid();
             if (type == typeid(GfVec3f)) {
-                ApplyTransform<TranslateOp, GfVec3f>(translates, instanceIndices, t, transforms.data());
+                ApplyTransform<TranslateOp, GfVec3f>(translates, numInstances, t, transforms.data());
             } else if (type == typeid(GfVec3d)) {
-                ApplyTransform<TranslateOp, GfVec3d>(translates, instanceIndices, t, transforms.data());
+                ApplyTransform<TranslateOp, GfVec3d>(translates, numInstances, t, transforms.data());
             } else if (type == typeid(GfVec3h)) {
-                ApplyTransform<TranslateOp, GfVec3h>(translates, instanceIndices, t, transforms.data());
+                ApplyTransform<TranslateOp, GfVec3h>(translates, numInstances, t, transforms.data());
             }
         }
 
         if (rotates.count > 0 && rotates.values[0].IsArrayValued()) {
             auto& type = rotates.values[0].GetElementTypeid();
             if (type == typeid(GfQuath)) {
-                ApplyTransform<RotateOp, GfQuath>(rotates, instanceIndices, t, transforms.data());
+                ApplyTransform<RotateOp, GfQuath>(rotates, numInstances, t, transforms.data());
             } else if (type == typeid(GfQuatf)) {
-                ApplyTransform<RotateOp, GfQuatf>(rotates, instanceIndices, t, transforms.data());
+                ApplyTransform<RotateOp, GfQuatf>(rotates, numInstances, t, transforms.data());
             } else if (type == typeid(GfQuatd)) {
-                ApplyTransform<RotateOp, GfQuatd>(rotates, instanceIndices, t, transforms.data());
+                ApplyTransform<RotateOp, GfQuatd>(rotates, numInstances, t, transforms.data());
             }
         }
 
         if (scales.count > 0 && scales.values[0].IsArrayValued()) {
             auto& type = scales.values[0].GetElementTypeid();
             if (type == typeid(GfVec3f)) {
-                ApplyTransform<ScaleOp, GfVec3f>(scales, instanceIndices, t, transforms.data());
+                ApplyTransform<ScaleOp, GfVec3f>(scales, numInstances, t, transforms.data());
             } else if (type == typeid(GfVec3d)) {
-                ApplyTransform<ScaleOp, GfVec3d>(scales, instanceIndices, t, transforms.data());
+                ApplyTransform<ScaleOp, GfVec3d>(scales, numInstances, t, transforms.data());
             } else if (type == typeid(GfVec3h)) {
-                ApplyTransform<ScaleOp, GfVec3h>(scales, instanceIndices, t, transforms.data());
+                ApplyTransform<ScaleOp, GfVec3h>(scales, numInstances, t, transforms.data());
             }
         }
 
         if (instanceXforms.count > 0 && instanceXforms.values[0].IsArrayValued()) {
             auto& type = instanceXforms.values[0].GetElementTypeid();
             if (type == typeid(GfMatrix4d)) {
-                ApplyTransform<TransformOp, GfMatrix4d>(instanceXforms, instanceIndices, t, transforms.data());
+                ApplyTransform<TransformOp, GfMatrix4d>(instanceXforms, numInstances, t, transforms.data());
             } else if (type == typeid(GfMatrix4f)) {
-                ApplyTransform<TransformOp, GfMatrix4f>(instanceXforms, instanceIndices, t, transforms.data());
+                ApplyTransform<TransformOp, GfMatrix4f>(instanceXforms, numInstances, t, transforms.data());
             }
         }
     }
+}
+
+HdCyclesInstancer::TransformCache
+HdCyclesInstancer::_GetTransformCache()
+{
+    Sync();
 
-    // If there is a parent instancer, continue to unroll
-    // the child instances across the parent; otherwise we're done.
-    if (GetParentId().IsEmpty()) {
-        return sa;
+    // Parent transforms of this instancer, the parent cache is updated first
+    HdCyclesInstancer* parentInstancer = nullptr;
+    TransformCache parentCache;
+    if (!GetParentId().IsEmpty()) {
+        HdInstancer* instancer = GetDelegate()->GetRenderIndex().GetInstancer(GetParentId());
+        if (TF_VERIFY(instancer)) {
+            parentInstancer = static_cast<HdCyclesInstancer*>(instancer);
+            parentCache = parentInstancer->_GetTransformCache();
+        }
     }
 
-    HdInstancer* parentInstancer = GetDelegate()->GetRenderIndex().GetInstancer(GetParentId());
-    if (!TF_VERIFY(parentInstancer)) {
-        return sa;
+    std::lock_guard<std::mutex> lock(m_syncMutex);
+    if (!m_transformsDirty && parentCache.version == m_parentVersion) {
+        return m_transformCache;
     }
-    auto cyclesParentInstancer = static_cast<HdCyclesInstancer*>(parentInstancer);
 
-    // Multiply the instance samples against the parent instancer samples.
-    auto parentXf = cyclesParentInstancer->SampleInstanceTransforms(GetId());
-    if (parentXf.count == 0 || parentXf.values[0].empty()) {
-        // No samples for parent instancer.
-        return sa;
+    HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> sa;
+    HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS> instancerXform;
+    size_t numInstances = 0;
+    _SampleLocalTransforms(sa, instancerXform, numInstances);
+
+    TransformCache cache;
+    cache.numInstances = numInstances;
+    cache.version = m_transformCache.version + 1;
+
+    // If there is a parent instancer, flatten the instances across the parent instances once
+    HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> parentXf;
+    if (parentInstancer) {
+        VtIntArray parentIndices = GetDelegate()->GetInstanceIndices(GetParentId(), GetId());
+        parentXf = _GatherTransforms(parentCache, parentIndices);
     }
-    // Move aside previously computed child xform samples to childXf.
-    HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> childXf(sa);
-    // Merge sample times, taking the densest sampling.
-    AccumulateSampleTimes(parentXf, &sa);
-    // Apply parent xforms to the children.
-    for (size_type i = 0; i < sa.count; ++i) {
-        const float t = sa.times[i];
-        // Resample transforms at the same time.
-        VtMatrix4dArray curParentXf = parentXf.Resample(t);
-        VtMatrix4dArray curChildXf = childXf.Resample(t);
-        // Multiply out each combination.
-        VtMatrix4dArray& result = sa.values[i];
-        result.resize(curParentXf.size() * curChildXf.size());
-        for (size_t j = 0; j < curParentXf.size(); ++j) {
-            for (size_t k = 0; k < curChildXf.size(); ++k) {
-                result[j * curChildXf.size() + k] = curChildXf[k] * curParentXf[j];
+
+    if (parentXf.count == 0 || parentXf.values[0].empty()) {
+        // No parent instancer or no samples for it
+        cache.transforms = sa;
+        cache.fallbacks.Resize(static_cast<unsigned int>(sa.count));
+        for (size_t i = 0; i < sa.count; ++i) {
+            cache.fallbacks.times[i] = sa.times[i];
+            GfMatrix4d xf = instancerXform.count > 0 ? instancerXform.Resample(sa.times[i]) : GfMatrix4d(1);
+            cache.fallbacks.values[i] = VtMatrix4dArray(1, xf);
+        }
+    } else {
+        // Merge sample times, taking the densest sampling.
+        cache.transforms = sa;
+        AccumulateSampleTimes(parentXf, &cache.transforms);
+        cache.fallbacks.Resize(static_cast<unsigned int>(cache.transforms.count));
+
+        // Apply parent xforms to the children.
+        for (size_t i = 0; i < cache.transforms.count; ++i) {
+            const float t = cache.transforms.times[i];
+            // Resample transforms at the same time.
+            const VtMatrix4dArray curParentXf = parentXf.Resample(t);
+            const VtMatrix4dArray curChildXf = sa.count > 0 ? sa.Resample(t) : VtMatrix4dArray {};
+            const GfMatrix4d xf = instancerXform.count > 0 ? instancerXform.Resample(t) : GfMatrix4d(1);
+
+            // Multiply out each combination.
+            VtMatrix4dArray& result = cache.transforms.values[i];
+            result.resize(curParentXf.size() * numInstances);
+            GfMatrix4d* resultData = result.data();
+            ParallelForInstances(result.size(), [&](size_t j) {
+                resultData[j] = curChildXf[j % numInstances] * curParentXf[j / numInstances];
+            });
+
+            VtMatrix4dArray& fallback = cache.fallbacks.values[i];
+            fallback.resize(curParentXf.size());
+            for (size_t j = 0; j < curParentXf.size(); ++j) {
+                fallback[j] = xf * curParentXf[j];
             }
+            cache.fallbacks.times[i] = t;
         }
     }
 
+    m_transformCache = std::move(cache);
+    m_transformsDirty = false;
+    m_parentVersion = parentCache.version;
+    return m_transformCache;
+}
+
+HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>
+HdCyclesInstancer::_GatherTransforms(const TransformCache& cache, const VtIntArray& indices)
+{
+    HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> sa;
+    sa.Resize(static_cast<unsigned int>(cache.transforms.count));
+
+    const size_t numIndices = indices.size();
+    const size_t numInstances = cache.numInstances;
+    for (size_t i = 0; i < cache.transforms.count; ++i) {
+        sa.times[i] = cache.transforms.times[i];
+
+        // One copy of the prototype instances per parent instance
+        const VtMatrix4dArray& fallbacks = cache.fallbacks.values[i];
+        const GfMatrix4d* transforms = cache.transforms.values[i].cdata();
+        const int* indexData = indices.cdata();
+
+        VtMatrix4dArray& result = sa.values[i];
+        result.resize(fallbacks.size() * numIndices);
+        GfMatrix4d* resultData = result.data();
+        ParallelForInstances(result.size(), [&](size_t j) {
+            const size_t parent = j / numIndices;
+            const int index = indexData[j % numIndices];
+            resultData[j] = (index >= 0 && static_cast<size_t>(index) < numInstances)
+                                ? transforms[parent * numInstances + static_cast<size_t>(index)]
+                                : fallbacks[parent];
+        });
+    }
+
     return sa;
 }
 
+HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>
+HdCyclesInstancer::SampleInstanceTransforms(SdfPath const& prototypeId)
+{
+    // Cache is shared by all prototypes of the instancer, each of them only gathers its instances
+    const TransformCache cache = _GetTransformCache();
+    const VtIntArray instanceIndices = GetDelegate()->GetInstanceIndices(GetId(), prototypeId);
+    return _GatherTransforms(cache, instanceIndices);
+}
+
 PXR_NAMESPACE_CLOSE_SCOPE
\ No newline at end of file
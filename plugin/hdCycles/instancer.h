@@ -39,6 +39,9 @@ class HdSceneDelegate;
  * @brief Properly computes instance transforms for time varying data
  * Heavily inspired by ReadeonProRenderUSD's Instancer.cpp 
  * 
+ * Transforms of all instances are composed once per change of the instancer and flattened over
+ * the parent instancers, prototypes only gather them by their instance indices.
+ * 
  */
 class HdCyclesInstancer : public HdInstancer {
 public:
@@ -49,17 +52,58 @@ public:
 
     VtMatrix4dArray ComputeTransforms(SdfPath const& prototypeId);
 
+    /**
+     * @brief Sample the world transforms of the prototype instances
+     * 
+     * @param prototypeId Prototype using this instancer
+     * @return Transforms per time sample, instances of nested instancers are ordered by parent instance first
+     */
     HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> SampleInstanceTransforms(SdfPath const& prototypeId);
 
 private:
     void Sync();
 
+    struct TransformCache {
+        // Transforms of all instances flattened over the parent instances, parent instance major
+        HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> transforms;
+        // Instancer transform of each parent instance, used by instance indices without primvar values
+        HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> fallbacks;
+        size_t numInstances = 0;
+        size_t version = 0;
+    };
+
+    /**
+     * @brief Get the transform cache, recomputed if the instancer or one of its parents changed
+     * 
+     */
+    TransformCache _GetTransformCache();
+
+    /**
+     * @brief Compose the transforms of all instances of this instancer
+     * 
+     */
+    void _SampleLocalTransforms(HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS>& transforms,
+                                HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS>& instancerTransform,
+                                size_t& numInstances);
+
+    /**
+     * @brief Gather the cached transforms by instance index
+     * 
+     */
+    static HdTimeSampleArray<VtMatrix4dArray, HD_CYCLES_MOTION_STEPS> _GatherTransforms(const TransformCache& cache,
+                                                                                      const VtIntArray& indices);
+
     VtMatrix4dArray m_transform;
     VtVec3fArray m_translate;
     VtVec4fArray m_rotate;
     VtVec3fArray m_scale;
 
     std::mutex m_syncMutex;
+
+    // Guarded by m_syncMutex
+    TransformCache m_transformCache;
+    bool m_transformsDirty = true;
+    size_t m_parentVersion = 0;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -30,7 +30,9 @@
 #include "transformSource.h"
 #include "utils.h"
 
+#include <pxr/base/tf/stopwatch.h>
 #include <pxr/imaging/hd/extComputationUtils.h>
+#include <pxr/imaging/hd/perfLog.h>
 
 #include <usdCycles/tokens.h>
 
@@ -44,16 +46,44 @@ PXR_NAMESPACE_OPEN_SCOPE
 TF_DEFINE_PRIVATE_TOKENS(_tokens, 
     (st)
     (uv)
+    (primvars)
 );
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
 // clang-format on
 
+namespace {
+
+/// Copy data converted during the fetch stage into the attribute, false if the attribute has a different size
+template<typename T>
+bool
+HdCyclesCopyStagedAttribute(ccl::Attribute* attr, const ccl::array<T>& staged)
+{
+    if (!attr || attr->buffer.size() != staged.size() * sizeof(T)) {
+        return false;
+    }
+
+    std::copy(staged.data(), staged.data() + staged.size(), reinterpret_cast<T*>(attr->data()));
+    return true;
+}
+
+}  // namespace
+
 HdCyclesMesh::HdCyclesMesh(SdfPath const& id, SdfPath const& instancerId, HdCyclesRenderDelegate* a_renderDelegate)
     : HdBbRPrim<HdMesh>(id, instancerId)
     , m_cyclesMesh(nullptr)
+    , m_instances(a_renderDelegate->GetCyclesRenderParam())
+    , m_refineLevel(0)
+    , m_useLimitSurfaceTangents(false)
+    , m_hasAuthoredNormals(false)
     , m_velocityScale(1.0f)
+    , m_staged_motion_steps(0)
+    , m_staged_normals_std(ccl::ATTR_STD_NONE)
+    , m_staged_motion_normals_std(ccl::ATTR_STD_NONE)
+    , m_staged_generate_normals(false)
+    , m_staged_has_display_color(false)
+    , m_staged_display_color(ccl::make_float3(0.0f, 0.0f, 0.0f))
     , m_renderDelegate(a_renderDelegate)
 {
     _InitializeNewCyclesMesh();
@@ -71,17 +101,13 @@ HdCyclesMesh::~HdCyclesMesh()
         delete m_cyclesObject;
     }
 
-    if (m_cyclesInstances.size()) {
-        m_renderDelegate->GetCyclesRenderParam()->RemoveObjectArray(m_cyclesInstances);
-        std::vector<ccl::Object> empty = {};
-        m_cyclesInstances.swap(empty);
-    }
+    m_instances.Clear();
 }
 
 void
-HdCyclesMesh::_AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* scene, HdInterpolation interpolation)
+HdCyclesMesh::_FetchUVSet(const TfToken& name, const VtValue& uvs, HdInterpolation interpolation, bool refined)
 {
-    VtValue uvs_value = uvs;
+    VtValue uvs_value = array_to_float_array(uvs);
 
     if (!uvs_value.IsHolding<VtVec2fArray>()) {
         if (!uvs_value.CanCast<VtVec2fArray>()) {
@@ -92,22 +118,19 @@ HdCyclesMesh::_AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* sce
         uvs_value = uvs_value.Cast<VtVec2fArray>();
     }
 
-    ccl::ustring uv_name = ccl::ustring(name.GetString());
-    bool need_uv = m_cyclesMesh->need_attribute(scene, uv_name)
-                   || m_cyclesMesh->need_attribute(scene, ccl::ATTR_STD_UV);
-    if (!need_uv) {
-        return;
-    }
-
     // To avoid face varying computations we take attribute and we refine it with
     // respecting incoming interpolation. Then we convert it to face varying because
     // ATTR_STD_UV is a face varying data.
 
-    ccl::AttributeSet* attributes = &m_cyclesMesh->attributes;
-    ccl::Attribute* uv_attr = attributes->add(ccl::ATTR_STD_UV, uv_name);
-    auto attrib_data = uv_attr->data_float2();
-
     const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
+    const size_t num_triangles = refiner->GetTriangulatedTopology().GetNumFaces();
+    const size_t num_vertices = refiner->GetTriangulatedTopology().GetNumPoints();
+
+    m_staged_uvs.emplace_back(ccl::ustring(name.GetString()), ccl::array<ccl::float2>());
+    ccl::array<ccl::float2>& staged_uvs = m_staged_uvs.back().second;
+    staged_uvs.resize(num_triangles * 3);
+    std::fill(staged_uvs.data(), staged_uvs.data() + staged_uvs.size(), ccl::make_float2(0.0f, 0.0f));
+    ccl::float2* attrib_data = staged_uvs.data();
 
     if (interpolation == HdInterpolationConstant) {
         VtValue refined_value = refiner->RefineConstantData(name, HdPrimvarRoleTokens->textureCoordinate, uvs_value);
@@ -117,7 +140,7 @@ HdCyclesMesh::_AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* sce
         }
 
         auto refined_uvs = refined_value.UncheckedGet<VtVec2fArray>();
-        for (size_t face = 0, offset = 0; face < refiner->GetTriangulatedTopology().GetNumFaces(); ++face) {
+        for (size_t face = 0, offset = 0; face < num_triangles; ++face) {
             for (size_t i = 0; i < 3; ++i, ++offset) {
                 attrib_data[offset][0] = refined_uvs[0][0];
                 attrib_data[offset][1] = refined_uvs[0][1];
@@ -127,13 +150,13 @@ HdCyclesMesh::_AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* sce
 
     if (interpolation == HdInterpolationUniform) {
         VtValue refined_value = refiner->RefineUniformData(name, HdPrimvarRoleTokens->textureCoordinate, uvs_value);
-        if (refined_value.GetArraySize() != m_cyclesMesh->num_triangles()) {
+        if (refined_value.GetArraySize() != num_triangles) {
             TF_WARN("Failed to refine uniform texture coordinates!");
             return;
         }
 
         auto refined_uvs = refined_value.UncheckedGet<VtVec2fArray>();
-        for (size_t face = 0, offset = 0; face < refiner->GetTriangulatedTopology().GetNumFaces(); ++face) {
+        for (size_t face = 0, offset = 0; face < num_triangles; ++face) {
             for (size_t i = 0; i < 3; ++i, ++offset) {
                 attrib_data[offset][0] = refined_uvs[face][0];
                 attrib_data[offset][1] = refined_uvs[face][1];
@@ -155,8 +178,10 @@ HdCyclesMesh::_AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* sce
     };
 
     if (interpolation == HdInterpolationVertex) {
-        VtValue refined_value = refiner->RefineVertexData(name, HdPrimvarRoleTokens->textureCoordinate, uvs_value);
-        if (refined_value.GetArraySize() != m_cyclesMesh->verts.size()) {
+        VtValue refined_value = refined ? uvs_value
+                                        : refiner->RefineVertexData(name, HdPrimvarRoleTokens->textureCoordinate,
+                                                                    uvs_value);
+        if (refined_value.GetArraySize() != num_vertices) {
             TF_WARN("Failed to refine vertex texture coordinates!");
             return;
         }
@@ -167,7 +192,7 @@ HdCyclesMesh::_AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* sce
 
     if (interpolation == HdInterpolationVarying) {
         VtValue refined_value = refiner->RefineVaryingData(name, HdPrimvarRoleTokens->textureCoordinate, uvs_value);
-        if (refined_value.GetArraySize() != m_cyclesMesh->verts.size()) {
+        if (refined_value.GetArraySize() != num_vertices) {
             TF_WARN("Failed to refine varying texture coordinates!");
             return;
         }
@@ -178,7 +203,7 @@ HdCyclesMesh::_AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* sce
 
     if (interpolation == HdInterpolationFaceVarying) {
         VtValue refined_value = refiner->RefineFaceVaryingData(name, HdPrimvarRoleTokens->textureCoordinate, uvs_value);
-        if (refined_value.GetArraySize() != refiner->GetTriangulatedTopology().GetNumFaces() * 3) {
+        if (refined_value.GetArraySize() != num_triangles * 3) {
             TF_WARN("Invalid number of refined vertices");
             return;
         }
@@ -194,10 +219,49 @@ HdCyclesMesh::_AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* sce
 }
 
 void
-HdCyclesMesh::_PopulateTangents(HdSceneDelegate* sceneDelegate, const SdfPath& id, ccl::Scene* scene)
+HdCyclesMesh::_PublishUVSets(ccl::Scene* scene)
+{
+    for (auto& staged : m_staged_uvs) {
+        const ccl::ustring& uv_name = staged.first;
+        bool need_uv = m_cyclesMesh->need_attribute(scene, uv_name)
+                       || m_cyclesMesh->need_attribute(scene, ccl::ATTR_STD_UV);
+        if (!need_uv) {
+            continue;
+        }
+
+        ccl::Attribute* uv_attr = m_cyclesMesh->attributes.add(ccl::ATTR_STD_UV, uv_name);
+        if (!HdCyclesCopyStagedAttribute(uv_attr, staged.second)) {
+            TF_WARN("Staged texture coordinates %s do not match the mesh", uv_name.c_str());
+        }
+    }
+    m_staged_uvs.clear();
+}
+
+void
+HdCyclesMesh::_FetchTangents()
+{
+    m_staged_limit_tangents.clear();
+
+    // Tangents from the subdivision limit surface do not depend on the cycles mesh, they are per corner
+    const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
+    if (!refiner->IsSubdivided() || !m_useLimitSurfaceTangents || m_texture_names.empty()) {
+        return;
+    }
+
+    const VtIntArray& refined_indices = refiner->GetTriangulatedTopology().GetFaceVertexIndices();
+    m_staged_limit_tangents.resize(refined_indices.size());
+    for (size_t i = 0; i < refined_indices.size(); ++i) {
+        auto vertex_index = static_cast<size_t>(refined_indices[i]);
+        m_staged_limit_tangents[i] = vertex_index < m_limit_us.size() ? ccl::normalize(m_limit_us[vertex_index])
+                                                                      : ccl::make_float3(0.0f, 0.0f, 0.0f);
+    }
+}
+
+void
+HdCyclesMesh::_PublishTangents(ccl::Scene* scene)
 {
-    // Iterate over all uvs and check if tangent is requested, populate primvars must be called before
-    // PopulateTangents
+    // Iterate over all uvs and check if tangent is requested, publish primvars must be called before
+    // PublishTangents
 
     ccl::AttributeSet* attributes = &m_cyclesMesh->attributes;
     const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
@@ -218,11 +282,8 @@ HdCyclesMesh::_PopulateTangents(HdSceneDelegate* sceneDelegate, const SdfPath& i
             // subdivided tangents are per vertex
             if (m_cyclesMesh->need_attribute(scene, ccl::ATTR_STD_UV_TANGENT)) {
                 ccl::Attribute* tangent_attrib = attributes->add(ccl::ATTR_STD_UV_TANGENT, tangent_name);
-                ccl::float3* tangent_data = tangent_attrib->data_float3();
-
-                for (size_t i = 0; i < m_cyclesMesh->triangles.size(); ++i) {
-                    auto vertex_index = m_cyclesMesh->triangles[i];
-                    tangent_data[i] = ccl::normalize(m_limit_us[vertex_index]);
+                if (!HdCyclesCopyStagedAttribute(tangent_attrib, m_staged_limit_tangents)) {
+                    TF_WARN("Staged limit surface tangents do not match the mesh");
                 }
             }
 
@@ -235,11 +296,13 @@ HdCyclesMesh::_PopulateTangents(HdSceneDelegate* sceneDelegate, const SdfPath& i
                 }
             }
         } else {
+            // MikkTSpace works on the published mesh, it can't be staged
             // Forced for now
             bool need_sign = true;
             mikk_compute_tangents(name.c_str(), m_cyclesMesh, need_sign, true);
         }
     }
+    m_staged_limit_tangents.clear();
 }
 
 /*
@@ -279,10 +342,7 @@ HdCyclesMesh::_AddVelocities(const SdfPath& id, const VtValue& value, HdInterpol
     if (interpolation == HdInterpolationVertex) {
         assert(velocities.size() == m_cyclesMesh->verts.size());
 
-        ccl::float3* V = attr_V->data_float3();
-        for (size_t i = 0; i < velocities.size(); ++i) {
-            V[i] = vec3f_to_float3(velocities[i]);
-        }
+        vec3f_to_float3(velocities.cdata(), attr_V->data_float3(), velocities.size());
     } else {
         TF_WARN("Velocity requries per-vertex interpolation for: %s", id.GetText());
     }
@@ -324,20 +384,17 @@ HdCyclesMesh::_AddAccelerations(const SdfPath& id, const VtValue& value, HdInter
     if (interpolation == HdInterpolationVertex) {
         assert(accelerations.size() == m_cyclesMesh->verts.size());
 
-        ccl::float3* A = attr_accel->data_float3();
-        for (size_t i = 0; i < accelerations.size(); ++i) {
-            A[i] = vec3f_to_float3(accelerations[i]);
-        }
+        vec3f_to_float3(accelerations.cdata(), attr_accel->data_float3(), accelerations.size());
     } else {
         TF_WARN("Acceleration requires per-vertex interpolation");
     }
 }
 
 void
-HdCyclesMesh::_PopulateColors(const TfToken& name, const TfToken& role, const VtValue& data, ccl::Scene* scene,
-                              HdInterpolation interpolation, const SdfPath& id)
+HdCyclesMesh::_FetchColors(const TfToken& name, const TfToken& role, const VtValue& data,
+                           HdInterpolation interpolation, const SdfPath& id)
 {
-    VtValue colors_value = data;
+    VtValue colors_value = array_to_float_array(data);
 
     if (!colors_value.IsHolding<VtVec3fArray>()) {
         if (!colors_value.CanCast<VtVec3fArray>()) {
@@ -348,17 +405,6 @@ HdCyclesMesh::_PopulateColors(const TfToken& name, const TfToken& role, const Vt
         colors_value = colors_value.Cast<VtVec3fArray>();
     }
 
-    auto override_default_shader = [scene](ccl::Mesh* mesh, ccl::Shader* new_default_shader) {
-        if (mesh->used_shaders.empty()) {
-            mesh->used_shaders.push_back(new_default_shader);
-        } else {
-            // only override if shader is a default shader
-            if (mesh->used_shaders[0] == scene->default_surface) {
-                mesh->used_shaders[0] = new_default_shader;
-            }
-        }
-    };
-
     // Object color
 
     if (interpolation == HdInterpolationConstant && name == HdTokens->displayColor) {
@@ -368,8 +414,8 @@ HdCyclesMesh::_PopulateColors(const TfToken& name, const TfToken& role, const Vt
             return;
         }
 
-        m_cyclesObject->color = ccl::make_float3(colors[0][0], colors[0][1], colors[0][2]);
-        override_default_shader(m_cyclesMesh, m_object_display_color_shader);
+        m_staged_has_display_color = true;
+        m_staged_display_color = ccl::make_float3(colors[0][0], colors[0][1], colors[0][2]);
         return;
     }
 
@@ -379,7 +425,26 @@ HdCyclesMesh::_PopulateColors(const TfToken& name, const TfToken& role, const Vt
 }
 
 void
-HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id)
+HdCyclesMesh::_PublishColors(ccl::Scene* scene)
+{
+    if (!m_staged_has_display_color) {
+        return;
+    }
+
+    m_cyclesObject->color = m_staged_display_color;
+
+    if (m_cyclesMesh->used_shaders.empty()) {
+        m_cyclesMesh->used_shaders.push_back(m_object_display_color_shader);
+    } else {
+        // only override if shader is a default shader
+        if (m_cyclesMesh->used_shaders[0] == scene->default_surface) {
+            m_cyclesMesh->used_shaders[0] = m_object_display_color_shader;
+        }
+    }
+}
+
+void
+HdCyclesMesh::_FetchNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id)
 {
     // Normals are tricky in Hd. When subdivisionSchema is being set to != none,
     // then Hd interface suppresses loading any normals as 'normals' or 'primvar:normals' from primvars.
@@ -391,27 +456,25 @@ HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id
     // * authored normals passed by primvar, as long as subdivisionSchema == none
     // * auto generated from limit surface for subdivisionSchema != none
 
-    // cleanup pre existing normals, that will force cycles to evaluate normals
-    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_FACE_NORMAL);
-    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_VERTEX_NORMAL);
-    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_CORNER_NORMAL);
-    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_MOTION_VERTEX_NORMAL);
-    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_MOTION_CORNER_NORMAL);
+    // no staged normals will force cycles to evaluate normals
+    m_staged_normals_std = ccl::ATTR_STD_NONE;
+    m_staged_normals.clear();
+    m_staged_motion_normals_std = ccl::ATTR_STD_NONE;
+    m_staged_motion_normals.clear();
+    m_staged_generate_normals = false;
+    m_hasAuthoredNormals = false;
 
     //
     // Auto generated normals from limit surface
     //
     const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
     if (refiner->IsSubdivided()) {
-        assert(m_limit_us.size() == m_cyclesMesh->verts.size());
-        assert(m_limit_vs.size() == m_cyclesMesh->verts.size());
-
-        ccl::AttributeSet& attributes = m_cyclesMesh->attributes;
-        ccl::Attribute* normal_attr = attributes.add(ccl::ATTR_STD_VERTEX_NORMAL);
-        ccl::float3* normal_data = normal_attr->data_float3();
+        assert(m_limit_us.size() == m_limit_vs.size());
 
+        m_staged_normals_std = ccl::ATTR_STD_VERTEX_NORMAL;
+        m_staged_normals.resize(m_limit_vs.size());
         for (size_t i = 0; i < m_limit_vs.size(); ++i) {
-            normal_data[i] = ccl::normalize(ccl::cross(m_limit_us[i], m_limit_vs[i]));
+            m_staged_normals[i] = ccl::normalize(ccl::cross(m_limit_us[i], m_limit_vs[i]));
         }
 
         return;
@@ -436,14 +499,13 @@ HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id
 
     HdInterpolation interpolation = HdInterpolationCount;
     if (!GetPrimvarInterpolation(interpolation)) {
-        m_cyclesMesh->add_face_normals();
-        m_cyclesMesh->add_vertex_normals();
+        m_staged_generate_normals = true;
         TF_INFO(HDCYCLES_MESH).Msg("Generating smooth normals for: %s", id.GetText());
         return;
     }
     assert(interpolation >= 0 && interpolation < HdInterpolationCount);
 
-    VtValue normals_value = GetNormals(sceneDelegate);
+    VtValue normals_value = array_to_float_array(GetNormals(sceneDelegate));
     if (normals_value.IsEmpty()) {
         TF_WARN("Empty normals for: %s", id.GetText());
         return;
@@ -458,14 +520,13 @@ HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id
         normals_value = normals_value.Cast<VtVec3fArray>();
     }
 
-    ccl::AttributeSet& attributes = m_cyclesMesh->attributes;
+    m_hasAuthoredNormals = true;
 
-    if (interpolation == HdInterpolationConstant) {
-        ccl::Attribute* normal_attr = attributes.add(ccl::ATTR_STD_FACE_NORMAL);
-        ccl::float3* normal_data = normal_attr->data_float3();
+    // Motion normals follow the staged motion points, published only if those are
+    const bool need_motion = m_staged_motion_steps > 1 && !m_staged_motion_verts.empty();
 
+    if (interpolation == HdInterpolationConstant) {
         const size_t num_triangles = refiner->GetTriangulatedTopology().GetNumFaces();
-        memset(normal_data, 0, num_triangles * sizeof(ccl::float3));
 
         VtValue refined_value = refiner->RefineConstantData(HdTokens->normals, HdPrimvarRoleTokens->normal,
                                                             normals_value);
@@ -475,9 +536,10 @@ HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id
         }
 
         VtVec3fArray refined_normals = refined_value.Get<VtVec3fArray>();
-        for (size_t i = 0; i < num_triangles; i++) {
-            normal_data[i] = vec3f_to_float3(refined_normals[i]);
-        }
+        m_staged_normals_std = ccl::ATTR_STD_FACE_NORMAL;
+        m_staged_normals.resize(num_triangles);
+        std::fill(m_staged_normals.data(), m_staged_normals.data() + num_triangles,
+                  vec3f_to_float3(refined_normals[0]));
     } else if (interpolation == HdInterpolationUniform) {
         // This is the correct way to handle face normals, but Cycles does not support
         // custom values, it will just use the geometric normal based on the 'smooth' flag.
@@ -486,30 +548,7 @@ HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id
         // This is more of an attempt to adhere to the USD specification, as it's
         // hard to imagine rendering a surface with a per-face normal different
         // from the geometric one.
-#if 0
-        ccl::Attribute* normal_attr = attributes.add(ccl::ATTR_STD_FACE_NORMAL);
-        ccl::float3* normal_data    = normal_attr->data_float3();
-
-        const size_t num_triangles = m_refiner->GetNumRefinedTriangles();
-        memset(normal_data, 0, num_triangles * sizeof(ccl::float3));
-
-        VtValue refined_value = m_refiner->RefineUniformData(HdTokens->normals, HdPrimvarRoleTokens->normal,
-                                                            normals_value);
-        if (refined_value.GetArraySize() != num_triangles) {
-            TF_WARN("Invalid uniform normals for: %s", id.GetText());
-            return;
-        }
-
-        VtVec3fArray refined_normals = refined_value.Get<VtVec3fArray>();
-        for (size_t i = 0; i < num_triangles; i++) {
-            normal_data[i] = vec3f_to_float3(refined_normals[i]);
-        }
-#else
-        ccl::Attribute* normal_attr = attributes.add(ccl::ATTR_STD_CORNER_NORMAL);
-        ccl::float3* normal_data = normal_attr->data_float3();
-
         const size_t num_triangles = refiner->GetTriangulatedTopology().GetNumFaces();
-        memset(normal_data, 0, num_triangles * sizeof(ccl::float3));
 
         VtValue refined_value = refiner->RefineUniformData(HdTokens->normals, HdPrimvarRoleTokens->normal,
                                                            normals_value);
@@ -519,26 +558,24 @@ HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id
         }
 
         VtVec3fArray refined_normals = refined_value.Get<VtVec3fArray>();
+        m_staged_normals_std = ccl::ATTR_STD_CORNER_NORMAL;
+        m_staged_normals.resize(num_triangles * 3);
         ccl::float3 N;
         for (size_t i = 0; i < num_triangles; ++i) {
             N = vec3f_to_float3(refined_normals[i]);
             for (int j = 0; j < 3; ++j) {
-                normal_data[i * 3 + j] = N;
+                m_staged_normals[i * 3 + j] = N;
             }
         }
 
-        if (m_cyclesMesh->use_motion_blur && m_cyclesMesh->motion_steps > 1) {
-            _PopulateMotionAttributeVec3f(sceneDelegate, id, HdTokens->normals, HdPrimvarRoleTokens->normal,
-                                          HdInterpolationUniform, HdInterpolationFaceVarying,
-                                          ccl::ATTR_STD_MOTION_CORNER_NORMAL, m_cyclesMesh->motion_steps);
+        if (need_motion) {
+            m_staged_motion_normals_std = ccl::ATTR_STD_MOTION_CORNER_NORMAL;
+            _FetchMotionAttributeVec3f(sceneDelegate, id, HdTokens->normals, HdPrimvarRoleTokens->normal,
+                                       HdInterpolationUniform, HdInterpolationFaceVarying, m_staged_motion_steps,
+                                       &m_staged_motion_normals);
         }
-#endif
     } else if (interpolation == HdInterpolationVertex || interpolation == HdInterpolationVarying) {
-        ccl::Attribute* normal_attr = attributes.add(ccl::ATTR_STD_VERTEX_NORMAL);
-        ccl::float3* normal_data = normal_attr->data_float3();
-
         const size_t num_vertices = refiner->GetTriangulatedTopology().GetNumPoints();
-        memset(normal_data, 0, num_vertices * sizeof(ccl::float3));
 
         VtValue refined_value;
         if (interpolation == HdInterpolationVertex) {
@@ -552,22 +589,19 @@ HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id
             return;
         }
 
-        VtVec3fArray refined_normals = refined_value.Get<VtVec3fArray>();
-        for (size_t i = 0; i < num_vertices; ++i) {
-            normal_data[i] = vec3f_to_float3(refined_normals[i]);
-        }
+        const VtVec3fArray& refined_normals = refined_value.Get<VtVec3fArray>();
+        m_staged_normals_std = ccl::ATTR_STD_VERTEX_NORMAL;
+        m_staged_normals.resize(num_vertices);
+        vec3f_to_float3(refined_normals.cdata(), m_staged_normals.data(), num_vertices);
 
-        if (m_cyclesMesh->use_motion_blur && m_cyclesMesh->motion_steps > 1) {
-            _PopulateMotionAttributeVec3f(sceneDelegate, id, HdTokens->normals, HdPrimvarRoleTokens->normal,
-                                          HdInterpolationVertex, HdInterpolationVertex,
-                                          ccl::ATTR_STD_MOTION_VERTEX_NORMAL, m_cyclesMesh->motion_steps);
+        if (need_motion) {
+            m_staged_motion_normals_std = ccl::ATTR_STD_MOTION_VERTEX_NORMAL;
+            _FetchMotionAttributeVec3f(sceneDelegate, id, HdTokens->normals, HdPrimvarRoleTokens->normal,
+                                       HdInterpolationVertex, HdInterpolationVertex, m_staged_motion_steps,
+                                       &m_staged_motion_normals);
         }
     } else if (interpolation == HdInterpolationFaceVarying) {
-        ccl::Attribute* normal_attr = attributes.add(ccl::ATTR_STD_CORNER_NORMAL);
-        ccl::float3* normal_data = normal_attr->data_float3();
-
         const size_t num_triangles = refiner->GetTriangulatedTopology().GetNumFaces();
-        memset(normal_data, 0, num_triangles * sizeof(ccl::float3));
 
         VtValue refined_value = refiner->RefineFaceVaryingData(HdTokens->normals, HdPrimvarRoleTokens->normal,
                                                                normals_value);
@@ -576,21 +610,56 @@ HdCyclesMesh::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id
             return;
         }
 
-        VtVec3fArray refined_normals = refined_value.Get<VtVec3fArray>();
-        for (size_t i = 0; i < num_triangles * 3; ++i) {
-            normal_data[i] = vec3f_to_float3(refined_normals[i]);
-        }
+        const VtVec3fArray& refined_normals = refined_value.Get<VtVec3fArray>();
+        m_staged_normals_std = ccl::ATTR_STD_CORNER_NORMAL;
+        m_staged_normals.resize(num_triangles * 3);
+        vec3f_to_float3(refined_normals.cdata(), m_staged_normals.data(), num_triangles * 3);
 
-        if (m_cyclesMesh->use_motion_blur && m_cyclesMesh->motion_steps > 1) {
-            _PopulateMotionAttributeVec3f(sceneDelegate, id, HdTokens->normals, HdPrimvarRoleTokens->normal,
-                                          HdInterpolationFaceVarying, HdInterpolationFaceVarying,
-                                          ccl::ATTR_STD_MOTION_CORNER_NORMAL, m_cyclesMesh->motion_steps);
+        if (need_motion) {
+            m_staged_motion_normals_std = ccl::ATTR_STD_MOTION_CORNER_NORMAL;
+            _FetchMotionAttributeVec3f(sceneDelegate, id, HdTokens->normals, HdPrimvarRoleTokens->normal,
+                                       HdInterpolationFaceVarying, HdInterpolationFaceVarying, m_staged_motion_steps,
+                                       &m_staged_motion_normals);
         }
     } else {
         TF_WARN("Invalid normal interpolation for: %s", id.GetText());
     }
 }
 
+void
+HdCyclesMesh::_PublishNormals(const SdfPath& id)
+{
+    // cleanup pre existing normals, that will force cycles to evaluate normals
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_FACE_NORMAL);
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_VERTEX_NORMAL);
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_CORNER_NORMAL);
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_MOTION_VERTEX_NORMAL);
+    m_cyclesMesh->attributes.remove(ccl::ATTR_STD_MOTION_CORNER_NORMAL);
+
+    if (m_staged_generate_normals) {
+        m_cyclesMesh->add_face_normals();
+        m_cyclesMesh->add_vertex_normals();
+    } else if (m_staged_normals_std != ccl::ATTR_STD_NONE) {
+        ccl::Attribute* normal_attr = m_cyclesMesh->attributes.add(m_staged_normals_std);
+        if (!HdCyclesCopyStagedAttribute(normal_attr, m_staged_normals)) {
+            TF_WARN("Staged normals do not match the mesh for: %s", id.GetText());
+            m_cyclesMesh->attributes.remove(m_staged_normals_std);
+        }
+    }
+
+    if (m_staged_motion_normals_std != ccl::ATTR_STD_NONE && m_cyclesMesh->use_motion_blur
+        && m_cyclesMesh->motion_steps > 1 && !m_staged_motion_normals.empty()) {
+        ccl::Attribute* motion_attr = m_cyclesMesh->attributes.add(m_staged_motion_normals_std);
+        if (!HdCyclesCopyStagedAttribute(motion_attr, m_staged_motion_normals)) {
+            TF_WARN("Staged motion normals do not match the mesh for: %s", id.GetText());
+            m_cyclesMesh->attributes.remove(m_staged_motion_normals_std);
+        }
+    }
+
+    m_staged_normals.clear();
+    m_staged_motion_normals.clear();
+}
+
 ccl::Mesh*
 HdCyclesMesh::_CreateCyclesMesh()
 {
@@ -614,7 +683,7 @@ HdCyclesMesh::_CreateCyclesObject()
 }
 
 void
-HdCyclesMesh::_PopulateMotion(HdSceneDelegate* sceneDelegate, const SdfPath& id)
+HdCyclesMesh::_FetchMotion(HdSceneDelegate* sceneDelegate, const SdfPath& id)
 {
     // todo: this needs to be check to see if it is time-varying
     // todo: this should be shared with the points for the center motion step
@@ -626,51 +695,97 @@ HdCyclesMesh::_PopulateMotion(HdSceneDelegate* sceneDelegate, const SdfPath& id)
     auto& times = motion_samples.times;
     auto& values = motion_samples.values;
 
-    ccl::AttributeSet* attributes = &m_cyclesMesh->attributes;
-    ccl::Attribute* attr_mP = attributes->find(ccl::ATTR_STD_MOTION_VERTEX_POSITION);
-    if (attr_mP) {
-        attributes->remove(attr_mP);
-    }
+    m_staged_motion_verts.clear();
+    m_staged_motion_steps = 0;
 
     if (numSamples <= 1) {
-        m_cyclesMesh->use_motion_blur = false;
-        m_cyclesMesh->motion_steps = 0;
         return;
     }
 
-    m_cyclesMesh->use_motion_blur = true;
-    m_cyclesMesh->motion_steps = static_cast<unsigned int>(numSamples + ((numSamples % 2) ? 0 : 1));
+    m_staged_motion_steps = static_cast<unsigned int>(numSamples + ((numSamples % 2) ? 0 : 1));
 
     const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
+    const size_t num_points = refiner->GetTriangulatedTopology().GetNumPoints();
 
-    attr_mP = attributes->add(ccl::ATTR_STD_MOTION_VERTEX_POSITION);
-    ccl::float3* mP = attr_mP->data_float3();
+    // Center step is stored in the verts, attribute holds the remaining steps
+    m_staged_motion_verts.resize(num_points * (m_staged_motion_steps - 1));
+    ccl::float3* mP = m_staged_motion_verts.data();
 
+    // All non center steps are refined together, subdivided meshes evaluate stencils once for all of them
+    std::vector<unsigned int> motion_steps;
+    std::vector<VtValue> motion_values;
     for (unsigned int i = 0; i < numSamples; ++i) {
         if (times[i] == 0.0f)  // todo: more flexible check?
             continue;
 
-        VtValue refined_points_value = refiner->RefineVertexData(HdTokens->points, HdPrimvarRoleTokens->point,
-                                                                 values[i]);
+        motion_steps.push_back(i);
+        motion_values.push_back(array_to_float_array(values[i]));
+    }
+
+    std::vector<VtValue> refined_values = refiner->RefineVertexDataBatch(HdTokens->points, HdPrimvarRoleTokens->point,
+                                                                         motion_values);
+
+    for (size_t step = 0; step < motion_steps.size(); ++step) {
+        const unsigned int i = motion_steps[step];
+
+        const VtValue& refined_points_value = refined_values[step];
         if (!refined_points_value.IsHolding<VtVec3fArray>()) {
             TF_WARN("Cannot fill in motion step %d for: %s\n", static_cast<int>(i), id.GetText());
             continue;
         }
 
-        VtVec3fArray refined_points = refined_points_value.UncheckedGet<VtVec3fArray>();
-
-        for (size_t j = 0; j < refiner->GetTriangulatedTopology().GetNumPoints(); ++j, ++mP) {
-            *mP = vec3f_to_float3(refined_points[j]);
+        const VtVec3fArray& refined_points = refined_points_value.UncheckedGet<VtVec3fArray>();
+        if (refined_points.size() != num_points) {
+            TF_WARN("Cannot fill in motion step %d for: %s\n", static_cast<int>(i), id.GetText());
+            continue;
         }
+
+        vec3f_to_float3(refined_points.cdata(), mP, num_points);
+        mP += num_points;
     }
 }
 
+bool
+HdCyclesMesh::_PublishMotion()
+{
+    const bool had_motion_blur = m_cyclesMesh->use_motion_blur;
+    const ccl::uint had_motion_steps = m_cyclesMesh->motion_steps;
+
+    ccl::AttributeSet* attributes = &m_cyclesMesh->attributes;
+    ccl::Attribute* attr_mP = attributes->find(ccl::ATTR_STD_MOTION_VERTEX_POSITION);
+    if (attr_mP) {
+        attributes->remove(attr_mP);
+    }
+
+    const size_t num_motion_verts = m_staged_motion_steps > 1
+                                        ? m_cyclesMesh->verts.size() * (m_staged_motion_steps - 1)
+                                        : 0;
+    if (num_motion_verts == 0 || m_staged_motion_verts.size() != num_motion_verts) {
+        m_cyclesMesh->use_motion_blur = false;
+        m_cyclesMesh->motion_steps = 0;
+        m_staged_motion_verts.clear();
+        return had_motion_blur;
+    }
+
+    m_cyclesMesh->use_motion_blur = true;
+    m_cyclesMesh->motion_steps = m_staged_motion_steps;
+
+    attr_mP = attributes->add(ccl::ATTR_STD_MOTION_VERTEX_POSITION);
+    std::copy(m_staged_motion_verts.data(), m_staged_motion_verts.data() + m_staged_motion_verts.size(),
+              attr_mP->data_float3());
+    m_staged_motion_verts.clear();
+
+    return !had_motion_blur || had_motion_steps != m_cyclesMesh->motion_steps;
+}
+
 void
-HdCyclesMesh::_PopulateMotionAttributeVec3f(HdSceneDelegate* sceneDelegate, const SdfPath& id, const TfToken& token,
-                                            const TfToken& role, const HdInterpolation& interpolation_refine,
-                                            const HdInterpolation& interpolation, int cycles_motion_attribute,
-                                            size_t n_expected_samples)
+HdCyclesMesh::_FetchMotionAttributeVec3f(HdSceneDelegate* sceneDelegate, const SdfPath& id, const TfToken& token,
+                                         const TfToken& role, const HdInterpolation& interpolation_refine,
+                                         const HdInterpolation& interpolation, size_t n_expected_samples,
+                                         ccl::array<ccl::float3>* motion_data)
 {
+    motion_data->clear();
+
     // todo: this needs to be check to see if it is time-varying
     // todo: this should be shared with the points for the center motion step
     // TODO: implement resampling based on number of requested samples
@@ -686,26 +801,30 @@ HdCyclesMesh::_PopulateMotionAttributeVec3f(HdSceneDelegate* sceneDelegate, cons
         return;
     }
 
-    ccl::AttributeSet* attributes = &m_cyclesMesh->attributes;
-    ccl::Attribute* attr_m = attributes->find((ccl::AttributeStandard)cycles_motion_attribute);
-    if (attr_m) {
-        attributes->remove(attr_m);
-    }
-
     if (numSamples <= 1) {
         return;
     }
 
     const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
+    const size_t num_elements = interpolation == HdInterpolationVertex
+                                    ? static_cast<size_t>(refiner->GetTriangulatedTopology().GetNumPoints())
+                                    : static_cast<size_t>(refiner->GetTriangulatedTopology().GetNumFaces()) * 3;
 
-    attr_m = attributes->add((ccl::AttributeStandard)cycles_motion_attribute);
-    ccl::float3* m = attr_m->data_float3();
+    // Center step is stored in the normals attribute, same layout as the motion points
+    motion_data->resize(num_elements * (n_expected_samples - 1));
+    std::fill(motion_data->data(), motion_data->data() + motion_data->size(), ccl::make_float3(0.0f, 0.0f, 0.0f));
+    ccl::float3* m = motion_data->data();
+    ccl::float3* m_end = m + motion_data->size();
 
     for (unsigned int i = 0; i < numSamples; ++i) {
         if (times[i] == 0.0f)  // todo: more flexible check?
             continue;
 
-        VtValue refined_value = refiner->Refine(token, role, values[i], interpolation_refine);
+        if (m + num_elements > m_end) {
+            break;
+        }
+
+        VtValue refined_value = refiner->Refine(token, role, array_to_float_array(values[i]), interpolation_refine);
         if (!refined_value.IsHolding<VtVec3fArray>()) {
             TF_WARN("Cannot fill in motion step %d for: %s\n", static_cast<int>(i), id.GetText());
             continue;
@@ -714,29 +833,29 @@ HdCyclesMesh::_PopulateMotionAttributeVec3f(HdSceneDelegate* sceneDelegate, cons
         VtVec3fArray value = refined_value.UncheckedGet<VtVec3fArray>();
 
         if (interpolation == HdInterpolationVertex) {
-            for (size_t j = 0; j < refiner->GetTriangulatedTopology().GetNumPoints(); ++j, ++m) {
-                *m = vec3f_to_float3(value[j]);
+            if (value.size() == num_elements) {
+                vec3f_to_float3(value.cdata(), m, num_elements);
             }
+            m += num_elements;
         } else if (interpolation == HdInterpolationFaceVarying) {
-            const size_t numRefinedFaces = refiner->GetTriangulatedTopology().GetNumFaces();
+            const size_t numRefinedFaces = num_elements / 3;
             // Uniform -> FaceVarying
             if (value.size() == numRefinedFaces) {
                 for (size_t j = 0; j < numRefinedFaces; ++j) {
-                    for (size_t k = 0; k < 3; ++k, ++m) {
-                        *m = vec3f_to_float3(value[j]);
+                    for (size_t k = 0; k < 3; ++k) {
+                        m[j * 3 + k] = vec3f_to_float3(value[j]);
                     }
                 }
-            } else {
-                for (size_t j = 0; j < numRefinedFaces * 3; ++j, ++m) {
-                    *m = vec3f_to_float3(value[j]);
-                }
+            } else if (value.size() == num_elements) {
+                vec3f_to_float3(value.cdata(), m, num_elements);
             }
+            m += num_elements;
         }
     }
 }
 
 void
-HdCyclesMesh::_PopulateTopology(HdSceneDelegate* sceneDelegate, const SdfPath& id)
+HdCyclesMesh::_FetchTopology(HdSceneDelegate* sceneDelegate, const SdfPath& id)
 {
     HdMeshTopology topology = GetMeshTopology(sceneDelegate);
     topology.SetSubdivTags(GetSubdivTags(sceneDelegate));
@@ -744,8 +863,15 @@ HdCyclesMesh::_PopulateTopology(HdSceneDelegate* sceneDelegate, const SdfPath& i
     HdDisplayStyle display_style = sceneDelegate->GetDisplayStyle(id);
     display_style.refineLevel = m_refineLevel;
 
-    // Refiner holds pointer to topology therefore refiner can't outlive the topology
-    m_topology = std::make_shared<HdBbMeshTopology>(id, topology, display_style.refineLevel);
+    // Refiner holds pointer to topology therefore refiner can't outlive the topology.
+    // Identical topologies are refined once and shared through the resource registry.
+    auto resource_registry = dynamic_cast<HdCyclesResourceRegistry*>(m_renderDelegate->GetResourceRegistry().get());
+    m_topology = resource_registry->GetMeshTopology(id, topology, display_style.refineLevel);
+}
+
+void
+HdCyclesMesh::_PublishTopology()
+{
     const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
 
     // Mesh is independently updated in two stages, faces(topology) and vertices(data).
@@ -770,8 +896,7 @@ HdCyclesMesh::_PopulateTopology(HdSceneDelegate* sceneDelegate, const SdfPath& i
 }
 
 void
-HdCyclesMesh::_PopulateMaterials(HdSceneDelegate* sceneDelegate, HdCyclesRenderParam* renderParam,
-                                 ccl::Shader* default_surface, const SdfPath& id)
+HdCyclesMesh::_FetchMaterials(HdSceneDelegate* sceneDelegate, ccl::Shader* default_surface, const SdfPath& id)
 {
     // Any topology change will mark MaterialId as dirty and automatically trigger material discovery.
     // During topology population process, material id for each face is set to 0.
@@ -780,26 +905,24 @@ HdCyclesMesh::_PopulateMaterials(HdSceneDelegate* sceneDelegate, HdCyclesRenderP
     // SubSet material discovery appends to the shaders table and overrides materials ids for subset faces.
     // This behaviour is to cover a corner case, where there is no object material, but there is a sub set,
     // that does not assign materials to all faces.
-    m_cyclesMesh->used_shaders = { default_surface };
+    m_staged_shaders = { default_surface };
 
     constexpr int default_shader_id = 0;
-    for (size_t i = 0; i < m_cyclesMesh->num_triangles(); ++i) {
-        m_cyclesMesh->shader[i] = default_shader_id;
-    }
-
-    _PopulateObjectMaterial(sceneDelegate, id);
-    _PopulateSubSetsMaterials(sceneDelegate, id);
+    const size_t num_triangles = m_topology->GetRefiner()->GetTriangulatedTopology().GetNumFaces();
+    m_staged_shader_ids.resize(num_triangles);
+    std::fill(m_staged_shader_ids.data(), m_staged_shader_ids.data() + num_triangles, default_shader_id);
 
-    renderParam->UpdateShadersTag(m_cyclesMesh->used_shaders);
+    _FetchObjectMaterial(sceneDelegate, id);
+    _FetchSubSetsMaterials(sceneDelegate, id);
 }
 
 void
-HdCyclesMesh::_PopulateObjectMaterial(HdSceneDelegate* sceneDelegate, const SdfPath& id)
+HdCyclesMesh::_FetchObjectMaterial(HdSceneDelegate* sceneDelegate, const SdfPath& id)
 {
     HdRenderIndex& render_index = sceneDelegate->GetRenderIndex();
 
     // object material overrides face materials
-    auto& used_shaders = m_cyclesMesh->used_shaders;
+    auto& used_shaders = m_staged_shaders;
 
     const SdfPath& material_id = sceneDelegate->GetMaterialId(id);
     if (material_id.IsEmpty()) {
@@ -824,7 +947,7 @@ HdCyclesMesh::_PopulateObjectMaterial(HdSceneDelegate* sceneDelegate, const SdfP
 }
 
 void
-HdCyclesMesh::_PopulateSubSetsMaterials(HdSceneDelegate* sceneDelegate, const SdfPath& id)
+HdCyclesMesh::_FetchSubSetsMaterials(HdSceneDelegate* sceneDelegate, const SdfPath& id)
 {
     // optimization to avoid unnecessary allocations
     if (m_topology->GetGeomSubsets().empty()) {
@@ -836,7 +959,7 @@ HdCyclesMesh::_PopulateSubSetsMaterials(HdSceneDelegate* sceneDelegate, const Sd
     // collect unrefined material ids for each face
     VtIntArray face_materials(m_topology->GetNumFaces(), 0);
 
-    auto& used_shaders = m_cyclesMesh->used_shaders;
+    auto& used_shaders = m_staged_shaders;
     TfHashMap<SdfPath, int, SdfPath::Hash> material_map;
     for (auto& subset : m_topology->GetGeomSubsets()) {
         int subset_material_id = 0;
@@ -875,20 +998,37 @@ HdCyclesMesh::_PopulateSubSetsMaterials(HdSceneDelegate* sceneDelegate, const Sd
     VtValue refined_value = refiner->RefineUniformData(HdTokens->materialParams, HdPrimvarRoleTokens->none,
                                                        VtValue { face_materials });
 
-    if (refined_value.GetArraySize() != m_cyclesMesh->shader.size()) {
+    if (refined_value.GetArraySize() != m_staged_shader_ids.size()) {
         TF_WARN("Failed to assign refined materials for: %s", id.GetText());
         return;
     }
 
     auto refined_material_ids = refined_value.UncheckedGet<VtIntArray>();
-    for (size_t i = 0; i < refined_material_ids.size(); ++i) {
-        m_cyclesMesh->shader[i] = refined_material_ids[i];
+    std::copy(refined_material_ids.cdata(), refined_material_ids.cdata() + refined_material_ids.size(),
+              m_staged_shader_ids.data());
+}
+
+void
+HdCyclesMesh::_PublishMaterials(HdCyclesRenderParam* renderParam)
+{
+    m_cyclesMesh->used_shaders = m_staged_shaders;
+
+    // Shader ids are refined for the fetched topology, default shader is used if the mesh does not match
+    if (m_staged_shader_ids.size() == m_cyclesMesh->shader.size()) {
+        m_cyclesMesh->shader.steal_data(m_staged_shader_ids);
+    } else {
+        constexpr int default_shader_id = 0;
+        for (size_t i = 0; i < m_cyclesMesh->shader.size(); ++i) {
+            m_cyclesMesh->shader[i] = default_shader_id;
+        }
     }
+    m_staged_shader_ids.clear();
+
+    renderParam->UpdateShadersTag(m_cyclesMesh->used_shaders);
 }
 
 void
-HdCyclesMesh::_PopulatePrimvars(HdSceneDelegate* sceneDelegate, ccl::Scene* scene, const SdfPath& id,
-                                HdDirtyBits* dirtyBits)
+HdCyclesMesh::_FetchPrimvars(HdSceneDelegate* sceneDelegate, const SdfPath& id, HdDirtyBits* dirtyBits)
 {
     std::array<std::pair<HdInterpolation, HdPrimvarDescriptorVector>, 5> primvars_desc {
         std::make_pair(HdInterpolationConstant, HdPrimvarDescriptorVector {}),
@@ -902,7 +1042,20 @@ HdCyclesMesh::_PopulatePrimvars(HdSceneDelegate* sceneDelegate, ccl::Scene* scen
         info.second = sceneDelegate->GetPrimvarDescriptors(id, info.first);
     }
 
+    // Vertex primvars share the stencil table, they are refined together after the loop. Subdivided meshes
+    // evaluate float primvars in one interleaved stencil pass.
+    struct VertexPrimvar {
+        const HdPrimvarDescriptor* description;
+        bool is_uv;
+    };
+    std::vector<VertexPrimvar> vertex_primvars;
+    std::vector<VtValue> vertex_values;
+
     m_texture_names.clear();
+    m_staged_has_display_color = false;
+    m_staged_uvs.clear();
+    m_staged_velocities.clear();
+    m_staged_accelerations.clear();
 
     for (auto& interpolation_description : primvars_desc) {
         for (const HdPrimvarDescriptor& description : interpolation_description.second) {
@@ -924,32 +1077,51 @@ HdCyclesMesh::_PopulatePrimvars(HdSceneDelegate* sceneDelegate, ccl::Scene* scen
 
             if (description.name == HdTokens->displayColor || description.role == HdPrimvarRoleTokens->color) {
                 auto value = GetPrimvar(sceneDelegate, description.name);
-                _PopulateColors(description.name, description.role, value, scene, interpolation, id);
+                if (interpolation == HdInterpolationVertex && m_cyclesMesh && value.CanCast<VtVec3fArray>()) {
+                    vertex_primvars.push_back({ &description, false });
+                    vertex_values.push_back(array_to_float_array(value));
+                    continue;
+                }
+
+                _FetchColors(description.name, description.role, value, interpolation, id);
                 continue;
             }
 
+            // uv sets are refined whether or not shaders request them, requests are only known under the lock
             if (description.role == HdPrimvarRoleTokens->textureCoordinate) {
                 auto value = GetPrimvar(sceneDelegate, description.name);
-                _AddUVSet(description.name, value, scene, interpolation);
                 *dirtyBits |= DirtyBits::DirtyTangents;
+                value = array_to_float_array(value);
+                if (interpolation == HdInterpolationVertex && value.CanCast<VtVec2fArray>()) {
+                    vertex_primvars.push_back({ &description, true });
+                    vertex_values.push_back(value.Cast<VtVec2fArray>());
+                    continue;
+                }
+
+                _FetchUVSet(description.name, value, interpolation);
                 continue;
             }
 
             if (description.name == HdTokens->velocities) {
-                auto value = GetPrimvar(sceneDelegate, description.name);
-                _AddVelocities(id, value, interpolation);
+                m_staged_velocities.push_back({ GetPrimvar(sceneDelegate, description.name), interpolation });
                 continue;
             }
 
             if (description.name == HdTokens->accelerations) {
-                auto value = GetPrimvar(sceneDelegate, description.name);
-                _AddAccelerations(id, value, interpolation);
+                m_staged_accelerations.push_back({ GetPrimvar(sceneDelegate, description.name), interpolation });
                 continue;
             }
 
             // do not commit primvars with cycles: prefix
             if (m_cyclesMesh && !TfStringStartsWith(description.name.GetString(), "cycles:")) {
                 auto value = GetPrimvar(sceneDelegate, description.name);
+                if (description.interpolation == HdInterpolationVertex) {
+                    // stencils evaluate only floats
+                    vertex_primvars.push_back({ &description, false });
+                    vertex_values.push_back(array_to_float_array(value));
+                    continue;
+                }
+
                 m_object_source->CreateAttributeSource<HdBbMeshAttributeSource>(description.name, description.role,
                                                                                 value, m_cyclesMesh,
                                                                                 description.interpolation, m_topology);
@@ -958,11 +1130,57 @@ HdCyclesMesh::_PopulatePrimvars(HdSceneDelegate* sceneDelegate, ccl::Scene* scen
             // TODO: Add arbitrary primvar support when AOVs are working
         }
     }
+
+    if (vertex_primvars.empty()) {
+        return;
+    }
+
+    const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
+    std::vector<VtValue> refined_values = refiner->RefineVertexDataBatch(_tokens->primvars, HdPrimvarRoleTokens->none,
+                                                                         vertex_values);
+
+    for (size_t i = 0; i < vertex_primvars.size(); ++i) {
+        // refiner has already warned about values that failed to refine
+        if (refined_values[i].IsEmpty()) {
+            continue;
+        }
+
+        const HdPrimvarDescriptor& description = *vertex_primvars[i].description;
+        if (vertex_primvars[i].is_uv) {
+            _FetchUVSet(description.name, refined_values[i], HdInterpolationVertex, true);
+            continue;
+        }
+
+        m_object_source->CreateAttributeSource<HdBbMeshAttributeSource>(description.name, description.role,
+                                                                        refined_values[i], m_cyclesMesh,
+                                                                        HdInterpolationVertex, m_topology, true);
+    }
 }
 
 void
-HdCyclesMesh::_PopulateVertices(HdSceneDelegate* sceneDelegate, const SdfPath& id, HdDirtyBits* dirtyBits)
+HdCyclesMesh::_PublishPrimvars(ccl::Scene* scene, const SdfPath& id)
 {
+    _PublishColors(scene);
+    _PublishUVSets(scene);
+
+    // Velocities and accelerations are ignored when motion points are published
+    for (const StagedPrimvar& velocities : m_staged_velocities) {
+        _AddVelocities(id, velocities.value, velocities.interpolation);
+    }
+
+    for (const StagedPrimvar& accelerations : m_staged_accelerations) {
+        _AddAccelerations(id, accelerations.value, accelerations.interpolation);
+    }
+
+    m_staged_velocities.clear();
+    m_staged_accelerations.clear();
+}
+
+void
+HdCyclesMesh::_FetchVertices(HdSceneDelegate* sceneDelegate, const SdfPath& id, HdDirtyBits* dirtyBits)
+{
+    m_staged_verts.clear();
+
     VtValue points_value;
 
     //
@@ -995,6 +1213,9 @@ HdCyclesMesh::_PopulateVertices(HdSceneDelegate* sceneDelegate, const SdfPath& i
         points_value = GetPrimvar(sceneDelegate, HdTokens->points);
     }
 
+    // double and half data is converted with the array conversion kernels, other types go through VtValue casts
+    points_value = array_to_float_array(points_value);
+
     if (!points_value.IsHolding<VtVec3fArray>()) {
         if (!points_value.CanCast<VtVec3fArray>()) {
             TF_WARN("Invalid points data! Can not convert points for: %s", id.GetText());
@@ -1014,40 +1235,41 @@ HdCyclesMesh::_PopulateVertices(HdSceneDelegate* sceneDelegate, const SdfPath& i
     }
 
     const HdCyclesMeshRefiner* refiner = m_topology->GetRefiner();
+    const VtVec3fArray& points = points_value.UncheckedGet<VtVec3fArray>();
 
-    VtVec3fArray points;
-    VtValue refined_points_value = refiner->RefineVertexData(HdTokens->points, HdPrimvarRoleTokens->point,
-                                                             points_value);
-    if (refined_points_value.IsHolding<VtVec3fArray>()) {
-        points = refined_points_value.Get<VtVec3fArray>();
-    } else {
-        TF_WARN("Unsupported point type for: %s", id.GetText());
+    // Points are refined straight into Cycles layout, no intermediate refined VtArray is created
+    ccl::array<ccl::float3> refined_points(refiner->GetTriangulatedTopology().GetNumPoints());
+    if (!refiner->RefinePoints(HdTokens->points, points, refined_points.data(), refined_points.size())) {
+        TF_WARN("Refined points do not match the topology for: %s", id.GetText());
         return;
     }
 
-    for (size_t i = 0; i < points.size(); ++i) {
-        const GfVec3f& point = points[i];
-        m_cyclesMesh->verts[i] = ccl::make_float3(point[0], point[1], point[2]);
+    if (!refiner->IsSubdivided()) {
+        m_staged_verts.steal_data(refined_points);
+        return;
     }
 
     //
     // Compute limit attributes once, then in the FinishMesh clean up the data
     //
-    if (refiner->IsSubdivided()) {
-        Vt_ArrayForeignDataSource foreign_data_source {};
-        VtFloat3Array refined_vertices { &foreign_data_source, m_cyclesMesh->verts.data(), m_cyclesMesh->verts.size(),
-                                         false };
 
-        VtFloat3Array limit_ps(refined_vertices.size());
-        m_limit_us.resize(refined_vertices.size());
-        m_limit_vs.resize(refined_vertices.size());
-        refiner->EvaluateLimit(refined_vertices, limit_ps, m_limit_us, m_limit_vs);
+    // snap to limit surface, limit positions are written straight to the staged vertices
+    m_staged_verts.resize(refined_points.size());
+    m_limit_us.resize(refined_points.size());
+    m_limit_vs.resize(refined_points.size());
+    refiner->EvaluateLimit(refined_points.data(), m_staged_verts.data(), m_limit_us.data(), m_limit_vs.data());
+}
 
-        // snap to limit surface
-        std::memcpy(m_cyclesMesh->verts.data(), limit_ps.data(), limit_ps.size() * sizeof(ccl::float3));
+void
+HdCyclesMesh::_PublishVertices()
+{
+    // Fetch failed or topology has changed in between, keep whatever the mesh holds
+    if (m_staged_verts.size() != m_cyclesMesh->verts.size()) {
+        m_staged_verts.clear();
+        return;
     }
 
-    // TODO: populate motion ?
+    m_cyclesMesh->verts.steal_data(m_staged_verts);
 }
 
 void
@@ -1068,7 +1290,7 @@ HdCyclesMesh::_PopulateGenerated(ccl::Scene* scene)
 }
 
 void
-HdCyclesMesh::_FinishMesh(ccl::Scene* scene)
+HdCyclesMesh::_FinishMesh(ccl::Scene* scene, bool deformOnly)
 {
     if (m_cyclesMesh->use_motion_blur && m_cyclesMesh->motion_steps > 1) {
         const bool hasCornerNormals = m_cyclesMesh->attributes.find(ccl::ATTR_STD_CORNER_NORMAL);
@@ -1083,6 +1305,12 @@ HdCyclesMesh::_FinishMesh(ccl::Scene* scene)
     // This must be done first, because HdCyclesMeshTextureSpace requires computed min/max
     m_cyclesMesh->compute_bounds();
 
+    // Generated coordinates are kept from the last full update, otherwise the texture space would follow
+    // the deformation
+    if (deformOnly && m_cyclesMesh->attributes.find(ccl::ATTR_STD_GENERATED)) {
+        return;
+    }
+
     _PopulateGenerated(scene);
 }
 
@@ -1153,19 +1381,30 @@ HdCyclesMesh::_PropagateDirtyBits(HdDirtyBits bits) const
                  | HdChangeTracker::DirtyTopology);
     }
 
-    // Check PopulateNormals for more details
-    if (bits & HdChangeTracker::DirtyPoints) {
+    // Check FetchNormals for more details. Authored normals do not depend on the points, they are marked
+    // dirty by the scene delegate when they change.
+    if ((bits & HdChangeTracker::DirtyPoints) && !m_hasAuthoredNormals) {
         bits |= HdChangeTracker::DirtyNormals;
     }
 
-    // dirty points trigger dirty tangents
-    if (bits & HdChangeTracker::DirtyNormals) {
+    // dirty points and normals trigger dirty tangents
+    if (bits & (HdChangeTracker::DirtyPoints | HdChangeTracker::DirtyNormals)) {
         bits |= DirtyBits::DirtyTangents;
     }
 
     return bits;
 }
 
+bool
+HdCyclesMesh::_IsDeformOnly(HdDirtyBits bits)
+{
+    constexpr HdDirtyBits deform_bits = HdChangeTracker::Varying | HdChangeTracker::DirtyPoints
+                                        | HdChangeTracker::DirtyNormals | HdChangeTracker::DirtyExtent
+                                        | HdChangeTracker::DirtyTransform | DirtyBits::DirtyTangents;
+
+    return (bits & HdChangeTracker::DirtyPoints) && (bits & ~deform_bits) == 0;
+}
+
 void
 HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam, HdDirtyBits* dirtyBits,
                    TfToken const& reprToken)
@@ -1177,236 +1416,252 @@ HdCyclesMesh::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam, H
     ccl::Scene* scene = param->GetCyclesScene();
     const SdfPath& id = GetId();
 
-    ccl::thread_scoped_lock lock { scene->mutex };
+    // Sync runs in two stages:
+    // 1) fetch - lock free, scene delegate queries, object settings, topology refinement, materials and primvars
+    //    conversion into staging buffers
+    // 2) publish - under the scene lock, staging buffers are swapped into the ccl::Object and ccl::Mesh
+    // Fetch runs in parallel with other rprims, therefore it must not touch the scene.
+    // Attributes requested by shaders are only known under the lock, uv sets are refined regardless and
+    // MikkTSpace tangents are computed from the published mesh.
+    TfStopwatch settings_timer, fetch_timer, publish_timer;
+
+    // Points only update, attributes are left as they are and the BVH is refit instead of rebuilt
+    const bool deformOnly = _IsDeformOnly(*dirtyBits);
 
     // -------------------------------------
     // -- Resolve Drawstyles
 
-    m_refineLevel = 0;
-    m_useLimitSurfaceTangents = false;
+    settings_timer.Start();
+    {
+        HD_TRACE_SCOPE("settings")
 
-    if (*dirtyBits & HdChangeTracker::DirtyVisibility) {
-        _sharedData.visible = sceneDelegate->GetVisible(id);
-        _UpdateObject(scene, param, dirtyBits, false);
-        if (!_sharedData.visible) {
-            return;
+        if (*dirtyBits & HdChangeTracker::DirtyVisibility) {
+            _sharedData.visible = sceneDelegate->GetVisible(id);
+            if (!_sharedData.visible) {
+                ccl::thread_scoped_lock lock { scene->mutex };
+                _UpdateObject(scene, param, dirtyBits, false);
+                return;
+            }
         }
-    }
 
-    if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
-        HdPrimvarDescriptorMap primvarDescsPerInterpolation = GetPrimvarDescriptorMap(sceneDelegate);
-        GetObjectPrimvars(primvarDescsPerInterpolation, sceneDelegate, dirtyBits);
+        if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
+            // Dirty topology always comes with dirty primvars, subdivision settings are reset only here so that
+            // points only updates keep them
+            m_refineLevel = 0;
+            m_useLimitSurfaceTangents = false;
 
-        for (auto& primvarDescsEntry : primvarDescsPerInterpolation) {
-            for (auto& pv : primvarDescsEntry.second) {
-                if (!HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, pv.name)) {
-                    continue;
-                }
+            HdPrimvarDescriptorMap primvarDescsPerInterpolation = GetPrimvarDescriptorMap(sceneDelegate);
+            FetchObjectPrimvars(primvarDescsPerInterpolation, sceneDelegate, dirtyBits, &m_staged_settings);
 
-                const std::string primvar_name = std::string { "primvars:" } + pv.name.GetString();
+            for (auto& primvarDescsEntry : primvarDescsPerInterpolation) {
+                for (auto& pv : primvarDescsEntry.second) {
+                    if (!HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, pv.name)) {
+                        continue;
+                    }
 
-                if (primvar_name == usdCyclesTokens->primvarsCyclesMeshSubdivision_max_level) {
-                    VtValue value = GetPrimvar(sceneDelegate, pv.name);
-                    m_refineLevel = value.Get<int>();
-                    continue;
-                }
+                    const std::string primvar_name = std::string { "primvars:" } + pv.name.GetString();
 
-                if (primvar_name == usdCyclesTokens->primvarsCyclesMeshSubdivision_use_limit_tangents) {
-                    VtValue value = GetPrimvar(sceneDelegate, pv.name);
-                    m_useLimitSurfaceTangents = value.Get<bool>();
-                    continue;
+                    if (primvar_name == usdCyclesTokens->primvarsCyclesMeshSubdivision_max_level) {
+                        VtValue value = GetPrimvar(sceneDelegate, pv.name);
+                        m_refineLevel = value.Get<int>();
+                        continue;
+                    }
+
+                    if (primvar_name == usdCyclesTokens->primvarsCyclesMeshSubdivision_use_limit_tangents) {
+                        VtValue value = GetPrimvar(sceneDelegate, pv.name);
+                        m_useLimitSurfaceTangents = value.Get<bool>();
+                        continue;
+                    }
                 }
             }
         }
     }
+    settings_timer.Stop();
 
-    bool topologyIsDirty = false;
-    if (HdChangeTracker::IsTopologyDirty(*dirtyBits, id)) {
-        _PopulateTopology(sceneDelegate, id);
-        topologyIsDirty = true;
-    }
+    // -------------------------------------
+    // -- Fetch, lock free
 
-    if (*dirtyBits & HdChangeTracker::DirtyMaterialId) {
-        _PopulateMaterials(sceneDelegate, param, scene->default_surface, id);
-    }
+    fetch_timer.Start();
 
-    // For subdivided meshes, data conversion has to happen in a specific order:
-    // 1) vertices - generate limit surface position and tangents
-    // 2) normals - limit surface tangents are used to generate normals
-    // 3) uvs - limit surface tangents
-    // After conversion, class members that hold du and dv are *NOT* cleared in FinishMesh.
-    // TODO: Revisit logic about keeping limit_us and limit_vs alive
-    if (*dirtyBits & HdChangeTracker::DirtyPoints) {
-        _PopulateVertices(sceneDelegate, id, dirtyBits);
-    }
+    bool topologyIsDirty = false;
+    std::shared_ptr<HdCyclesTransformSource> transform_source;
+    {
+        HD_TRACE_SCOPE("fetch")
 
-    if (m_motionBlur && m_motionDeformSteps > 0) {
-        _PopulateMotion(sceneDelegate, id);
-    } else {
-        m_cyclesMesh->use_motion_blur = false;
-        m_cyclesMesh->motion_steps = 0;
-    }
+        if (HdChangeTracker::IsTopologyDirty(*dirtyBits, id)) {
+            _FetchTopology(sceneDelegate, id);
+            topologyIsDirty = true;
+        }
 
-    if (*dirtyBits & HdChangeTracker::DirtyNormals) {
-        _PopulateNormals(sceneDelegate, id);
-    }
+        // For subdivided meshes, data conversion has to happen in a specific order:
+        // 1) vertices - generate limit surface position and tangents
+        // 2) normals - limit surface tangents are used to generate normals
+        // 3) uvs - limit surface tangents
+        // After conversion, class members that hold du and dv are *NOT* cleared in FinishMesh.
+        // TODO: Revisit logic about keeping limit_us and limit_vs alive
+        if (*dirtyBits & HdChangeTracker::DirtyPoints) {
+            _FetchVertices(sceneDelegate, id, dirtyBits);
+        }
 
-    if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
-        _PopulatePrimvars(sceneDelegate, scene, id, dirtyBits);
-    }
+        if (m_motionBlur && m_motionDeformSteps > 0) {
+            _FetchMotion(sceneDelegate, id);
+        } else {
+            m_staged_motion_verts.clear();
+            m_staged_motion_steps = 0;
+        }
 
-    const ccl::Transform obj_tfm = mat4d_to_transform(sceneDelegate->GetTransform(id));
-    if (*dirtyBits & HdChangeTracker::DirtyTransform) {
-        auto fallback = sceneDelegate->GetTransform(id);
-        HdCyclesMatrix4dTimeSampleArray xf {};
+        // Sprims are synced before rprims, materials are only read here
+        if (*dirtyBits & HdChangeTracker::DirtyMaterialId) {
+            _FetchMaterials(sceneDelegate, scene->default_surface, id);
+        }
 
-        std::shared_ptr<HdCyclesTransformSource> transform_source;
-        if (m_motionBlur && m_motionTransformSteps > 1) {
-            sceneDelegate->SampleTransform(id, &xf);
-            transform_source = std::make_shared<HdCyclesTransformSource>(m_object_source->GetObject(), xf, fallback,
-                                                                         m_motionTransformSteps);
-        } else {
-            transform_source = std::make_shared<HdCyclesTransformSource>(m_object_source->GetObject(), xf, fallback);
+        if (*dirtyBits & HdChangeTracker::DirtyNormals) {
+            _FetchNormals(sceneDelegate, id);
         }
-        if (transform_source->IsValid()) {
-            transform_source->Resolve();
+
+        if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
+            _FetchPrimvars(sceneDelegate, id, dirtyBits);
         }
 
-        m_object_source->AddObjectPropertiesSource(std::move(transform_source));
-    }
+        if (*dirtyBits & DirtyBits::DirtyTangents) {
+            _FetchTangents();
+        }
 
-    if (*dirtyBits & HdChangeTracker::DirtyPrimID) {
-        // Offset of 1 added because Cycles primId pass needs to be shifted down to -1
-        m_cyclesObject->pass_id = this->GetPrimId() + 1;
-    }
+        // Transform is resolved by the resource registry under the scene lock
+        if (*dirtyBits & HdChangeTracker::DirtyTransform) {
+            auto fallback = sceneDelegate->GetTransform(id);
+            HdCyclesMatrix4dTimeSampleArray xf {};
 
-    if (*dirtyBits & DirtyBits::DirtyTangents) {
-        _PopulateTangents(sceneDelegate, id, scene);
+            if (m_motionBlur && m_motionTransformSteps > 1) {
+                sceneDelegate->SampleTransform(id, &xf);
+                transform_source = std::make_shared<HdCyclesTransformSource>(m_object_source->GetObject(), xf,
+                                                                             fallback, m_motionTransformSteps);
+            } else {
+                transform_source = std::make_shared<HdCyclesTransformSource>(m_object_source->GetObject(), xf,
+                                                                             fallback);
+            }
+        }
     }
 
     // -------------------------------------
     // -- Handle point instances
     // -------------------------------------
-    if (*dirtyBits & HdChangeTracker::DirtyInstancer) {
-        const SdfPath& instancer_id = GetInstancerId();
-        auto instancer = dynamic_cast<HdCyclesInstancer*>(sceneDelegate->GetRenderIndex().GetInstancer(instancer_id));
-        if (instancer) {
-            auto instanceTransforms = instancer->SampleInstanceTransforms(id);
-            auto newNumInstances = (instanceTransforms.count > 0) ? instanceTransforms.values[0].size() : 0;
-
-            bool reallocate_array = false;
-            // Clear number of instances only if they have changed.
-            if (m_cyclesInstances.size() != newNumInstances) {
-                reallocate_array = true;
-                if (m_cyclesInstances.size()) {
-                    m_renderDelegate->GetCyclesRenderParam()->RemoveObjectArray(m_cyclesInstances);
-                    std::vector<ccl::Object> empty = {};
-                    m_cyclesInstances.swap(empty);
+    // Instance arrays are owned by the rprim, only Commit touches the scene
+    const SdfPath& instancer_id = GetInstancerId();
+    auto instancer = dynamic_cast<HdCyclesInstancer*>(sceneDelegate->GetRenderIndex().GetInstancer(instancer_id));
+    const bool instancer_dirty = (*dirtyBits & HdChangeTracker::DirtyInstancer) && instancer;
+    bool update_instances = false;
+
+    if (instancer_dirty) {
+        const ccl::Transform obj_tfm = mat4d_to_transform(sceneDelegate->GetTransform(id));
+        const unsigned int motion_steps = (m_motionBlur && m_motionTransformSteps > 1)
+                                              ? static_cast<unsigned int>(m_motionTransformSteps)
+                                              : 0;
+        m_instances.SetTransforms(instancer->SampleInstanceTransforms(id), m_transformSamples, obj_tfm,
+                                  motion_steps);
+        m_instances.SetInstancerId(instancer_id);
+        update_instances = true;
+    }
+
+    // update instances: steal visibility flags and color from the prototype, basic primvars from the instancer
+    if ((*dirtyBits & (HdChangeTracker::DirtyInstancer | HdChangeTracker::DirtyPrimvar)) && instancer) {
+        VtVec3fArray colors;
+        for (auto& desc : sceneDelegate->GetPrimvarDescriptors(instancer_id, HdInterpolationInstance)) {
+            if (desc.name == HdTokens->displayColor) {
+                VtValue displayColor = sceneDelegate->Get(instancer_id, HdTokens->displayColor);
+                if (displayColor.IsHolding<VtVec3fArray>()) {
+                    colors = displayColor.UncheckedGet<VtVec3fArray>();
                 }
             }
+        }
 
-            // create new instances
-            if (newNumInstances != 0) {
-                using size_type = typename decltype(m_transformSamples.values)::size_type;
-
-                std::vector<TfSmallVector<GfMatrix4d, 1>> combinedTransforms;
-                combinedTransforms.reserve(newNumInstances);
-                for (size_t i = 0; i < newNumInstances; ++i) {
-                    // Apply prototype transform (m_transformSamples) to all the instances
-                    combinedTransforms.emplace_back(instanceTransforms.count);
-                    auto& instanceTransform = combinedTransforms.back();
-
-                    if (m_transformSamples.count == 0
-                        || (m_transformSamples.count == 1 && (m_transformSamples.values[0] == GfMatrix4d(1)))) {
-                        for (size_type j = 0; j < instanceTransforms.count; ++j) {
-                            instanceTransform[j] = instanceTransforms.values[j][i];
-                        }
-                    } else {
-                        for (size_type j = 0; j < instanceTransforms.count; ++j) {
-                            GfMatrix4d xf_j = m_transformSamples.Resample(instanceTransforms.times[j]);
-                            instanceTransform[j] = xf_j * instanceTransforms.values[j][i];
-                        }
-                    }
-                }
+        // The prototype color is written by this rprim only, under the lock
+        const ccl::float3 fallback_color = m_staged_has_display_color ? m_staged_display_color
+                                                                      : m_cyclesObject->color;
+        m_instances.SetVisibility(m_visibilityFlags);
+        m_instances.SetColors(colors, fallback_color);
+        update_instances = true;
+    }
 
-                m_cyclesInstances.resize(newNumInstances);
-                for (size_t j = 0; j < newNumInstances; ++j) {
-                    ccl::Object* instanceObj = &m_cyclesInstances[j];
-
-                    instanceObj->tfm = mat4d_to_transform(combinedTransforms[j].data()[0]) * obj_tfm;
-                    instanceObj->geometry = m_cyclesMesh;
-                    instanceObj->pass_id = -1;
-                    instanceObj->visibility = m_visibilityFlags;
-
-                    // TODO: Implement motion blur for point instanced objects
-                    /*if (m_motionBlur) {
-                        m_cyclesMesh->motion_steps    = m_motionSteps;
-                        m_cyclesMesh->use_motion_blur = m_motionBlur;
-
-                        instanceObj->motion.clear();
-                        instanceObj->motion.resize(m_motionSteps);
-                        for (int j = 0; j < m_motionSteps; j++) {
-                            instanceObj->motion[j] = mat4d_to_transform(
-                                combinedTransforms[j].data()[j]);
-                        }
-                    }*/
-                }
+    fetch_timer.Stop();
 
-                if (reallocate_array) {
-                    m_renderDelegate->GetCyclesRenderParam()->AddObjectArray(m_cyclesInstances);
-                }
-            }
+    // -------------------------------------
+    // -- Publish, under the scene lock
 
-            // remove prototype from list of objects to render
-            m_renderDelegate->GetCyclesRenderParam()->RemoveObject(m_cyclesObject);
+    publish_timer.Start();
+
+    ccl::thread_scoped_lock lock { scene->mutex };
+    HD_TRACE_SCOPE("publish")
+
+    // Points only publish: object settings, materials, primvars and instances are clean and their attributes are
+    // kept. Only points, motion points, normals and tangents that follow the points are replaced.
+    if (!deformOnly) {
+        if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
+            ApplyObjectSettings(m_staged_settings);
+        }
+
+        if (topologyIsDirty) {
+            _PublishTopology();
+        }
+
+        if (*dirtyBits & HdChangeTracker::DirtyMaterialId) {
+            _PublishMaterials(param);
         }
     }
 
-    // update instances: steal visibility flags from the prototype
-    if (*dirtyBits & HdChangeTracker::DirtyPrimvar) {
-        // copy settings from the prototype
-        const SdfPath& instancer_id = GetInstancerId();
-        for (size_t i = 0; i < m_cyclesInstances.size(); ++i) {
-            ccl::Object& instance = m_cyclesInstances[i];
+    if (*dirtyBits & HdChangeTracker::DirtyPoints) {
+        _PublishVertices();
+    }
 
-            instance.visibility = m_visibilityFlags;
-            instance.lightgroup = m_cyclesObject->lightgroup;
-            instance.color = m_cyclesObject->color;
+    // Motion steps are part of the BVH layout, change of those can't be refit
+    const bool motionLayoutChanged = _PublishMotion();
 
-            std::string asset_name = instancer_id.GetString() + "/" + std::to_string(i);
-            instance.asset_name = asset_name;
-        }
+    if (*dirtyBits & HdChangeTracker::DirtyNormals) {
+        _PublishNormals(id);
+    }
 
-        // basic primvars from the instances
-        auto instancer = dynamic_cast<HdCyclesInstancer*>(sceneDelegate->GetRenderIndex().GetInstancer(instancer_id));
-        if (instancer) {
-            std::vector<HdPrimvarDescriptor> descriptors
-                = sceneDelegate->GetPrimvarDescriptors(instancer_id, HdInterpolationInstance);
-            for (auto& desc : descriptors) {
-                if (desc.name == HdTokens->displayColor) {
-                    VtValue displayColor = sceneDelegate->Get(instancer_id, HdTokens->displayColor);
-                    if (displayColor.GetArraySize() != m_cyclesInstances.size()
-                        || !displayColor.IsHolding<VtVec3fArray>()) {
-                        continue;
-                    }
+    if (!deformOnly && (*dirtyBits & HdChangeTracker::DirtyPrimvar)) {
+        _PublishPrimvars(scene, id);
+    }
 
-                    const auto& colorValues = displayColor.Get<VtVec3fArray>();
-                    for (size_t i = 0; i < m_cyclesInstances.size(); ++i) {
-                        ccl::Object& instance = m_cyclesInstances[i];
-                        const GfVec3f& value = colorValues[i];
-                        instance.color[0] = value[0];
-                        instance.color[1] = value[1];
-                        instance.color[2] = value[2];
-                    }
-                    continue;
-                }
-            }
+    if (transform_source) {
+        m_object_source->AddObjectPropertiesSource(std::move(transform_source));
+    }
+
+    if (!deformOnly && (*dirtyBits & HdChangeTracker::DirtyPrimID)) {
+        // Offset of 1 added because Cycles primId pass needs to be shifted down to -1
+        m_cyclesObject->pass_id = this->GetPrimId() + 1;
+    }
+
+    if (*dirtyBits & DirtyBits::DirtyTangents) {
+        _PublishTangents(scene);
+    }
+
+    if (!deformOnly) {
+        if (instancer_dirty) {
+            // remove prototype from list of objects to render
+            m_renderDelegate->GetCyclesRenderParam()->RemoveObject(m_cyclesObject);
+        }
+
+        if (update_instances) {
+            m_instances.Commit(scene, m_cyclesMesh, *m_cyclesObject);
         }
     }
 
-    _FinishMesh(scene);
-    _UpdateObject(scene, param, dirtyBits, topologyIsDirty);
+    _FinishMesh(scene, deformOnly);
+
+    // Geometry tagged without a rebuild is refit by Cycles when the dynamic BVH is used, static BVH is always
+    // rebuilt. Points only updates never change the topology, they are refit unless motion blur layout has changed.
+    const bool rebuildBvh = topologyIsDirty || motionLayoutChanged;
+    _UpdateObject(scene, param, dirtyBits, rebuildBvh);
     *dirtyBits = HdChangeTracker::Clean;
+
+    publish_timer.Stop();
+
+    TF_DEBUG(HDCYCLES_SYNC_TIMINGS)
+        .Msg("Mesh sync %s%s: settings %.3f ms, fetch %.3f ms, publish %.3f ms\n", id.GetText(),
+             deformOnly ? " (deform)" : "", settings_timer.GetMilliseconds(), fetch_timer.GetMilliseconds(),
+             publish_timer.GetMilliseconds());
 }
 
 void
@@ -23,10 +23,13 @@
 #include "utils.h"
 
 #include "hdcycles.h"
+#include "instanceArray.h"
 #include "meshRefiner.h"
 #include "objectSource.h"
 #include "rprim.h"
 
+#include <render/attribute.h>
+#include <util/util_array.h>
 #include <util/util_transform.h>
 
 #include <pxr/base/gf/matrix4d.h>
@@ -44,6 +47,7 @@ namespace ccl {
 class Scene;
 class Mesh;
 class Object;
+class Shader;
 }  // namespace ccl
 
 PXR_NAMESPACE_OPEN_SCOPE
@@ -118,24 +122,25 @@ protected:
      * @brief Perform final mesh computations (bounds, tangents, etc)
      * 
      * @param scene 
+     * @param deformOnly only points have changed, existing generated coordinates are kept
      */
-    void _FinishMesh(ccl::Scene* scene);
+    void _FinishMesh(ccl::Scene* scene, bool deformOnly = false);
 
     /**
-     * @brief Add abitrary uv set
+     * @brief Refine abitrary uv set into the face varying staging buffer. Lock free, does not touch the cycles mesh
      * 
      * @param name 
      * @param uvs 
      * @param interpolation 
+     * @param refined vertex uvs are already refined, e.g. in a batch with other vertex primvars
      */
-    void _AddUVSet(const TfToken& name, const VtValue& uvs, ccl::Scene* scene, HdInterpolation interpolation);
+    void _FetchUVSet(const TfToken& name, const VtValue& uvs, HdInterpolation interpolation, bool refined = false);
 
     /**
-     * @brief Add vertex/face normals (Not implemented)
+     * @brief Add staged uv sets requested by the shaders. Must be called under the scene lock
      * 
-     * @param normals 
-     * @param interpolation 
      */
+    void _PublishUVSets(ccl::Scene* scene);
 
     /**
      * @brief Add vertex velocities
@@ -155,16 +160,21 @@ protected:
     void _AddAccelerations(const SdfPath& id, const VtValue& value, HdInterpolation interpolation);
 
     /**
-     * @brief Add vertex/primitive colors
+     * @brief Stage object display color or create color attribute source. Lock free, does not touch the cycles mesh
      * TODO: This handles more than just colors, we should probably refactor
      * 
      * @param name 
      * @param colors 
-     * @param scene 
      * @param interpolation 
      */
-    void _PopulateColors(const TfToken& name, const TfToken& role, const VtValue& data, ccl::Scene* scene,
-                         HdInterpolation interpolation, const SdfPath& id);
+    void _FetchColors(const TfToken& name, const TfToken& role, const VtValue& data, HdInterpolation interpolation,
+                      const SdfPath& id);
+
+    /**
+     * @brief Assign staged object display color. Must be called under the scene lock
+     * 
+     */
+    void _PublishColors(ccl::Scene* scene);
 
 private:
     struct PrimvarSource {
@@ -202,32 +212,115 @@ private:
     HdCyclesMesh& operator=(const HdCyclesMesh&) = delete;
 
     /**
-     * @brief Populate vertices of cycles mesh
+     * @brief Sample and refine motion points into the staging buffer. Lock free, does not touch the cycles mesh
+     * 
+     */
+    void _FetchMotion(HdSceneDelegate* sceneDelegate, const SdfPath& id);
+
+    /**
+     * @brief Move staged motion points into the cycles mesh. Must be called under the scene lock
+     * 
+     * @return true if motion blur or the number of motion steps has changed, the BVH can't be refit
+     */
+    bool _PublishMotion();
+
+    /**
+     * @brief Sample and refine motion steps of a vec3f primvar into the staging buffer, center step excluded.
+     * Lock free, does not touch the cycles mesh
+     * 
+     */
+    void _FetchMotionAttributeVec3f(HdSceneDelegate* sceneDelegate, const SdfPath& id, const TfToken& token,
+                                    const TfToken& role, const HdInterpolation& interpolation_refine,
+                                    const HdInterpolation& interpolation, size_t n_expected_samples,
+                                    ccl::array<ccl::float3>* motion_data);
+
+    /**
+     * @brief Create topology and refiner. Lock free, does not touch the cycles mesh
+     * 
+     */
+    void _FetchTopology(HdSceneDelegate* sceneDelegate, const SdfPath& id);
+
+    /**
+     * @brief Resize cycles mesh and copy triangulated topology. Must be called under the scene lock
+     * 
+     */
+    void _PublishTopology();
+
+    /**
+     * @brief Refine points and limit surface into the staging buffer. Lock free, does not touch the cycles mesh
+     * 
+     */
+    void _FetchVertices(HdSceneDelegate* sceneDelegate, const SdfPath& id, HdDirtyBits* dirtyBits);
+
+    /**
+     * @brief Swap staged points into the cycles mesh. Must be called under the scene lock
+     * 
+     */
+    void _PublishVertices();
+
+    /**
+     * @brief Refine authored or limit surface normals into the staging buffers. Lock free, does not touch the
+     * cycles mesh
+     * 
+     */
+    void _FetchNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id);
+
+    /**
+     * @brief Replace normal attributes with the staged ones. Must be called under the scene lock
+     * 
+     */
+    void _PublishNormals(const SdfPath& id);
+
+    /**
+     * @brief Stage per corner limit surface tangents. Lock free, does not touch the cycles mesh
+     * 
+     */
+    void _FetchTangents();
+
+    /**
+     * @brief Add tangents requested by the shaders. Mikk tangents are computed here from the published mesh.
+     * Must be called under the scene lock
      * 
      */
+    void _PublishTangents(ccl::Scene* scene);
 
-    void _PopulateMotion(HdSceneDelegate* sceneDelegate, const SdfPath& id);
-    void _PopulateMotionAttributeVec3f(HdSceneDelegate* sceneDelegate, const SdfPath& id, const TfToken& token,
-                                       const TfToken& role, const HdInterpolation& interpolation_refine,
-                                       const HdInterpolation& interpolation, int cycles_motion_attribute,
-                                       size_t n_expected_samples);
+    /**
+     * @brief Resolve shaders and refined per face shader ids. Lock free, does not touch the cycles mesh
+     * 
+     */
+    void _FetchMaterials(HdSceneDelegate* sceneDelegate, ccl::Shader* default_surface, const SdfPath& id);
+    void _FetchObjectMaterial(HdSceneDelegate* sceneDelegate, const SdfPath& id);
+    void _FetchSubSetsMaterials(HdSceneDelegate* sceneDelegate, const SdfPath& id);
 
-    void _PopulateTopology(HdSceneDelegate* sceneDelegate, const SdfPath& id);
-    void _PopulateVertices(HdSceneDelegate* sceneDelegate, const SdfPath& id, HdDirtyBits* dirtyBits);
-    void _PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath& id);
-    void _PopulateTangents(HdSceneDelegate* sceneDelegate, const SdfPath& id, ccl::Scene* scene);
+    /**
+     * @brief Assign staged shaders to the cycles mesh. Must be called under the scene lock
+     * 
+     */
+    void _PublishMaterials(HdCyclesRenderParam* renderParam);
 
-    void _PopulateMaterials(HdSceneDelegate* sceneDelegate, HdCyclesRenderParam* renderParam,
-                            ccl::Shader* default_surface, const SdfPath& id);
-    void _PopulateObjectMaterial(HdSceneDelegate* sceneDelegate, const SdfPath& id);
-    void _PopulateSubSetsMaterials(HdSceneDelegate* sceneDelegate, const SdfPath& id);
+    /**
+     * @brief Convert dirty primvars into staging buffers and attribute sources. Lock free, does not touch the
+     * cycles mesh
+     * 
+     */
+    void _FetchPrimvars(HdSceneDelegate* sceneDelegate, const SdfPath& id, HdDirtyBits* dirtyBits);
 
-    void _PopulatePrimvars(HdSceneDelegate* sceneDelegate, ccl::Scene* scene, const SdfPath& id,
-                           HdDirtyBits* dirtyBits);
+    /**
+     * @brief Add staged primvars to the cycles mesh. Must be called under the scene lock
+     * 
+     */
+    void _PublishPrimvars(ccl::Scene* scene, const SdfPath& id);
 
 
     void _UpdateObject(ccl::Scene* scene, HdCyclesRenderParam* param, HdDirtyBits* dirtyBits, bool rebuildBvh);
 
+    /**
+     * @brief Check if only the deformation has changed. Topology, primvars, materials and instancing are clean,
+     * the update can be done by swapping points and refitting the BVH
+     * 
+     */
+    static bool _IsDeformOnly(HdDirtyBits bits);
+
     /**
      * @brief Populate generated coordinates attribute
      * 
@@ -241,7 +334,7 @@ private:
     HdCyclesObjectSourceSharedPtr m_object_source;
 
     ccl::Mesh* m_cyclesMesh;
-    std::vector<ccl::Object> m_cyclesInstances;
+    HdCyclesInstanceArray m_instances;
 
     ccl::Shader* m_object_display_color_shader;
     ccl::Shader* m_attrib_display_color_shader;
@@ -249,15 +342,50 @@ private:
     HdTimeSampleArray<GfMatrix4d, HD_CYCLES_MOTION_STEPS> m_transformSamples;
 
     int m_refineLevel;
-    std::shared_ptr<HdBbMeshTopology> m_topology;
+    HdBbMeshTopologySharedPtr m_topology;
     bool m_useLimitSurfaceTangents;
 
+    // Normals are authored by the primvar and do not have to be regenerated when only the points change
+    bool m_hasAuthoredNormals;
+
     float m_velocityScale;
 
     std::vector<ccl::ustring> m_texture_names;
     VtFloat3Array m_limit_us;
     VtFloat3Array m_limit_vs;
 
+    // Staging buffers filled lock free during the fetch stage and moved into m_cyclesMesh when published
+    ccl::array<ccl::float3> m_staged_verts;
+    ccl::array<ccl::float3> m_staged_motion_verts;
+    unsigned int m_staged_motion_steps;
+
+    ObjectSettings m_staged_settings;
+
+    // Normals attribute, ATTR_STD_NONE with m_staged_generate_normals asks Cycles for smooth normals
+    ccl::AttributeStandard m_staged_normals_std;
+    ccl::array<ccl::float3> m_staged_normals;
+    ccl::AttributeStandard m_staged_motion_normals_std;
+    ccl::array<ccl::float3> m_staged_motion_normals;
+    bool m_staged_generate_normals;
+
+    ccl::vector<ccl::Shader*> m_staged_shaders;
+    ccl::array<int> m_staged_shader_ids;
+
+    // Face varying uv sets, added only if shaders request them
+    std::vector<std::pair<ccl::ustring, ccl::array<ccl::float2>>> m_staged_uvs;
+    ccl::array<ccl::float3> m_staged_limit_tangents;
+
+    bool m_staged_has_display_color;
+    ccl::float3 m_staged_display_color;
+
+    struct StagedPrimvar {
+        VtValue value;
+        HdInterpolation interpolation;
+    };
+    // Velocities and accelerations as authored, converted when published since they depend on motion points
+    std::vector<StagedPrimvar> m_staged_velocities;
+    std::vector<StagedPrimvar> m_staged_accelerations;
+
     HdCyclesRenderDelegate* m_renderDelegate;
 };
 
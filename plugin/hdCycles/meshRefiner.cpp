@@ -18,10 +18,13 @@
 //  limitations under the License.
 
 #include "meshRefiner.h"
+#include "config.h"
+#include "utils.h"
 
 #include <pxr/base/gf/matrix3f.h>
 #include <pxr/base/gf/matrix4f.h>
 #include <pxr/base/gf/vec2f.h>
+#include <pxr/base/tf/smallVector.h>
 #include <pxr/imaging/hd/changeTracker.h>
 #include <pxr/imaging/hd/meshUtil.h>
 #include <pxr/imaging/pxOsd/refinerFactory.h>
@@ -36,14 +39,18 @@
 #include <opensubdiv/osd/cpuPatchTable.h>
 #include <opensubdiv/osd/cpuVertexBuffer.h>
 
+#include <util/util_math_float3.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <cstring>
 #include <numeric>
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
 using namespace OpenSubdiv;
 
-#define EVALUATOR Osd::CpuEvaluator
-
 namespace {
 
 HdMeshTopology
@@ -84,8 +91,8 @@ public:
 
     bool IsSubdivided() const override { return false; }
 
-    void EvaluateLimit(const VtFloat3Array& refined_vertices, VtFloat3Array& limit_ps, VtFloat3Array& limit_du,
-                       VtFloat3Array& limit_dv) const override
+    void EvaluateLimit(const ccl::float3* refined_vertices, ccl::float3* limit_ps, ccl::float3* limit_du,
+                       ccl::float3* limit_dv) const override
     {
     }
 
@@ -154,6 +161,25 @@ public:
         return data;
     }
 
+    bool RefinePoints(const TfToken& name, const VtVec3fArray& points, ccl::float3* refined_points,
+                      size_t num_refined_points) const override
+    {
+        if (points.size() != static_cast<size_t>(m_topology->GetNumPoints())
+            || points.size() != static_cast<size_t>(m_triangulated_topology.GetNumPoints())) {
+            TF_WARN("Unsupported input data size for vertex refinement for primvar %s at %s", name.GetText(),
+                    m_topology->GetId().GetPrimPath().GetString().c_str());
+            return false;
+        }
+
+        if (!TF_VERIFY(num_refined_points == points.size(), "Refined points destination size mismatch at %s",
+                       m_topology->GetId().GetPrimPath().GetString().c_str())) {
+            return false;
+        }
+
+        vec3f_to_float3(points.cdata(), refined_points, points.size());
+        return true;
+    }
+
     VtValue RefineFaceVaryingData(const TfToken& name, const TfToken& role, const VtValue& data) const override
     {
         if (data.GetArraySize() != static_cast<size_t>(m_topology->GetNumFaceVaryings())) {
@@ -273,6 +299,74 @@ private:
     std::vector<int> m_ptex_index_to_base_index;
 };
 
+///
+/// \brief Stencil evaluation backend, selected with HD_CYCLES_SUBDIVISION_EVALUATOR
+///
+enum class SubdEvaluator {
+    Cpu,  // Osd::CpuEvaluator, single threaded
+    Tbb,  // stencils evaluated in parallel chunks
+};
+
+SubdEvaluator
+GetSubdEvaluator()
+{
+    static const SubdEvaluator evaluator = [] {
+        const std::string& name = HdCyclesConfig::GetInstance().subdivision_evaluator.value;
+        if (name == "CPU") {
+            return SubdEvaluator::Cpu;
+        }
+        if (name != "TBB") {
+            TF_WARN("Unknown subdivision evaluator %s, falling back to TBB", name.c_str());
+        }
+        return SubdEvaluator::Tbb;
+    }();
+    return evaluator;
+}
+
+///
+/// \brief Evaluates stencils for every element described by the descriptors
+///
+/// Tbb path requires stencil offsets, each stencil writes only to its own destination element, therefore chunks
+/// can be evaluated independently.
+///
+void
+EvalStencils(const float* src, const Osd::BufferDescriptor& src_desc, float* dst, const Osd::BufferDescriptor& dst_desc,
+             const Far::StencilTable* stencil_table)
+{
+    HD_TRACE_FUNCTION();
+
+    if (GetSubdEvaluator() == SubdEvaluator::Cpu || stencil_table->GetOffsets().empty()) {
+        RawCpuBuffer<const float> src_buffer(src);
+        RawCpuBuffer<float> dst_buffer(dst);
+        Osd::CpuEvaluator::EvalStencils(&src_buffer, src_desc, &dst_buffer, dst_desc, stencil_table);
+        return;
+    }
+
+    const int* sizes = stencil_table->GetSizes().data();
+    const Far::Index* offsets = stencil_table->GetOffsets().data();
+    const Far::Index* indices = stencil_table->GetControlIndices().data();
+    const float* weights = stencil_table->GetWeights().data();
+
+    static constexpr int grain_size = 256;
+    tbb::parallel_for(tbb::blocked_range<int>(0, stencil_table->GetNumStencils(), grain_size),
+                      [&](const tbb::blocked_range<int>& range) {
+                          for (int stencil = range.begin(); stencil < range.end(); ++stencil) {
+                              float* dst_element = dst + dst_desc.offset + stencil * dst_desc.stride;
+                              std::fill(dst_element, dst_element + dst_desc.length, 0.0f);
+
+                              const int begin = offsets[stencil];
+                              const int end = begin + sizes[stencil];
+                              for (int i = begin; i < end; ++i) {
+                                  const float* src_element = src + src_desc.offset + indices[i] * src_desc.stride;
+                                  const float weight = weights[i];
+                                  for (int c = 0; c < dst_desc.length; ++c) {
+                                      dst_element[c] += weight * src_element[c];
+                                  }
+                              }
+                          }
+                      });
+}
+
 template<typename T>
 VtArray<T>
 RefineArrayWithStencils(const VtArray<T>& input, const Far::StencilTable* stencil_table, int stride)
@@ -281,10 +375,8 @@ RefineArrayWithStencils(const VtArray<T>& input, const Far::StencilTable* stenci
     Osd::BufferDescriptor src_descriptor(0, stride, stride);
     Osd::BufferDescriptor dst_descriptor(0, stride, stride);
 
-    RawCpuBuffer<const float> src_buffer(reinterpret_cast<const float*>(input.data()));
-    RawCpuBuffer<float> dst_buffer(reinterpret_cast<float*>(refined_array.data()));
-
-    EVALUATOR::EvalStencils(&src_buffer, src_descriptor, &dst_buffer, dst_descriptor, stencil_table);
+    EvalStencils(reinterpret_cast<const float*>(input.data()), src_descriptor,
+                 reinterpret_cast<float*>(refined_array.data()), dst_descriptor, stencil_table);
     return refined_array;
 }
 
@@ -311,6 +403,97 @@ RefineWithStencils(const VtValue& input, const Far::StencilTable* stencil_table)
     }
 }
 
+template<typename T>
+VtValue
+DeinterleaveArray(const std::vector<float>& interleaved, size_t num_elements, int stride, int offset)
+{
+    VtArray<T> array(num_elements);
+    auto data = reinterpret_cast<float*>(array.data());
+    const auto length = static_cast<int>(sizeof(T) / sizeof(float));
+
+    for (size_t i = 0; i < num_elements; ++i) {
+        const float* src = interleaved.data() + i * static_cast<size_t>(stride) + static_cast<size_t>(offset);
+        std::copy(src, src + length, data + i * static_cast<size_t>(length));
+    }
+
+    return VtValue { array };
+}
+
+///
+/// \brief Refines float primvars with one stencil pass over an interleaved buffer
+///
+/// Stencil traversal (sizes, indices and weights) dominates the evaluation cost for small primvars, interleaving
+/// makes it independent of the number of primvars. Non float primvars go through RefineWithStencils.
+///
+std::vector<VtValue>
+RefineInterleavedWithStencils(const std::vector<VtValue>& inputs, const Far::StencilTable* stencil_table)
+{
+    std::vector<VtValue> refined(inputs.size());
+    std::vector<int> offsets(inputs.size(), -1);
+
+    int stride = 0;
+    size_t num_interleaved = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].IsEmpty()) {
+            continue;
+        }
+
+        const HdType type = HdGetValueTupleType(inputs[i]).type;
+        if (type != HdTypeFloat && type != HdTypeFloatVec2 && type != HdTypeFloatVec3 && type != HdTypeFloatVec4) {
+            refined[i] = RefineWithStencils(inputs[i], stencil_table);
+            continue;
+        }
+
+        offsets[i] = stride;
+        stride += static_cast<int>(HdGetComponentCount(type));
+        ++num_interleaved;
+    }
+
+    // nothing to gain from interleaving a single primvar
+    if (num_interleaved <= 1) {
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (offsets[i] >= 0) {
+                refined[i] = RefineWithStencils(inputs[i], stencil_table);
+            }
+        }
+        return refined;
+    }
+
+    const auto num_coarse = static_cast<size_t>(stencil_table->GetNumControlVertices());
+    const auto num_refined = static_cast<size_t>(stencil_table->GetNumStencils());
+
+    std::vector<float> src(num_coarse * static_cast<size_t>(stride));
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (offsets[i] < 0) {
+            continue;
+        }
+
+        const auto length = static_cast<size_t>(HdGetComponentCount(HdGetValueTupleType(inputs[i]).type));
+        const auto data = static_cast<const float*>(HdGetValueData(inputs[i]));
+        const size_t num_elements = std::min(num_coarse, inputs[i].GetArraySize());
+        for (size_t e = 0; e < num_elements; ++e) {
+            std::copy(data + e * length, data + (e + 1) * length,
+                      src.data() + e * static_cast<size_t>(stride) + static_cast<size_t>(offsets[i]));
+        }
+    }
+
+    std::vector<float> dst(num_refined * static_cast<size_t>(stride));
+    Osd::BufferDescriptor descriptor(0, stride, stride);
+    EvalStencils(src.data(), descriptor, dst.data(), descriptor, stencil_table);
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        switch (offsets[i] < 0 ? HdTypeInvalid : HdGetValueTupleType(inputs[i]).type) {
+        case HdTypeFloat: refined[i] = DeinterleaveArray<float>(dst, num_refined, stride, offsets[i]); break;
+        case HdTypeFloatVec2: refined[i] = DeinterleaveArray<GfVec2f>(dst, num_refined, stride, offsets[i]); break;
+        case HdTypeFloatVec3: refined[i] = DeinterleaveArray<GfVec3f>(dst, num_refined, stride, offsets[i]); break;
+        case HdTypeFloatVec4: refined[i] = DeinterleaveArray<GfVec4f>(dst, num_refined, stride, offsets[i]); break;
+        default: break;
+        }
+    }
+
+    return refined;
+}
+
 ///
 ///
 ///
@@ -325,6 +508,22 @@ public:
 
     VtValue RefineArray(const VtValue& input) const { return RefineWithStencils(input, m_stencils.get()); }
 
+    std::vector<VtValue> RefineArrays(const std::vector<VtValue>& inputs) const
+    {
+        return RefineInterleavedWithStencils(inputs, m_stencils.get());
+    }
+
+    void RefinePoints(const VtVec3fArray& points, ccl::float3* refined_points) const
+    {
+        // padding of the Cycles float3 is not touched by the evaluator
+        std::memset(static_cast<void*>(refined_points), 0, Size() * sizeof(ccl::float3));
+
+        Osd::BufferDescriptor src_descriptor(0, 3, 3);
+        Osd::BufferDescriptor dst_descriptor(0, 3, static_cast<int>(sizeof(ccl::float3) / sizeof(float)));
+        EvalStencils(reinterpret_cast<const float*>(points.cdata()), src_descriptor,
+                     reinterpret_cast<float*>(refined_points), dst_descriptor, m_stencils.get());
+    }
+
     size_t Size() const { return static_cast<size_t>(m_stencils->GetNumStencils()); }
 
 private:
@@ -394,10 +593,8 @@ private:
             Osd::BufferDescriptor src_descriptor(0, stride, stride);
             Osd::BufferDescriptor dst_descriptor(0, stride, stride);
 
-            RawCpuBuffer<const float> src_buffer(reinterpret_cast<const float*>(input.data()));
-            RawCpuBuffer<float> dst_buffer(reinterpret_cast<float*>(refined_data.data()));
-
-            EVALUATOR::EvalStencils(&src_buffer, src_descriptor, &dst_buffer, dst_descriptor, m_stencils.get());
+            EvalStencils(reinterpret_cast<const float*>(input.data()), src_descriptor,
+                         reinterpret_cast<float*>(refined_data.data()), dst_descriptor, m_stencils.get());
         }
 
         // TODO: Data evaluation should happen through EvalPatchesPrimVar
@@ -417,173 +614,277 @@ private:
 };
 
 ///
-/// \brief limit refiner computes surface normal
+/// \brief limit refiner computes limit positions and tangents used for the surface normal
+///
+/// Limit masks are captured once from Far::PrimvarRefiner::Limit into sparse stencils over the refined vertices,
+/// every evaluation is then a parallel weighted sum written straight to the destination buffers.
 ///
 class SubdLimitRefiner {
 public:
     explicit SubdLimitRefiner(const Far::TopologyRefiner& refiner)
-        : m_primvar_refiner { refiner }
     {
-    }
+        HD_TRACE_FUNCTION();
 
-    ///  wrapper for cycles float3, stride is 4 but weights are computed with
-    struct Float3fPrimvar {
-        Float3fPrimvar() { Clear(); }
+        const Far::TopologyLevel& last_level = refiner.GetLevel(refiner.GetMaxLevel());
+        const auto num_vertices = static_cast<size_t>(last_level.GetNumVertices());
 
-        explicit Float3fPrimvar(const float* srcPtr)
-        {
-            for (int i = 0; i < 3; ++i)
-                v[i] = srcPtr[i];
+        std::vector<LimitIndex> src(num_vertices);
+        for (size_t i = 0; i < num_vertices; ++i) {
+            src[i].index = static_cast<int>(i);
         }
 
-        Float3fPrimvar(const Float3fPrimvar& src)
+        std::vector<LimitMask> ps(num_vertices);
+        std::vector<LimitMask> du(num_vertices);
+        std::vector<LimitMask> dv(num_vertices);
+
+        Far::PrimvarRefiner primvar_refiner { refiner };
+        primvar_refiner.Limit(src, ps, du, dv);
+
+        m_ps.Build(ps);
+        m_du.Build(du);
+        m_dv.Build(dv);
+    }
+
+    size_t Size() const { return m_ps.Size(); }
+
+    void EvaluateLimit(const ccl::float3* refined_vertices, ccl::float3* limit_ps, ccl::float3* limit_du,
+                       ccl::float3* limit_dv) const
+    {
+        HD_TRACE_FUNCTION();
+
+        static constexpr size_t grain_size = 1024;
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, Size(), grain_size),
+                          [&](const tbb::blocked_range<size_t>& range) {
+                              for (size_t i = range.begin(); i < range.end(); ++i) {
+                                  limit_ps[i] = m_ps.Evaluate(refined_vertices, i);
+                                  limit_du[i] = m_du.Evaluate(refined_vertices, i);
+                                  limit_dv[i] = m_dv.Evaluate(refined_vertices, i);
+                              }
+                          });
+    }
+
+private:
+    /// source primvar for mask capture, carries only the index of the refined vertex
+    struct LimitIndex {
+        int index = 0;
+    };
+
+    /// destination primvar for mask capture, accumulates weights per refined vertex
+    struct LimitMask {
+        void Clear() { weights.clear(); }
+
+        void AddWithWeight(const LimitIndex& src, float weight)
         {
-            for (int i = 0; i < 3; ++i) {
-                v[i] = src.v[i];
+            for (auto& entry : weights) {
+                if (entry.first == src.index) {
+                    entry.second += weight;
+                    return;
+                }
             }
+            weights.emplace_back(src.index, weight);
         }
 
-        void Clear()
+        TfSmallVector<std::pair<int, float>, 16> weights;
+    };
+
+    /// compressed limit masks, same layout as Far::StencilTable
+    struct LimitStencils {
+        void Build(const std::vector<LimitMask>& masks)
         {
-            for (int i = 0; i < 3; ++i) {
-                v[i] = 0;
+            offsets.resize(masks.size() + 1);
+            offsets[0] = 0;
+            for (size_t i = 0; i < masks.size(); ++i) {
+                offsets[i + 1] = offsets[i] + masks[i].weights.size();
+            }
+
+            indices.resize(offsets.back());
+            weights.resize(offsets.back());
+            for (size_t i = 0; i < masks.size(); ++i) {
+                size_t offset = offsets[i];
+                for (const auto& entry : masks[i].weights) {
+                    indices[offset] = entry.first;
+                    weights[offset] = entry.second;
+                    ++offset;
+                }
             }
         }
 
-        void AddWithWeight(const Float3fPrimvar& src, float weight)
+        size_t Size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+        ccl::float3 Evaluate(const ccl::float3* src, size_t i) const
         {
-            for (int i = 0; i < 3; ++i) {
-                v[i] += weight * src.v[i];
+            ccl::float3 result = ccl::make_float3(0.0f, 0.0f, 0.0f);
+            for (size_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+                result += weights[j] * src[indices[j]];
             }
+            return result;
         }
 
-        ccl::float3 v {};
+        std::vector<size_t> offsets;
+        std::vector<int> indices;
+        std::vector<float> weights;
     };
 
-    void EvaluateLimit(const VtFloat3Array& refined_vertices, VtFloat3Array& limit_ps, VtFloat3Array& limit_du,
-                       VtFloat3Array& limit_dv) const
-    {
-        auto refined_ps_primvar = reinterpret_cast<const Float3fPrimvar*>(refined_vertices.data());
-        auto limit_ps_primvar = reinterpret_cast<Float3fPrimvar*>(limit_ps.data());
-        auto limit_du_primvar = reinterpret_cast<Float3fPrimvar*>(limit_du.data());
-        auto limit_dv_primvar = reinterpret_cast<Float3fPrimvar*>(limit_dv.data());
+    LimitStencils m_ps;
+    LimitStencils m_du;
+    LimitStencils m_dv;
+};
 
-        m_primvar_refiner.Limit(refined_ps_primvar, limit_ps_primvar, limit_du_primvar, limit_dv_primvar);
-    }
+}  // namespace
 
-private:
-    Far::PrimvarRefiner m_primvar_refiner;
-};
+PXR_NAMESPACE_OPEN_SCOPE
 
 ///
-/// \brief Open Subdivision refiner implementation
+/// \brief OpenSubdiv refiner, patch and stencil tables
 ///
-class HdCyclesSubdRefiner final : public HdCyclesMeshRefiner {
-public:
-    explicit HdCyclesSubdRefiner(const HdBbMeshTopology& topology)
-        : m_topology { &topology }
-    {
-        HD_TRACE_FUNCTION();
+/// Tables depend on the subdivision topology and refine level only. Once created they are immutable, every
+/// refinement goes through const evaluation, that allows sharing them between meshes syncing in parallel.
+///
+struct HdCyclesSubdTables {
+    HdCyclesSubdTables(const SdfPath& id, const HdMeshTopology& topology);
 
-        // passing topology through refiner converts cw to ccw
-        {
-            HD_TRACE_SCOPE("create refiner")
+    HdMeshTopology osd_topology;
+    HdMeshTopology triangulated_topology;
+    VtIntArray prim_param;
 
-            std::vector<VtIntArray> fvar_topologies;
+    // necessary osd structures
+    PxOsdTopologyRefinerSharedPtr refiner;
+    std::unique_ptr<const Osd::CpuPatchTable> patch_table;
 
-            // Hd does not offer custom topologies to be passed to the refiner.
-            // Before data reaches to the Hd, every face varying data is un-indexed and flattened into one long array.
-            // This makes custom fvar topology gone and each patch becomes independent, discontinuous piece of mesh.
-            // Here we create custom topology with increasing indices. Depending on polygon orientation this topology
-            // can be reversed by the PxOsdRefinerFactory, and converted to ccw(right hand) if necessary.
-            // If Hd gets implementation to support custom face varying topologies, then we should pass each channel to
-            // the refiner.
-            VtIntArray fvar_indices(m_topology->GetFaceVertexIndices().size());
-            std::iota(fvar_indices.begin(), fvar_indices.end(), 0);
-            fvar_topologies.push_back(fvar_indices);
+    // Required
+    std::unique_ptr<SubdVertexRefiner> vertex;    // vertices
+    std::unique_ptr<SubdUniformRefiner> uniform;  // materials
 
-            m_refiner = PxOsdRefinerFactory::Create(topology.GetPxOsdMeshTopology(), fvar_topologies);
+    // Optional refiners depending on presence of PrimVars
+    std::unique_ptr<SubdLimitRefiner> limit;  // normals
+    std::unique_ptr<SubdVaryingRefiner> varying;
+    std::unique_ptr<SubdFVarRefiner> fvar;
+};
 
-            Far::TopologyRefiner::UniformOptions uniform_options { m_topology->GetRefineLevel() };
-            uniform_options.fullTopologyInLastLevel = true;
-            m_refiner->RefineUniform(uniform_options);
-        }
+HdCyclesSubdTables::HdCyclesSubdTables(const SdfPath& id, const HdMeshTopology& topology)
+{
+    HD_TRACE_FUNCTION();
 
-        // patches for face and materials lookup
-        {
-            HD_TRACE_SCOPE("create patch table")
+    // passing topology through refiner converts cw to ccw
+    {
+        HD_TRACE_SCOPE("create refiner")
+
+        std::vector<VtIntArray> fvar_topologies;
+
+        // Hd does not offer custom topologies to be passed to the refiner.
+        // Before data reaches to the Hd, every face varying data is un-indexed and flattened into one long array.
+        // This makes custom fvar topology gone and each patch becomes independent, discontinuous piece of mesh.
+        // Here we create custom topology with increasing indices. Depending on polygon orientation this topology
+        // can be reversed by the PxOsdRefinerFactory, and converted to ccw(right hand) if necessary.
+        // If Hd gets implementation to support custom face varying topologies, then we should pass each channel to
+        // the refiner.
+        VtIntArray fvar_indices(topology.GetFaceVertexIndices().size());
+        std::iota(fvar_indices.begin(), fvar_indices.end(), 0);
+        fvar_topologies.push_back(fvar_indices);
+
+        refiner = PxOsdRefinerFactory::Create(topology.GetPxOsdMeshTopology(), fvar_topologies);
+
+        Far::TopologyRefiner::UniformOptions uniform_options { topology.GetRefineLevel() };
+        uniform_options.fullTopologyInLastLevel = true;
+        refiner->RefineUniform(uniform_options);
+    }
 
-            // by default Far will not generate patches for all levels, triangulate quads option works for uniform subdivision only
-            Far::PatchTableFactory::Options patch_options(m_topology->GetRefineLevel());
-            patch_options.generateAllLevels = false;
-            patch_options.useInfSharpPatch = true;
+    // patches for face and materials lookup
+    {
+        HD_TRACE_SCOPE("create patch table")
 
-            // only if face varying is present
-            patch_options.generateFVarTables = true;
-            patch_options.numFVarChannels = m_refiner->GetNumFVarChannels();
-            int channel = 0;
-            patch_options.fvarChannelIndices = &channel;
+        // by default Far will not generate patches for all levels, triangulate quads option works for uniform subdivision only
+        Far::PatchTableFactory::Options patch_options(topology.GetRefineLevel());
+        patch_options.generateAllLevels = false;
+        patch_options.useInfSharpPatch = true;
 
-            std::unique_ptr<Far::PatchTable> far_patch_table { Far::PatchTableFactory::Create(*m_refiner,
-                                                                                              patch_options) };
-            m_patch_table = std::make_unique<Osd::CpuPatchTable>(far_patch_table.get());
-        }
+        // only if face varying is present
+        patch_options.generateFVarTables = true;
+        patch_options.numFVarChannels = refiner->GetNumFVarChannels();
+        int channel = 0;
+        patch_options.fvarChannelIndices = &channel;
 
-        // stencils required for primvar refinement
-        {
-            HD_TRACE_SCOPE("create stencil table")
+        std::unique_ptr<Far::PatchTable> far_patch_table { Far::PatchTableFactory::Create(*refiner, patch_options) };
+        patch_table = std::make_unique<Osd::CpuPatchTable>(far_patch_table.get());
+    }
 
-            // Shared options for all stencils
-            Far::StencilTableFactory::Options stencil_options;
-            stencil_options.generateIntermediateLevels = false;
-            stencil_options.generateOffsets = true;
+    // stencils required for primvar refinement
+    {
+        HD_TRACE_SCOPE("create stencil table")
 
-            // required stencils for vertex and normal computation
-            m_vertex = std::make_unique<SubdVertexRefiner>(*m_refiner, stencil_options);
-            m_uniform = std::make_unique<SubdUniformRefiner>(*m_refiner, m_patch_table.get());
+        // Shared options for all stencils
+        Far::StencilTableFactory::Options stencil_options;
+        stencil_options.generateIntermediateLevels = false;
+        stencil_options.generateOffsets = true;
 
-            // optional refiners depending on presence of PrimVars
-            m_limit = std::make_unique<SubdLimitRefiner>(*m_refiner);
-            m_varying = std::make_unique<SubdVaryingRefiner>(*m_refiner, stencil_options);
-            m_fvar = std::make_unique<SubdFVarRefiner>(*m_refiner, m_patch_table.get(), stencil_options);
-        }
+        // required stencils for vertex and normal computation
+        vertex = std::make_unique<SubdVertexRefiner>(*refiner, stencil_options);
+        uniform = std::make_unique<SubdUniformRefiner>(*refiner, patch_table.get());
 
-        // create Osd topology
-        {
-            HD_TRACE_SCOPE("create osd topology")
+        // optional refiners depending on presence of PrimVars
+        limit = std::make_unique<SubdLimitRefiner>(*refiner);
+        varying = std::make_unique<SubdVaryingRefiner>(*refiner, stencil_options);
+        fvar = std::make_unique<SubdFVarRefiner>(*refiner, patch_table.get(), stencil_options);
+    }
 
-            const Far::TopologyLevel& last_level = m_refiner->GetLevel(m_refiner->GetMaxLevel());
+    // create Osd topology
+    {
+        HD_TRACE_SCOPE("create osd topology")
 
-            VtIntArray patch_vertex_count;
-            patch_vertex_count.reserve(last_level.GetNumFaces());
-            VtIntArray patch_vertex_indices;
-            patch_vertex_indices.reserve(last_level.GetNumFaceVertices());
+        const Far::TopologyLevel& last_level = refiner->GetLevel(refiner->GetMaxLevel());
 
-            for (Far::Index face = 0; face < last_level.GetNumFaces(); ++face) {
-                Far::ConstIndexArray face_vertices = last_level.GetFaceVertices(face);
-                patch_vertex_count.push_back(face_vertices.size());
-                std::copy(face_vertices.begin(), face_vertices.end(), std::back_inserter(patch_vertex_indices));
-            }
+        VtIntArray patch_vertex_count;
+        patch_vertex_count.reserve(last_level.GetNumFaces());
+        VtIntArray patch_vertex_indices;
+        patch_vertex_indices.reserve(last_level.GetNumFaceVertices());
 
-            m_osd_topology = HdMeshTopology { PxOsdOpenSubdivTokens->none, PxOsdOpenSubdivTokens->rightHanded,
-                                              patch_vertex_count, patch_vertex_indices };
+        for (Far::Index face = 0; face < last_level.GetNumFaces(); ++face) {
+            Far::ConstIndexArray face_vertices = last_level.GetFaceVertices(face);
+            patch_vertex_count.push_back(face_vertices.size());
+            std::copy(face_vertices.begin(), face_vertices.end(), std::back_inserter(patch_vertex_indices));
         }
 
-        // create triangulated topology
-        {
-            VtVec3iArray triangle_indices;
-            HdMeshUtil mesh_util { &m_osd_topology, m_topology->GetId() };
-            mesh_util.ComputeTriangleIndices(&triangle_indices, &m_prim_param);
-            m_triangulated_topology = build_triangulated_topology(triangle_indices);
-        }
+        osd_topology = HdMeshTopology { PxOsdOpenSubdivTokens->none, PxOsdOpenSubdivTokens->rightHanded,
+                                        patch_vertex_count, patch_vertex_indices };
+    }
+
+    // create triangulated topology
+    {
+        VtVec3iArray triangle_indices;
+        HdMeshUtil mesh_util { &osd_topology, id };
+        mesh_util.ComputeTriangleIndices(&triangle_indices, &prim_param);
+        triangulated_topology = build_triangulated_topology(triangle_indices);
+    }
+}
+
+HdCyclesSubdTablesSharedPtr
+HdCyclesCreateSubdTables(const SdfPath& id, const HdMeshTopology& topology, int refine_level)
+{
+    return std::make_shared<const HdCyclesSubdTables>(id, HdMeshTopology { topology, refine_level });
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+namespace {
+
+///
+/// \brief Open Subdivision refiner implementation
+///
+class HdCyclesSubdRefiner final : public HdCyclesMeshRefiner {
+public:
+    HdCyclesSubdRefiner(const HdBbMeshTopology& topology, HdCyclesSubdTablesSharedPtr tables)
+        : m_topology { &topology }
+        , m_tables { std::move(tables) }
+    {
+        m_triangulated_topology = m_tables->triangulated_topology;
     }
 
     bool IsSubdivided() const override { return true; }
 
-    void EvaluateLimit(const VtFloat3Array& refined_vertices, VtFloat3Array& limit_ps, VtFloat3Array& limit_du,
-                       VtFloat3Array& limit_dv) const override
+    void EvaluateLimit(const ccl::float3* refined_vertices, ccl::float3* limit_ps, ccl::float3* limit_du,
+                       ccl::float3* limit_dv) const override
     {
-        m_limit->EvaluateLimit(refined_vertices, limit_ps, limit_du, limit_dv);
+        m_tables->limit->EvaluateLimit(refined_vertices, limit_ps, limit_du, limit_dv);
     }
 
     VtValue RefineConstantData(const TfToken& name, const TfToken& role, const VtValue& data) const override
@@ -599,7 +900,7 @@ public:
             return {};
         }
 
-        return m_uniform->RefineArray(data, m_prim_param);
+        return m_tables->uniform->RefineArray(data, m_tables->prim_param);
     }
 
     VtValue RefineVertexData(const TfToken& name, const TfToken& role, const VtValue& data) const override
@@ -610,7 +911,45 @@ public:
             return {};
         }
 
-        return m_vertex->RefineArray(data);
+        return m_tables->vertex->RefineArray(data);
+    }
+
+    bool RefinePoints(const TfToken& name, const VtVec3fArray& points, ccl::float3* refined_points,
+                      size_t num_refined_points) const override
+    {
+        if (points.size() != static_cast<size_t>(m_topology->GetNumPoints())) {
+            TF_WARN("Unsupported input data size for vertex refinement for primvar %s at %s", name.GetText(),
+                    m_topology->GetId().GetPrimPath().GetString().c_str());
+            return false;
+        }
+
+        // Evaluator writes one float3 per stencil
+        if (!TF_VERIFY(m_tables->vertex->Size() == num_refined_points,
+                       "Refined points destination size mismatch at %s",
+                       m_topology->GetId().GetPrimPath().GetString().c_str())) {
+            return false;
+        }
+
+        m_tables->vertex->RefinePoints(points, refined_points);
+        return true;
+    }
+
+    std::vector<VtValue> RefineVertexDataBatch(const TfToken& name, const TfToken& role,
+                                               const std::vector<VtValue>& data) const override
+    {
+        std::vector<VtValue> valid_data;
+        valid_data.reserve(data.size());
+        for (const VtValue& value : data) {
+            if (value.GetArraySize() != static_cast<size_t>(m_topology->GetNumPoints())) {
+                TF_WARN("Unsupported input data size for vertex refinement for primvar %s at %s", name.GetText(),
+                        m_topology->GetId().GetPrimPath().GetString().c_str());
+                valid_data.emplace_back();
+                continue;
+            }
+            valid_data.push_back(value);
+        }
+
+        return m_tables->vertex->RefineArrays(valid_data);
     }
 
     VtValue RefineVaryingData(const TfToken& name, const TfToken& role, const VtValue& data) const override
@@ -621,7 +960,7 @@ public:
             return {};
         }
 
-        return m_varying->RefineArray(data);
+        return m_tables->varying->RefineArray(data);
     }
 
     VtValue RefineFaceVaryingData(const TfToken& name, const TfToken& role, const VtValue& source) const override
@@ -633,10 +972,10 @@ public:
         }
 
         // No reverse is needed, since custom topology is reversed
-        auto refined_value = m_fvar->RefineArray(source);
+        auto refined_value = m_tables->fvar->RefineArray(source);
 
         // triangulate refinement for Cycles
-        HdMeshUtil mesh_util { &m_osd_topology, m_topology->GetId() };
+        HdMeshUtil mesh_util { &m_tables->osd_topology, m_topology->GetId() };
         VtValue triangulated;
         if (!mesh_util.ComputeTriangulatedFaceVaryingPrimvar(HdGetValueData(refined_value),
                                                              static_cast<int>(refined_value.GetArraySize()),
@@ -650,21 +989,7 @@ public:
 
 private:
     const HdBbMeshTopology* m_topology;
-    HdMeshTopology m_osd_topology;
-    VtIntArray m_prim_param;
-
-    // necessary osd structures
-    PxOsdTopologyRefinerSharedPtr m_refiner;
-    std::unique_ptr<const Osd::CpuPatchTable> m_patch_table;
-
-    // Required
-    std::unique_ptr<SubdVertexRefiner> m_vertex;    // vertices
-    std::unique_ptr<SubdUniformRefiner> m_uniform;  // materials
-
-    // Optional refiners depending on presence of PrimVars
-    std::unique_ptr<SubdLimitRefiner> m_limit;  // normals
-    std::unique_ptr<SubdVaryingRefiner> m_varying;
-    std::unique_ptr<SubdFVarRefiner> m_fvar;
+    HdCyclesSubdTablesSharedPtr m_tables;
 };
 
 }  // namespace
@@ -673,12 +998,34 @@ HdCyclesMeshRefiner::HdCyclesMeshRefiner() = default;
 
 HdCyclesMeshRefiner::~HdCyclesMeshRefiner() = default;
 
-HdBbMeshTopology::HdBbMeshTopology(const SdfPath& id, const HdMeshTopology& src, int refine_level)
+std::vector<VtValue>
+HdCyclesMeshRefiner::RefineVertexDataBatch(const TfToken& name, const TfToken& role,
+                                           const std::vector<VtValue>& data) const
+{
+    std::vector<VtValue> refined;
+    refined.reserve(data.size());
+    for (const VtValue& value : data) {
+        refined.push_back(RefineVertexData(name, role, value));
+    }
+    return refined;
+}
+
+bool
+HdBbMeshTopology::IsSubdivided(const HdMeshTopology& topology, int refine_level)
+{
+    return topology.GetScheme() == PxOsdOpenSubdivTokens->catmullClark && refine_level > 0;
+}
+
+HdBbMeshTopology::HdBbMeshTopology(const SdfPath& id, const HdMeshTopology& src, int refine_level,
+                                   HdCyclesSubdTablesSharedPtr subd_tables)
     : HdMeshTopology { src, refine_level }
     , m_id { id }
 {
-    if (GetScheme() == PxOsdOpenSubdivTokens->catmullClark && GetRefineLevel() > 0) {
-        m_refiner = std::make_unique<HdCyclesSubdRefiner>(*this);
+    if (IsSubdivided(*this, GetRefineLevel())) {
+        if (!subd_tables) {
+            subd_tables = std::make_shared<const HdCyclesSubdTables>(m_id, *this);
+        }
+        m_refiner = std::make_unique<HdCyclesSubdRefiner>(*this, std::move(subd_tables));
     } else {
         m_refiner = std::make_unique<HdCyclesTriangleRefiner>(*this);
     }
@@ -21,10 +21,12 @@
 #define HDCYCLES_MESHREFINER_H
 
 #include <pxr/base/vt/array.h>
+#include <pxr/base/vt/types.h>
 #include <pxr/imaging/hd/enums.h>
 #include <pxr/imaging/hd/meshTopology.h>
 
 #include <memory>
+#include <vector>
 
 #include <util/util_types.h>
 
@@ -42,6 +44,18 @@ class VtValue;
 class TfToken;
 class SdfPath;
 
+struct HdCyclesSubdTables;
+using HdCyclesSubdTablesSharedPtr = std::shared_ptr<const HdCyclesSubdTables>;
+
+///
+/// \brief Creates OpenSubdiv refiner, patch and stencil tables
+///
+/// Tables depend on the subdivision topology and refine level only, meshes that differ in geometry subsets or ids can
+/// share them. Id is used for diagnostics only.
+///
+HdCyclesSubdTablesSharedPtr
+HdCyclesCreateSubdTables(const SdfPath& id, const HdMeshTopology& topology, int refine_level);
+
 ///
 /// \brief Refines mesh to triangles
 ///
@@ -64,12 +78,24 @@ public:
     virtual VtValue RefineFaceVaryingData(const TfToken& name, const TfToken& role, const VtValue& data) const = 0;
     /// @}
 
+    /// \brief Refine points straight into Cycles layout. Destination holds one float3 per vertex of the triangulated
+    /// topology. Returns false if points or destination size do not match the topology.
+    virtual bool RefinePoints(const TfToken& name, const VtVec3fArray& points, ccl::float3* refined_points,
+                              size_t num_refined_points) const = 0;
+
+    /// \brief Refine several vertex primvars at once, e.g. motion samples. Result follows the order of the input,
+    /// values that failed to refine are empty.
+    virtual std::vector<VtValue> RefineVertexDataBatch(const TfToken& name, const TfToken& role,
+                                                       const std::vector<VtValue>& data) const;
+
     const HdMeshTopology& GetTriangulatedTopology() const { return m_triangulated_topology; }
 
     virtual bool IsSubdivided() const = 0;
 
-    virtual void EvaluateLimit(const VtFloat3Array& refined_vertices, VtFloat3Array& limit_ps, VtFloat3Array& limit_du,
-                               VtFloat3Array& limit_dv) const = 0;
+    /// \brief Evaluate limit positions and tangents. All buffers hold one element per vertex of the triangulated
+    /// topology, destination buffers must not alias the refined vertices.
+    virtual void EvaluateLimit(const ccl::float3* refined_vertices, ccl::float3* limit_ps, ccl::float3* limit_du,
+                               ccl::float3* limit_dv) const = 0;
 
     HdCyclesMeshRefiner(const HdCyclesMeshRefiner&) = delete;
     HdCyclesMeshRefiner(HdCyclesMeshRefiner&&) noexcept = delete;
@@ -88,7 +114,12 @@ protected:
 ///
 class HdBbMeshTopology : public HdMeshTopology {
 public:
-    HdBbMeshTopology(const SdfPath& id, const HdMeshTopology& src, int refine_level);
+    /// Subdivided topology uses given subd_tables, or creates its own when none are given
+    HdBbMeshTopology(const SdfPath& id, const HdMeshTopology& src, int refine_level,
+                     HdCyclesSubdTablesSharedPtr subd_tables = {});
+
+    /// Returns true if topology at given refine level is refined with OpenSubdiv
+    static bool IsSubdivided(const HdMeshTopology& topology, int refine_level);
 
     const SdfPath& GetId() const { return m_id; }
     const HdCyclesMeshRefiner* GetRefiner() const { return m_refiner.get(); }
@@ -98,6 +129,8 @@ private:
     std::unique_ptr<HdCyclesMeshRefiner> m_refiner;
 };
 
+using HdBbMeshTopologySharedPtr = std::shared_ptr<HdBbMeshTopology>;
+
 inline VtValue
 HdCyclesMeshRefiner::Refine(const TfToken& name, const TfToken& role, const VtValue& value,
                             const HdInterpolation& interpolation) const
@@ -44,11 +44,12 @@ interpolation_to_mesh_element(const HdInterpolation& interpolation)
 
 HdBbMeshAttributeSource::HdBbMeshAttributeSource(TfToken name, const TfToken& role, const VtValue& value,
                                                  ccl::Mesh* mesh, const HdInterpolation& interpolation,
-                                                 std::shared_ptr<HdBbMeshTopology> topology)
+                                                 std::shared_ptr<HdBbMeshTopology> topology, bool refined)
     : HdBbAttributeSource(std::move(name), role, value, &mesh->attributes, interpolation_to_mesh_element(interpolation),
                           GetTypeDesc(HdGetValueTupleType(value).type, role))
     , m_interpolation { interpolation }
     , m_topology { std::move(topology) }
+    , m_refined { refined }
 {
 }
 
@@ -60,10 +61,12 @@ HdBbMeshAttributeSource::Resolve()
     }
 
     // refine attribute
-    const ccl::TypeDesc& source_type_desc = GetSourceTypeDesc();
-    const VtValue source_value = m_value;
-    m_value = m_topology->GetRefiner()->Refine(GetName(), GetRole(source_type_desc), source_value,
-                                               GetInterpolation());
+    if (!m_refined) {
+        const ccl::TypeDesc& source_type_desc = GetSourceTypeDesc();
+        const VtValue source_value = m_value;
+        m_value = m_topology->GetRefiner()->Refine(GetName(), GetRole(source_type_desc), source_value,
+                                                   GetInterpolation());
+    }
 
     // late size check, since it is only known after refining
     if (!_CheckBuffersSize()) {
@@ -31,8 +31,10 @@ class HdBbMeshTopology;
 ///
 class HdBbMeshAttributeSource : public HdBbAttributeSource {
 public:
+    /// Value is refined when resolved, unless it is already refined for the topology, e.g. in a batch
     HdBbMeshAttributeSource(TfToken name, const TfToken& role, const VtValue& value, ccl::Mesh* mesh,
-                            const HdInterpolation& interpolation, std::shared_ptr<HdBbMeshTopology> topology);
+                            const HdInterpolation& interpolation, std::shared_ptr<HdBbMeshTopology> topology,
+                            bool refined = false);
 
     // Underlying VtValue has different size than ccl::Geometry, we have to accommodate for that.
     bool Resolve() override;
@@ -43,6 +45,7 @@ private:
 
     HdInterpolation m_interpolation;
     std::shared_ptr<HdBbMeshTopology> m_topology;
+    bool m_refined;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
@@ -74,6 +74,16 @@ HdCyclesObjectSource::AddAttributeSource(HdBbAttributeSourceSharedPtr source)
     return m_pending_attributes[name].get();
 }
 
+HdCyclesTransformSource*
+HdCyclesObjectSource::GetPendingTransformSource()
+{
+    auto it = m_pending_properties.find(HdTokens->transform);
+    if (it == m_pending_properties.end()) {
+        return nullptr;
+    }
+    return dynamic_cast<HdCyclesTransformSource*>(it->second.get());
+}
+
 const TfToken&
 HdCyclesObjectSource::GetName() const
 {
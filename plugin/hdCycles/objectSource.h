@@ -61,6 +61,9 @@ public:
         return AddAttributeSource(std::make_shared<T>(name, std::forward<Args>(args)...));
     }
 
+    /// Pending transform source, nullptr if transform is not pending
+    HdCyclesTransformSource* GetPendingTransformSource();
+
     const ccl::Object* GetObject() const { return m_object; }
     ccl::Object* GetObject() { return m_object; }
 
@@ -144,6 +144,8 @@ HdCyclesPoints::_PopulatePoints(HdSceneDelegate* sceneDelegate, const SdfPath& i
         return;
     }
 
+    // double and half points are converted with the array conversion kernels, other types go through VtValue casts
+    pointsValue = array_to_float_array(pointsValue);
     if (!pointsValue.IsHolding<VtVec3fArray>()) {
         if (!pointsValue.CanCast<VtVec3fArray>()) {
             m_cyclesPointCloud->clear();
@@ -165,9 +167,7 @@ HdCyclesPoints::_PopulatePoints(HdSceneDelegate* sceneDelegate, const SdfPath& i
         }
     }
 
-    for (size_t i = 0; i < points.size(); ++i) {
-        m_cyclesPointCloud->points[i] = vec3f_to_float3(points[i]);
-    }
+    vec3f_to_float3(points.cdata(), m_cyclesPointCloud->points.data(), points.size());
 }
 
 
@@ -188,6 +188,7 @@ HdCyclesPoints::_PopulateWidths(HdSceneDelegate* sceneDelegate, const SdfPath& i
         return;
     }
 
+    value_ = array_to_float_array(value_);
     if (!value_.IsHolding<VtFloatArray>()) {
         if (!value_.CanCast<VtFloatArray>()) {
             TF_WARN("Invalid point data! Can not convert widths for: %s", id.GetText());
@@ -232,6 +233,7 @@ HdCyclesPoints::_PopulateColors(HdSceneDelegate* sceneDelegate, const SdfPath& i
         reset_opacity = true;
     }
 
+    value_ = array_to_float_array(value_);
     if (!value_.IsHolding<VtVec3fArray>()) {
         if (!value_.CanCast<VtVec3fArray>()) {
             TF_WARN("Invalid point data! Can not convert colors for: %s", id.GetText());
@@ -290,6 +292,7 @@ HdCyclesPoints::_PopulateOpacities(HdSceneDelegate* sceneDelegate, const SdfPath
         return;
     }
 
+    value_ = array_to_float_array(value_);
     if (!value_.IsHolding<VtFloatArray>()) {
         if (!value_.CanCast<VtFloatArray>()) {
             TF_WARN("Invalid point data! Can not convert opacities for: %s", id.GetText());
@@ -339,6 +342,7 @@ HdCyclesPoints::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath&
         return;
     }
 
+    value_ = array_to_float_array(value_);
     if (!value_.IsHolding<VtVec3fArray>()) {
         if (!value_.CanCast<VtVec3fArray>()) {
             TF_WARN("Invalid normal type for point cloud %s", id.GetText());
@@ -361,9 +365,7 @@ HdCyclesPoints::_PopulateNormals(HdSceneDelegate* sceneDelegate, const SdfPath&
         }
     } else if (interpolation == HdInterpolationVertex) {
         assert(value.size() == m_cyclesPointCloud->points.size());
-        for (size_t i = 0; i < m_cyclesPointCloud->points.size(); ++i) {
-            N[i] = vec3f_to_float3(value[i]);
-        }
+        vec3f_to_float3(value.cdata(), N, m_cyclesPointCloud->points.size());
     } else {
         assert(false);
     }
@@ -388,6 +390,7 @@ HdCyclesPoints::_PopulateVelocities(HdSceneDelegate* sceneDelegate, const SdfPat
         return;
     }
 
+    value_ = array_to_float_array(value_);
     if (!value_.IsHolding<VtVec3fArray>()) {
         if (!value_.CanCast<VtVec3fArray>()) {
             TF_WARN("Invalid normal type for point cloud %s", id.GetText());
@@ -419,9 +422,7 @@ HdCyclesPoints::_PopulateVelocities(HdSceneDelegate* sceneDelegate, const SdfPat
         }
     } else if (interpolation == HdInterpolationVertex) {
         assert(value.size() == m_cyclesPointCloud->points.size());
-        for (int i = 0; i < m_cyclesPointCloud->points.size(); ++i) {
-            V[i] = vec3f_to_float3(value[i]);
-        }
+        vec3f_to_float3(value.cdata(), V, m_cyclesPointCloud->points.size());
     } else {
         assert(false);
     }
@@ -446,6 +447,7 @@ HdCyclesPoints::_PopulateAccelerations(HdSceneDelegate* sceneDelegate, const Sdf
                 _HdInterpolationStr(interpolation));
     }
 
+    value_ = array_to_float_array(value_);
     if (!value_.IsHolding<VtVec3fArray>()) {
         if (!value_.CanCast<VtVec3fArray>()) {
             TF_WARN("Invalid normal type for point cloud %s", id.GetText());
@@ -477,9 +479,7 @@ HdCyclesPoints::_PopulateAccelerations(HdSceneDelegate* sceneDelegate, const Sdf
         }
     } else if (interpolation == HdInterpolationVertex) {
         assert(value.size() == m_cyclesPointCloud->points.size());
-        for (int i = 0; i < m_cyclesPointCloud->points.size(); ++i) {
-            A[i] = vec3f_to_float3(value[i]);
-        }
+        vec3f_to_float3(value.cdata(), A, m_cyclesPointCloud->points.size());
     } else {
         assert(false);
     }
@@ -21,54 +21,167 @@
 #include "renderDelegate.h"
 #include "renderParam.h"
 #include "renderPass.h"
+#include "utils.h"
 
 #include <pxr/base/gf/vec2i.h>
 #include <pxr/base/gf/vec3i.h>
+#include <pxr/imaging/hd/perfLog.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
 namespace {
-template<typename T>
+
+// Tiles with more pixels than this are blitted in parallel, split by rows
+constexpr size_t HdCyclesBlitParallelPixels = 128 * 128;
+
+// Minimum number of pixels handled by a single task
+constexpr size_t HdCyclesBlitGrainPixels = 16 * 1024;
+
+float
+_ReadComponent(HdFormat componentFormat, uint8_t const* src, size_t c)
+{
+    switch (componentFormat) {
+    case HdFormatInt32: return static_cast<float>(reinterpret_cast<const int32_t*>(src)[c]);
+    case HdFormatFloat16: {
+        GfHalf half;
+        half.setBits(reinterpret_cast<const uint16_t*>(src)[c]);
+        return static_cast<float>(half);
+    }
+    case HdFormatFloat32: return reinterpret_cast<const float*>(src)[c];
+    case HdFormatUNorm8: return reinterpret_cast<const uint8_t*>(src)[c] / 255.0f;
+    case HdFormatSNorm8: return reinterpret_cast<const int8_t*>(src)[c] / 127.0f;
+    default: return 0.0f;
+    }
+}
+
+void
+_WriteComponent(HdFormat componentFormat, uint8_t* dst, size_t c, float value)
+{
+    switch (componentFormat) {
+    case HdFormatInt32: reinterpret_cast<int32_t*>(dst)[c] = static_cast<int32_t>(value); break;
+    case HdFormatFloat16: reinterpret_cast<uint16_t*>(dst)[c] = GfHalf(value).bits(); break;
+    case HdFormatFloat32: reinterpret_cast<float*>(dst)[c] = value; break;
+    case HdFormatUNorm8: float_to_unorm8(&value, dst + c, 1); break;
+    case HdFormatSNorm8: reinterpret_cast<int8_t*>(dst)[c] = static_cast<int8_t>(value * 127.0f); break;
+    default: break;
+    }
+}
+
+///
+/// Converts a contiguous row of pixels, missing components are zero filled
+///
 void
-_ConvertPixel(HdFormat dstFormat, uint8_t* dst, HdFormat srcFormat, uint8_t const* src)
-{
-    HdFormat srcComponentFormat = HdGetComponentFormat(srcFormat);
-    HdFormat dstComponentFormat = HdGetComponentFormat(dstFormat);
-    size_t srcComponentCount = HdGetComponentCount(srcFormat);
-    size_t dstComponentCount = HdGetComponentCount(dstFormat);
-
-    for (size_t c = 0; c < dstComponentCount; ++c) {
-        T readValue = 0;
-        if (c < srcComponentCount) {
-            if (srcComponentFormat == HdFormatInt32) {
-                readValue = static_cast<T>(reinterpret_cast<const int32_t*>(src)[c]);
-            } else if (srcComponentFormat == HdFormatFloat16) {
-                GfHalf half;
-                half.setBits(reinterpret_cast<const uint16_t*>(src)[c]);
-                readValue = static_cast<T>(half);
-            } else if (srcComponentFormat == HdFormatFloat32) {
-                // We need to subtract one from here due to cycles prim defaulting to 0 but hydra to -1
-                readValue = static_cast<T>(reinterpret_cast<const float*>(src)[c]);
-            } else if (srcComponentFormat == HdFormatUNorm8) {
-                readValue = static_cast<T>(reinterpret_cast<const uint8_t*>(src)[c] / 255.0f);
-            } else if (srcComponentFormat == HdFormatSNorm8) {
-                readValue = static_cast<T>(reinterpret_cast<const int8_t*>(src)[c] / 127.0f);
+_ConvertRow(HdFormat dstFormat, uint8_t* dst, HdFormat srcFormat, uint8_t const* src, size_t count,
+            std::vector<float>& scratch)
+{
+    const HdFormat srcComponentFormat = HdGetComponentFormat(srcFormat);
+    const HdFormat dstComponentFormat = HdGetComponentFormat(dstFormat);
+    const size_t srcComponentCount = HdGetComponentCount(srcFormat);
+    const size_t dstComponentCount = HdGetComponentCount(dstFormat);
+    const size_t srcPixelSize = HdDataSizeOfFormat(srcFormat);
+
+    // If src and dst are both int-based, don't round trip to float.
+    if (srcComponentFormat == HdFormatInt32 && dstComponentFormat == HdFormatInt32) {
+        auto src_values = reinterpret_cast<const int32_t*>(src);
+        auto dst_values = reinterpret_cast<int32_t*>(dst);
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t c = 0; c < dstComponentCount; ++c) {
+                dst_values[i * dstComponentCount + c] = c < srcComponentCount ? src_values[i * srcComponentCount + c]
+                                                                              : 0;
+            }
+        }
+        return;
+    }
+
+    // Source is expanded to float values in the destination layout, unless it already is
+    const size_t num_values = count * dstComponentCount;
+    const float* values = nullptr;
+    if (srcComponentFormat == HdFormatFloat32 && srcComponentCount == dstComponentCount) {
+        values = reinterpret_cast<const float*>(src);
+    } else {
+        scratch.resize(num_values);
+        if (srcComponentFormat == HdFormatFloat16 && srcComponentCount == dstComponentCount) {
+            half_to_float(reinterpret_cast<const GfHalf*>(src), scratch.data(), num_values);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t const* src_pixel = src + i * srcPixelSize;
+                for (size_t c = 0; c < dstComponentCount; ++c) {
+                    scratch[i * dstComponentCount + c] = c < srcComponentCount
+                                                             ? _ReadComponent(srcComponentFormat, src_pixel, c)
+                                                             : 0.0f;
+                }
             }
         }
+        values = scratch.data();
+    }
 
-        if (dstComponentFormat == HdFormatInt32) {
-            reinterpret_cast<int32_t*>(dst)[c] = static_cast<int32_t>(readValue);
-        } else if (dstComponentFormat == HdFormatFloat16) {
-            reinterpret_cast<uint16_t*>(dst)[c] = GfHalf(float(readValue)).bits();
-        } else if (dstComponentFormat == HdFormatFloat32) {
-            reinterpret_cast<float*>(dst)[c] = static_cast<float>(readValue);
-        } else if (dstComponentFormat == HdFormatUNorm8) {
-            reinterpret_cast<uint8_t*>(dst)[c] = static_cast<uint8_t>(static_cast<float>(readValue) * 255.0f);
-        } else if (dstComponentFormat == HdFormatSNorm8) {
-            reinterpret_cast<int8_t*>(dst)[c] = static_cast<int8_t>(static_cast<float>(readValue) * 127.0f);
+    switch (dstComponentFormat) {
+    case HdFormatFloat32: memcpy(dst, values, num_values * sizeof(float)); break;
+    case HdFormatFloat16: float_to_half(values, reinterpret_cast<GfHalf*>(dst), num_values); break;
+    case HdFormatUNorm8: float_to_unorm8(values, dst, num_values); break;
+    default:
+        for (size_t i = 0; i < num_values; ++i) {
+            _WriteComponent(dstComponentFormat, dst, i, values[i]);
         }
+        break;
     }
 }
+
+template<size_t N>
+void
+_GatherPixels(uint8_t* dst, uint8_t const* src, const unsigned int* columns, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(dst + i * N, src + columns[i] * N, N);
+    }
+}
+
+///
+/// Gathers scaled row pixels using precomputed source columns
+///
+void
+_GatherPixels(uint8_t* dst, uint8_t const* src, const unsigned int* columns, size_t count, size_t pixelSize)
+{
+    switch (pixelSize) {
+    case 2: _GatherPixels<2>(dst, src, columns, count); break;
+    case 4: _GatherPixels<4>(dst, src, columns, count); break;
+    case 8: _GatherPixels<8>(dst, src, columns, count); break;
+    case 12: _GatherPixels<12>(dst, src, columns, count); break;
+    case 16: _GatherPixels<16>(dst, src, columns, count); break;
+    default:
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(dst + i * pixelSize, src + columns[i] * pixelSize, pixelSize);
+        }
+        break;
+    }
+}
+
+///
+/// Copies the region between two images of the same layout
+///
+void
+_CopyRegion(uint8_t* dst, uint8_t const* src, size_t rowSize, size_t pixelSize, const GfRect2i& region)
+{
+    const size_t row_offset = region.GetMinX() * pixelSize;
+    const size_t region_row_size = region.GetWidth() * pixelSize;
+
+    if (region_row_size == rowSize) {
+        memcpy(dst + region.GetMinY() * rowSize, src + region.GetMinY() * rowSize, region.GetHeight() * rowSize);
+        return;
+    }
+
+    for (int y = region.GetMinY(); y <= region.GetMaxY(); ++y) {
+        memcpy(dst + y * rowSize + row_offset, src + y * rowSize + row_offset, region_row_size);
+    }
+}
+
 }  // namespace
 
 HdCyclesRenderBuffer::HdCyclesRenderBuffer(HdCyclesRenderDelegate* renderDelegate, const SdfPath& id)
@@ -77,10 +190,22 @@ HdCyclesRenderBuffer::HdCyclesRenderBuffer(HdCyclesRenderDelegate* renderDelegat
     , m_height(0)
     , m_format(HdFormatInvalid)
     , m_pixelSize(0)
+    , m_latest(0)
+    , m_mapped(0)
+    , m_writing(-1)
+    , m_writeState(WriteState::Idle)
+    , m_writers(0)
+    , m_batchWriters(0)
+    , m_allocating(false)
+    , m_historyCount(0)
+    , m_forgottenVersion(0)
+    , m_version(1)
+    , m_allocatedVersion(1)
     , m_mappers(0)
     , m_converged(false)
     , m_renderDelegate(renderDelegate)
 {
+    std::fill(std::begin(m_bufferVersions), std::end(m_bufferVersions), 0);
 }
 
 HdCyclesRenderBuffer::~HdCyclesRenderBuffer() {}
@@ -103,19 +228,47 @@ HdCyclesRenderBuffer::Allocate(const GfVec3i& dimensions, HdFormat format, bool
         return false;
     }
 
-    std::lock_guard<std::mutex> lock_guard { m_mutex };
+    _Reallocate(static_cast<unsigned int>(dimensions[0]), static_cast<unsigned int>(dimensions[1]), format);
+    return true;
+}
+
+void
+HdCyclesRenderBuffer::_Reallocate(unsigned int width, unsigned int height, HdFormat format)
+{
+    std::unique_lock<std::mutex> state_lock { m_stateMutex };
+    m_stateChanged.wait(state_lock, [this]() { return !m_allocating; });
+
+    // Readers and writers hold pointers to the buffers. New readers wait until resize is done, new writers are
+    // turned away since the render is reset after a resize anyway.
+    m_allocating = true;
+    m_stateChanged.wait(state_lock, [this]() {
+        return m_mappers.load() == 0 && m_writers == 0 && m_writeState == WriteState::Idle;
+    });
+
+    m_width = width;
+    m_height = height;
+    m_format = format;
+    m_pixelSize = format != HdFormatInvalid ? static_cast<unsigned int>(HdDataSizeOfFormat(format)) : 0;
 
     // Simulating shrink to fit
-    std::vector<uint8_t> buffer_empty {};
-    m_buffer.swap(buffer_empty);
+    for (int i = 0; i < NumBuffers; ++i) {
+        std::vector<uint8_t> buffer_empty {};
+        m_buffers[i].swap(buffer_empty);
+        m_bufferVersions[i] = 0;
+    }
 
-    m_width = static_cast<unsigned int>(dimensions[0]);
-    m_height = static_cast<unsigned int>(dimensions[1]);
-    m_format = format;
-    m_pixelSize = static_cast<unsigned int>(HdDataSizeOfFormat(format));
-    m_buffer.resize(m_width * m_height * m_pixelSize, 0);
+    // Versions keep increasing across resizes, consumers holding older versions get the full buffer
+    m_version += 1;
+    m_allocatedVersion = m_version;
+    _RecordRegion(m_version, GfRect2i { GfVec2i { 0, 0 }, static_cast<int>(m_width), static_cast<int>(m_height) });
 
-    return true;
+    m_latest = 0;
+    m_bufferVersions[m_latest] = m_version;
+    m_buffers[m_latest].resize(m_width * m_height * m_pixelSize, 0);
+
+    m_allocating = false;
+    state_lock.unlock();
+    m_stateChanged.notify_all();
 }
 
 unsigned int
@@ -151,23 +304,247 @@ HdCyclesRenderBuffer::IsMultiSampled() const
 void*
 HdCyclesRenderBuffer::Map()
 {
-    m_mutex.lock();
-    if (m_buffer.empty()) {
-        m_mutex.unlock();
+    return Map(nullptr);
+}
+
+void*
+HdCyclesRenderBuffer::Map(uint64_t* version)
+{
+    std::unique_lock<std::mutex> lock { m_stateMutex };
+    m_stateChanged.wait(lock, [this]() { return !m_allocating; });
+
+    if (m_buffers[m_latest].empty()) {
         return nullptr;
     }
 
+    // First reader pins the latest buffer, writer does not touch it until everyone unmaps
+    if (m_mappers.load() == 0) {
+        m_mapped = m_latest;
+    }
+
     m_mappers++;
-    return m_buffer.data();
+    if (version) {
+        *version = m_bufferVersions[m_mapped];
+    }
+    return m_buffers[m_mapped].data();
 }
 
 void
 HdCyclesRenderBuffer::Unmap()
 {
-    if (!m_buffer.empty()) {
-        m_mappers--;
-        m_mutex.unlock();
+    std::unique_lock<std::mutex> lock { m_stateMutex };
+    if (m_mappers.load() > 0 && --m_mappers == 0) {
+        lock.unlock();
+        m_stateChanged.notify_all();
+    }
+}
+
+uint64_t
+HdCyclesRenderBuffer::GetVersion() const
+{
+    std::lock_guard<std::mutex> lock { m_stateMutex };
+    return m_version;
+}
+
+GfRect2i
+HdCyclesRenderBuffer::GetChangedRegion(uint64_t version) const
+{
+    std::vector<GfRect2i> regions;
+    GetChangedRegions(version, &regions, nullptr);
+
+    GfRect2i region;
+    for (const GfRect2i& written : regions) {
+        region = region.GetUnion(written);
+    }
+    return region;
+}
+
+bool
+HdCyclesRenderBuffer::GetChangedRegions(uint64_t version, std::vector<GfRect2i>* regions, uint64_t* latest) const
+{
+    std::lock_guard<std::mutex> lock { m_stateMutex };
+    if (latest) {
+        *latest = m_version;
+    }
+
+    const bool tracked = _GetChangedRegions(version, *regions);
+    if (!tracked) {
+        regions->assign(1, GfRect2i { GfVec2i { 0, 0 }, static_cast<int>(m_width), static_cast<int>(m_height) });
+    }
+    return tracked;
+}
+
+bool
+HdCyclesRenderBuffer::_GetChangedRegions(uint64_t version, std::vector<GfRect2i>& regions) const
+{
+    regions.clear();
+    if (version >= m_version) {
+        return true;
+    }
+
+    if (version < m_allocatedVersion || version < m_forgottenVersion) {
+        return false;
+    }
+
+    // Regions are recorded in version order, newest first until the version is reached
+    for (size_t i = m_historyCount; i > 0; --i) {
+        const HistoryEntry& entry = m_history[(i - 1) % HistorySize];
+        if (entry.version <= version) {
+            break;
+        }
+        regions.push_back(entry.region);
+    }
+    return true;
+}
+
+void
+HdCyclesRenderBuffer::_RecordRegion(uint64_t version, const GfRect2i& region)
+{
+    HistoryEntry& entry = m_history[m_historyCount % HistorySize];
+    if (m_historyCount >= HistorySize) {
+        m_forgottenVersion = entry.version;
+    }
+
+    entry.version = version;
+    entry.region = region;
+    ++m_historyCount;
+}
+
+void*
+HdCyclesRenderBuffer::BeginWrite(const GfRect2i& region)
+{
+    std::unique_lock<std::mutex> lock { m_stateMutex };
+    m_stateChanged.wait(lock, [this]() {
+        return m_allocating || (m_writeState != WriteState::Preparing && m_batchWriters < MaxBatchWriters);
+    });
+
+    if (m_allocating) {
+        return nullptr;
+    }
+
+    // First writer of the batch prepares the back buffer, the others join it
+    if (m_writeState == WriteState::Idle && !_AcquireBackBuffer(lock, region)) {
+        return nullptr;
+    }
+
+    ++m_writers;
+    ++m_batchWriters;
+    return m_buffers[m_writing].data();
+}
+
+void
+HdCyclesRenderBuffer::EndWrite(const GfRect2i& region)
+{
+    std::lock_guard<std::mutex> lock { m_stateMutex };
+    m_writeRegions.push_back(_ClipRegion(region));
+    _ReleaseBackBuffer();
+}
+
+void
+HdCyclesRenderBuffer::DiscardWrite(const GfRect2i& region)
+{
+    // Region might have been partially written, it is restored from the latest buffer. Neither of them changes
+    // until the last writer of the batch is done.
+    const GfRect2i clipped = _ClipRegion(region);
+    if (!clipped.IsEmpty()) {
+        _CopyRegion(m_buffers[m_writing].data(), m_buffers[m_latest].data(), m_width * m_pixelSize, m_pixelSize,
+                    clipped);
     }
+
+    std::lock_guard<std::mutex> lock { m_stateMutex };
+    _ReleaseBackBuffer();
+}
+
+GfRect2i
+HdCyclesRenderBuffer::_ClipRegion(const GfRect2i& region) const
+{
+    return region.GetIntersection(
+        GfRect2i { GfVec2i { 0, 0 }, static_cast<int>(m_width), static_cast<int>(m_height) });
+}
+
+bool
+HdCyclesRenderBuffer::_AcquireBackBuffer(std::unique_lock<std::mutex>& lock, const GfRect2i& region)
+{
+    const size_t size = static_cast<size_t>(m_width) * m_height * m_pixelSize;
+    if (size == 0 || m_buffers[m_latest].empty()) {
+        return false;
+    }
+
+    const GfRect2i full { GfVec2i { 0, 0 }, static_cast<int>(m_width), static_cast<int>(m_height) };
+    const GfRect2i write_region = region.GetIntersection(full);
+
+    // Latest buffer only changes when the batch is published, new readers never pin the picked buffer
+    for (int i = 0; i < NumBuffers; ++i) {
+        if (i != m_latest && (m_mappers.load() == 0 || i != m_mapped)) {
+            m_writing = i;
+            break;
+        }
+    }
+
+    if (m_buffers[m_writing].size() != size) {
+        m_bufferVersions[m_writing] = 0;
+    }
+
+    // Regions the back buffer is behind the latest one
+    std::vector<GfRect2i> stale;
+    if (!_GetChangedRegions(m_bufferVersions[m_writing], stale)) {
+        stale.assign(1, full);
+    }
+
+    m_writeState = WriteState::Preparing;
+    lock.unlock();
+
+    // Regions the writer is going to overwrite anyway are skipped. Once the stale regions add up to more than
+    // the whole buffer it is cheaper to copy it at once.
+    size_t stale_pixels = 0;
+    stale.erase(std::remove_if(stale.begin(), stale.end(),
+                               [&write_region](const GfRect2i& r) { return write_region.GetIntersection(r) == r; }),
+                stale.end());
+    for (const GfRect2i& r : stale) {
+        stale_pixels += static_cast<size_t>(r.GetWidth()) * r.GetHeight();
+    }
+    if (stale_pixels >= static_cast<size_t>(m_width) * m_height) {
+        stale.assign(1, full);
+    }
+
+    std::vector<uint8_t>& back = m_buffers[m_writing];
+    back.resize(size);
+
+    // Bring the back buffer up to date
+    for (const GfRect2i& r : stale) {
+        _CopyRegion(back.data(), m_buffers[m_latest].data(), m_width * m_pixelSize, m_pixelSize, r);
+    }
+
+    lock.lock();
+    m_writeState = WriteState::Open;
+    m_stateChanged.notify_all();
+    return true;
+}
+
+void
+HdCyclesRenderBuffer::_ReleaseBackBuffer()
+{
+    if (m_writers == 0 || --m_writers > 0) {
+        return;
+    }
+
+    if (!m_writeRegions.empty()) {
+        m_version += 1;
+        for (const GfRect2i& region : m_writeRegions) {
+            _RecordRegion(m_version, region);
+        }
+        m_bufferVersions[m_writing] = m_version;
+        m_latest = m_writing;
+    } else {
+        // Every writer discarded its region, the back buffer holds the latest data
+        m_bufferVersions[m_writing] = m_version;
+    }
+
+    m_writing = -1;
+    m_writeRegions.clear();
+    m_batchWriters = 0;
+    m_writeState = WriteState::Idle;
+    m_stateChanged.notify_all();
 }
 
 bool
@@ -196,13 +573,24 @@ HdCyclesRenderBuffer::SetConverged(bool cv)
 void
 HdCyclesRenderBuffer::Clear()
 {
-    if (m_format == HdFormatInvalid)
-        return;
+    GfRect2i full;
+    {
+        std::lock_guard<std::mutex> lock { m_stateMutex };
+        if (m_format == HdFormatInvalid)
+            return;
+
+        full = GfRect2i { GfVec2i { 0, 0 }, static_cast<int>(m_width), static_cast<int>(m_height) };
+    }
 
-    std::lock_guard<std::mutex> lock { m_mutex };
+    auto data = static_cast<uint8_t*>(BeginWrite(full));
+    if (!data) {
+        return;
+    }
 
-    size_t pixelSize = HdDataSizeOfFormat(m_format);
-    memset(&m_buffer[0], 0, m_buffer.size());
+    // Dimensions can't change while writing, a resize in between is cleared as a whole
+    full = GfRect2i { GfVec2i { 0, 0 }, static_cast<int>(m_width), static_cast<int>(m_height) };
+    memset(data, 0, static_cast<size_t>(m_width) * m_height * m_pixelSize);
+    EndWrite(full);
 }
 
 void
@@ -216,81 +604,126 @@ void
 HdCyclesRenderBuffer::BlitTile(HdFormat format, unsigned int x, unsigned int y, int unsigned width, unsigned int height,
                                float width_data, float height_data, int offset, int stride, uint8_t const* data)
 {
+    HD_TRACE_FUNCTION();
+
+    // Tiles are written concurrently, the back buffer they share is only resized between batches
+    unsigned int buffer_width = 0;
+    unsigned int buffer_height = 0;
+    {
+        std::lock_guard<std::mutex> lock { m_stateMutex };
+        buffer_width = m_width;
+        buffer_height = m_height;
+    }
+
     // TODO: BlitTile shouldnt be called but it is...
-    if (m_width <= 0) {
+    if (buffer_width <= 0) {
         return;
     }
-    if (m_height <= 0) {
+    if (buffer_height <= 0) {
         return;
     }
-    if (m_buffer.size() <= 0) {
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    // Rows of the source can be padded, pixel (x, y) of the tile is at offset + x + y * stride
+    if (offset < 0 || stride < static_cast<int>(width)) {
+        TF_WARN("Invalid tile layout with offset %d and stride %d for a tile %u pixels wide", offset, stride, width);
         return;
     }
 
-    size_t pixelSize = HdDataSizeOfFormat(format);
+    const size_t pixelSize = HdDataSizeOfFormat(format);
 
-    const float x_scale_dst = (float)m_width / width_data;
-    const float y_scale_dst = (float)m_height / height_data;
+    const float x_scale_dst = (float)buffer_width / width_data;
+    const float y_scale_dst = (float)buffer_height / height_data;
     const unsigned int x_dst = round(x_scale_dst * x);
     const unsigned int y_dst = round(y_scale_dst * y);
-    const unsigned int width_dst = round(x_scale_dst * (x + width)) - x_dst;
-    const unsigned int height_dst = round(y_scale_dst * (y + height)) - y_dst;
+    if (x_dst >= buffer_width || y_dst >= buffer_height) {
+        return;
+    }
+
+    // Rounding can push the scaled rect past the buffer edge
+    const unsigned int width_dst = std::min<unsigned int>(round(x_scale_dst * (x + width)) - x_dst,
+                                                          buffer_width - x_dst);
+    const unsigned int height_dst = std::min<unsigned int>(round(y_scale_dst * (y + height)) - y_dst,
+                                                           buffer_height - y_dst);
+
+    const GfRect2i region { GfVec2i { static_cast<int>(x_dst), static_cast<int>(y_dst) }, static_cast<int>(width_dst),
+                            static_cast<int>(height_dst) };
+    auto buffer = static_cast<uint8_t*>(BeginWrite(region));
+    if (!buffer) {
+        return;
+    }
+
+    // Resized since the tile was placed, the render is going to be reset
+    if (m_width != buffer_width || m_height != buffer_height) {
+        DiscardWrite(region);
+        return;
+    }
 
     const float x_scale_src = (float)width_data / (float)m_width;
     const float y_scale_src = (float)height_data / (float)m_height;
 
-    if (m_format == format) {
-        for (unsigned int j = 0; j < height_dst; ++j) {
-            for (unsigned int i = 0; i < width_dst; ++i) {
-                size_t mem_start = (((y_dst + j) * m_width) * m_pixelSize) + ((x_dst + i) * m_pixelSize);
-
-                const unsigned int j_src = y_scale_src * j;
-                const unsigned int i_src = x_scale_src * i;
-                int tile_mem_start = static_cast<int>(((j_src * width) * pixelSize) + (i_src * pixelSize));
+    // Source row and column of every destination pixel, resolved once per tile
+    std::vector<unsigned int> rows_src(height_dst);
+    for (unsigned int j = 0; j < height_dst; ++j) {
+        rows_src[j] = std::min(static_cast<unsigned int>(y_scale_src * j), height - 1);
+    }
 
-                memcpy(&m_buffer[mem_start], &data[tile_mem_start], pixelSize);
-            }
-        }
-    } else {
-        // If src and dst are both int-based, don't round trip to float.
-        bool convertAsInt = (HdGetComponentFormat(format) == HdFormatInt32)
-                            && (HdGetComponentFormat(m_format) == HdFormatInt32);
+    bool scaled = false;
+    std::vector<unsigned int> columns_src(width_dst);
+    for (unsigned int i = 0; i < width_dst; ++i) {
+        columns_src[i] = std::min(static_cast<unsigned int>(x_scale_src * i), width - 1);
+        scaled |= columns_src[i] != i;
+    }
 
+    const bool same_format = m_format == format;
+    const size_t src_row_size = static_cast<size_t>(stride) * pixelSize;
+    uint8_t const* src = data + static_cast<size_t>(offset) * pixelSize;
+    const size_t dst_row_size = m_width * m_pixelSize;
 
-        for (unsigned int j = 0; j < height_dst; ++j) {
-            for (unsigned int i = 0; i < width_dst; ++i) {
-                size_t mem_start = (((y_dst + j) * m_width) * m_pixelSize) + ((x_dst + i) * m_pixelSize);
+    auto blit_rows = [&](size_t row_begin, size_t row_end) {
+        std::vector<uint8_t> gathered(scaled && !same_format ? width_dst * pixelSize : 0);
+        std::vector<float> scratch;
 
-                const unsigned int j_src = y_scale_src * j;
-                const unsigned int i_src = x_scale_src * i;
-                int tile_mem_start = static_cast<int>(((j_src * width) * pixelSize) + (i_src * pixelSize));
+        for (size_t j = row_begin; j < row_end; ++j) {
+            uint8_t const* src_row = src + rows_src[j] * src_row_size;
+            uint8_t* dst_row = buffer + (y_dst + j) * dst_row_size + x_dst * m_pixelSize;
 
-                if (convertAsInt) {
-                    _ConvertPixel<int32_t>(m_format, &m_buffer[mem_start], format, &data[tile_mem_start]);
+            if (same_format) {
+                if (scaled) {
+                    _GatherPixels(dst_row, src_row, columns_src.data(), width_dst, pixelSize);
                 } else {
-                    if (mem_start >= m_buffer.size()) {
-                        // TODO: This is triggered more times than it should be
-                    } else {
-                        _ConvertPixel<float>(m_format, &m_buffer[mem_start], format, &data[tile_mem_start]);
-                    }
+                    memcpy(dst_row, src_row, width_dst * pixelSize);
                 }
+                continue;
             }
+
+            if (scaled) {
+                _GatherPixels(gathered.data(), src_row, columns_src.data(), width_dst, pixelSize);
+                src_row = gathered.data();
+            }
+
+            _ConvertRow(m_format, dst_row, format, src_row, width_dst, scratch);
         }
+    };
+
+    const size_t num_pixels = static_cast<size_t>(width_dst) * height_dst;
+    if (num_pixels < HdCyclesBlitParallelPixels) {
+        blit_rows(0, height_dst);
+    } else {
+        const size_t grain = std::max<size_t>(1, HdCyclesBlitGrainPixels / width_dst);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, height_dst, grain),
+                          [&](const tbb::blocked_range<size_t>& r) { blit_rows(r.begin(), r.end()); });
     }
+
+    EndWrite(region);
 }
 
 void
 HdCyclesRenderBuffer::_Deallocate()
 {
-    std::lock_guard<std::mutex> lock { m_mutex };
-
-    m_width = 0;
-    m_height = 0;
-    m_format = HdFormatInvalid;
-
-    std::vector<uint8_t> buffer_empty {};
-    m_buffer.swap(buffer_empty);
-    m_mappers.store(0);
+    _Reallocate(0, 0, HdFormatInvalid);
     m_converged.store(false);
 }
 
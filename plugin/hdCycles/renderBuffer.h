@@ -22,10 +22,14 @@
 
 #include "api.h"
 
+#include <pxr/base/gf/rect2i.h>
 #include <pxr/imaging/hd/renderBuffer.h>
 #include <pxr/pxr.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <vector>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -89,7 +93,8 @@ public:
 
     /**
      * @brief Maps the render buffer to the system memory.
-     * This returns the Cycles representation of data stored in _buffer
+     * This returns the latest buffer published by Cycles, it does not wait for writes in progress.
+     * Concurrent readers share the same buffer until the last one unmaps.
      * 
      * @return Pointer to the render buffer mapped to system memory
      */
@@ -103,6 +108,62 @@ public:
      */
     void Unmap() override;
 
+    /**
+     * @brief Map the render buffer and report the version of the mapped data
+     * 
+     * @param version Version of the mapped buffer, pass it to GetChangedRegion on the next update
+     * @return Pointer to the render buffer mapped to system memory
+     */
+    void* Map(uint64_t* version);
+
+    /**
+     * @return Returns the version of the latest published buffer, it is incremented on every write
+     */
+    uint64_t GetVersion() const;
+
+    /**
+     * @brief Region written since the given version.
+     * Full buffer is returned if the version is too old to be tracked or from before the last resize.
+     * 
+     * @param version Version previously returned by GetVersion or Map
+     * @return Bounding box of the regions written since the version, empty if nothing has changed
+     */
+    GfRect2i GetChangedRegion(uint64_t version) const;
+
+    /**
+     * @brief Regions written since the given version, one per write
+     * 
+     * @param version Version previously returned by GetVersion or Map
+     * @param regions Regions written since the version, they can overlap. Full buffer if the version is not tracked
+     * @param latest Version of the latest buffer, it holds all the regions
+     * @return false if the version is too old to be tracked or from before the last resize
+     */
+    bool GetChangedRegions(uint64_t version, std::vector<GfRect2i>* regions, uint64_t* latest) const;
+
+    /**
+     * @brief Begin writing to the back buffer, that is not visible to readers until EndWrite.
+     * Concurrent writers share the back buffer and must write disjoint regions, it is published once the last
+     * of them ends. Readers are never blocked by a write in progress.
+     * 
+     * @param region Pixels that are going to be written, everything else is kept from the latest buffer
+     * @return Pointer to the back buffer or nullptr if the buffer is not allocated or being resized
+     */
+    void* BeginWrite(const GfRect2i& region);
+
+    /**
+     * @brief Finish writing the region, the back buffer becomes the latest one when no other writer is left
+     * 
+     * @param region Region passed to BeginWrite
+     */
+    void EndWrite(const GfRect2i& region);
+
+    /**
+     * @brief Drop the region written since BeginWrite, readers keep the latest data for it
+     * 
+     * @param region Region passed to BeginWrite
+     */
+    void DiscardWrite(const GfRect2i& region);
+
     /**
      * @return Returns true if the render buffer is mapped to system memory
      */
@@ -135,8 +196,8 @@ public:
      * @param format Input format
      * @param width Width of buffer
      * @param height Height of buffer
-     * @param offset Offset between pixels
-     * @param stride Stride of pixel
+     * @param offset Index of the first pixel of the tile in data
+     * @param stride Number of pixels between the starts of two rows in data, at least the width
      * @param data Pointer to data
      */
     void BlitTile(HdFormat format, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
@@ -150,19 +211,89 @@ protected:
     void _Deallocate() override;
 
 private:
+    /**
+     * @brief Resize all buffers once readers have unmapped, back buffers are allocated on first write
+     * 
+     */
+    void _Reallocate(unsigned int width, unsigned int height, HdFormat format);
+
+    /**
+     * @brief Regions written since the version, false if it is not tracked. State lock must be held
+     * 
+     */
+    bool _GetChangedRegions(uint64_t version, std::vector<GfRect2i>& regions) const;
+
+    /**
+     * @brief Remember the region written by the version. State lock must be held
+     * 
+     */
+    void _RecordRegion(uint64_t version, const GfRect2i& region);
+
+    /**
+     * @brief Pick a back buffer and bring it up to date outside of the region.
+     * State lock must be held, it is released while the buffer is copied.
+     */
+    bool _AcquireBackBuffer(std::unique_lock<std::mutex>& lock, const GfRect2i& region);
+
+    /**
+     * @brief Leave the batch of writers, the last one publishes the back buffer. State lock must be held
+     * 
+     */
+    void _ReleaseBackBuffer();
+
+    /**
+     * @brief Region clipped to the buffer
+     * 
+     */
+    GfRect2i _ClipRegion(const GfRect2i& region) const;
+
+    // Back buffer is prepared by the first writer of a batch, the others wait for it before joining
+    enum class WriteState { Idle, Preparing, Open };
+
+    // Triple buffering: readers map the latest buffer, writer fills one that is neither latest nor mapped
+    static constexpr int NumBuffers = 3;
+
+    // Number of written regions remembered, older versions are reported as fully changed
+    static constexpr size_t HistorySize = 256;
+
+    // Writers joining a batch after this many wait for it to be published, so that readers see progress
+    static constexpr int MaxBatchWriters = 64;
+
+    struct HistoryEntry {
+        uint64_t version;
+        GfRect2i region;
+    };
+
     unsigned int m_width;
     unsigned int m_height;
     HdFormat m_format;
     unsigned int m_pixelSize;
 
-    std::vector<uint8_t> m_buffer;
+    std::vector<uint8_t> m_buffers[NumBuffers];
+    uint64_t m_bufferVersions[NumBuffers];  // version of the data the buffer holds, 0 if undefined
+    int m_latest;                           // last published buffer
+    int m_mapped;                           // buffer shared by the readers, valid while mapped
+    int m_writing;                          // back buffer being written, -1 if none
+    WriteState m_writeState;
+    int m_writers;                         // writers that have not ended yet
+    int m_batchWriters;                    // writers that joined the batch
+    std::vector<GfRect2i> m_writeRegions;  // regions ended in the batch
+    bool m_allocating;
+
+    // Regions written by the latest versions in order, indexed by record count modulo history size
+    HistoryEntry m_history[HistorySize];
+    size_t m_historyCount;        // regions recorded since construction
+    uint64_t m_forgottenVersion;  // latest version with regions dropped from the history
+    uint64_t m_version;
+    uint64_t m_allocatedVersion;  // first version after the last resize
+
     std::atomic<int> m_mappers;
     std::atomic<bool> m_converged;
 
-    // Synchronizes resize with writes from cycles and
-    // reads from hydra. Maybe it could be made more lightweight
-    // with some assumptions on execution?
-    std::mutex m_mutex;
+    // Guards buffer indices and the batch of writers, never held while pixels are written.
+    // Readers and writers wait on it only during resize and while a batch is prepared.
+    mutable std::mutex m_stateMutex;
+    std::condition_variable m_stateChanged;
 
     HdCyclesRenderDelegate* m_renderDelegate;
 };
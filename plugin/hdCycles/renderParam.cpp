@@ -25,6 +25,7 @@
 #include "utils.h"
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <unordered_set>
 
@@ -192,6 +193,158 @@ GetDenoisePass(const TfToken token)
     }
 }
 
+// Rows of the display buffer per readback task
+constexpr size_t HdCyclesReadbackGrainRows = 16;
+
+///
+/// Where a pass is in the interleaved Cycles buffer and how its values are resolved, as in
+/// RenderBuffers::get_pass_rect
+///
+struct HdCyclesPassLayout {
+    ccl::PassType type;
+    int offset;             // First value of the pass in a pixel
+    int divideOffset;       // Color pass a light pass is divided by, -1 if none
+    int weightOffset;       // Weight the motion pass is normalized by, -1 if none
+    int sampleCountOffset;  // Adaptive sample count of the combined pass, -1 if none
+    bool filter;            // Values are averaged over the samples
+    bool useExposure;
+    float scale;
+    float scaleExposure;
+    float exposure;
+};
+
+///
+/// Offset of the first pass of the type in a pixel, -1 if there is none
+///
+int
+GetPassOffset(const ccl::vector<ccl::Pass>& passes, ccl::PassType type)
+{
+    int offset = 0;
+    for (const ccl::Pass& pass : passes) {
+        if (pass.type == type) {
+            return offset;
+        }
+        offset += pass.components;
+    }
+    return -1;
+}
+
+///
+/// Resolves the layout of the named pass, false if it is not stored per pixel or can't be read as components
+///
+bool
+GetPassLayout(const ccl::BufferParams& params, const std::string& name, int components, float exposure, int samples,
+              HdCyclesPassLayout& layout)
+{
+    int offset = 0;
+    for (const ccl::Pass& pass : params.passes) {
+        if (pass.name != name) {
+            offset += pass.components;
+            continue;
+        }
+
+        const bool readable = (components == 1 && pass.components == 1)
+                              || (components == 3 && pass.components >= 3)
+                              || (components == 4 && pass.components == 4);
+        if (!readable) {
+            return false;
+        }
+
+        layout.type = pass.type;
+        layout.offset = offset;
+        layout.divideOffset = components == 3 && pass.divide_type != ccl::PASS_NONE
+                                  ? GetPassOffset(params.passes, pass.divide_type)
+                                  : -1;
+        layout.weightOffset = pass.type == ccl::PASS_MOTION ? GetPassOffset(params.passes, ccl::PASS_MOTION_WEIGHT)
+                                                            : -1;
+        layout.sampleCountOffset = name == "Combined" ? GetPassOffset(params.passes, ccl::PASS_SAMPLE_COUNT) : -1;
+        layout.filter = pass.filter;
+        layout.useExposure = pass.exposure;
+        layout.scale = pass.filter ? 1.0f / static_cast<float>(samples) : 1.0f;
+        layout.scaleExposure = pass.exposure ? layout.scale * exposure : layout.scale;
+        layout.exposure = exposure;
+        return true;
+    }
+    return false;
+}
+
+///
+/// Resolves the pass values of a row of pixels, extra destination components are zero filled
+///
+void
+ReadPassRow(const HdCyclesPassLayout& layout, const float* row, int passStride, const unsigned int* columns,
+            size_t count, int components, int dstComponents, float* values)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const float* pixel = row + static_cast<size_t>(columns[i]) * passStride;
+        const float* in = pixel + layout.offset;
+        float* out = values + i * dstComponents;
+
+        if (components == 1) {
+            const float f = in[0];
+            if (layout.type == ccl::PASS_DEPTH) {
+                out[0] = f == 0.0f ? 1e10f : f * layout.scaleExposure;
+            } else if (layout.type == ccl::PASS_MIST) {
+                out[0] = ccl::saturate(f * layout.scaleExposure);
+            } else {
+                out[0] = f * layout.scaleExposure;
+            }
+        } else if (layout.type == ccl::PASS_SHADOW) {
+            const float invw = in[3] > 0.0f ? 1.0f / in[3] : 1.0f;
+            out[0] = in[0] * invw;
+            out[1] = in[1] * invw;
+            out[2] = in[2] * invw;
+            if (components == 4) {
+                out[3] = 1.0f;
+            }
+        } else if (components == 3) {
+            if (layout.divideOffset >= 0) {
+                // Light passes have the color divided out
+                const float* divide = pixel + layout.divideOffset;
+                const ccl::float3 f = ccl::safe_divide_even_color(
+                    ccl::make_float3(in[0], in[1], in[2]) * layout.exposure,
+                    ccl::make_float3(divide[0], divide[1], divide[2]));
+                out[0] = f.x;
+                out[1] = f.y;
+                out[2] = f.z;
+            } else {
+                out[0] = in[0] * layout.scaleExposure;
+                out[1] = in[1] * layout.scaleExposure;
+                out[2] = in[2] * layout.scaleExposure;
+            }
+        } else if (layout.type == ccl::PASS_MOTION) {
+            const float w = layout.weightOffset >= 0 ? pixel[layout.weightOffset] : 0.0f;
+            const float invw = w > 0.0f ? 1.0f / w : 0.0f;
+            out[0] = in[0] * invw;
+            out[1] = in[1] * invw;
+            out[2] = in[2] * invw;
+            out[3] = in[3] * invw;
+        } else if (layout.type == ccl::PASS_CRYPTOMATTE) {
+            // Ids are kept, only the matte weights are averaged
+            out[0] = in[0];
+            out[1] = in[1] * layout.scale;
+            out[2] = in[2];
+            out[3] = in[3] * layout.scale;
+        } else {
+            // Adaptive sampling stores the negated sample count of pixels that stopped early
+            float scale = layout.scale;
+            float scaleExposure = layout.scaleExposure;
+            if (layout.sampleCountOffset >= 0 && pixel[layout.sampleCountOffset] < 0.0f) {
+                scale = layout.filter ? -1.0f / pixel[layout.sampleCountOffset] : 1.0f;
+                scaleExposure = layout.useExposure ? scale * layout.exposure : scale;
+            }
+            out[0] = in[0] * scaleExposure;
+            out[1] = in[1] * scaleExposure;
+            out[2] = in[2] * scaleExposure;
+            out[3] = ccl::saturate(in[3] * scale);
+        }
+
+        for (int c = components; c < dstComponents; ++c) {
+            out[c] = 0.0f;
+        }
+    }
+}
+
 void
 GetAovFlags(const HdCyclesAov& cyclesAov, bool& custom, bool& denoise)
 {
@@ -218,6 +371,12 @@ HdCyclesRenderParam::HdCyclesRenderParam()
     , m_lightsUpdated(false)
     , m_shadersUpdated(false)
     , m_shouldUpdate(false)
+    , m_sessionResets(0)
+    , m_displaySamples(-1)
+    , m_displayResets(-1)
+    , m_checkpointInterval(0.0)
+    , m_checkpointTime(0.0)
+    , m_checkpointRequested(false)
     , m_numDomeLights(0)
     , m_useSquareSamples(false)
     , m_cyclesSession(nullptr)
@@ -287,6 +446,18 @@ HdCyclesRenderParam::_SessionUpdateCallback()
 
     m_cyclesSession->progress.get_time(m_totalTime, m_renderTime);
 
+    // - Request a checkpoint, it is written by the next display copy
+
+    if (!m_checkpointPath.empty()) {
+        if (m_totalTime < m_checkpointTime) {
+            // Session was reset
+            m_checkpointTime = m_totalTime;
+        } else if (m_totalTime - m_checkpointTime >= m_checkpointInterval) {
+            m_checkpointTime = m_totalTime;
+            m_checkpointRequested = true;
+        }
+    }
+
     // - Handle Session status logging
 
     if (HdCyclesConfig::GetInstance().enable_logging) {
@@ -354,6 +525,11 @@ HdCyclesRenderParam::Initialize(HdRenderSettingsMap const& settingsMap)
 
     _HandlePasses();
 
+    static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
+    if (!config.checkpoint_path.value.empty()) {
+        SetCheckpoint(config.checkpoint_path.value, config.checkpoint_interval.value);
+    }
+
     return true;
 }
 
@@ -1496,14 +1672,22 @@ HdCyclesRenderParam::_CreateSession()
     m_cyclesSession = new ccl::Session(m_sessionParams);
 
     m_cyclesSession->display_copy_cb = [this](int samples) {
+        // Nothing has been rendered since the last copy, render buffers are up to date
+        const int resets = m_sessionResets.load();
+        if (samples == m_displaySamples && resets == m_displayResets) {
+            return;
+        }
+
         const int width = m_cyclesSession->tile_manager.state.buffer.width;
         const int height = m_cyclesSession->tile_manager.state.buffer.height;
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_aovs.size(), 1),
-                          [this, width, height, samples](const tbb::blocked_range<size_t>& r) {
-                              for (size_t i = r.begin(); i < r.end(); ++i) {
-                                  BlitFromCyclesPass(m_aovs[i], width, height, samples);
-                              }
-                          });
+        BlitFromCyclesPasses(width, height, samples);
+
+        if (m_checkpointRequested.exchange(false)) {
+            _WriteCheckpoint(samples);
+        }
+
+        m_displaySamples = samples;
+        m_displayResets = resets;
     };
 
     m_cyclesSession->write_render_tile_cb = std::bind(&HdCyclesRenderParam::_WriteRenderTile, this, ccl::_1);
@@ -1542,71 +1726,55 @@ HdCyclesRenderParam::_WriteRenderTile(ccl::RenderTile& rtile)
 
     const float exposure = m_cyclesScene->film->exposure;
 
-    if (!m_aovs.empty()) {
-        // Blit from the framebuffer to currently selected aovs...
-        for (auto& aov : m_aovs) {
-            if (!TF_VERIFY(aov.renderBuffer != nullptr)) {
-                continue;
-            }
+    if (m_resolvedAovs.empty()) {
+        return;
+    }
 
-            auto* rb = static_cast<HdCyclesRenderBuffer*>(aov.renderBuffer);
+    // Translate source subrect to the origin
+    const unsigned int x_src = rtile.x - m_cyclesSession->tile_manager.params.full_x;
+    const unsigned int y_src = rtile.y - m_cyclesSession->tile_manager.params.full_y;
 
-            if (rb == nullptr) {
-                continue;
-            }
+    // Passing the dimension as float to not lose the decimal points in the conversion to int
+    // We need to do this only for tiles becase we are scaling the source rect to calculate
+    // the region to write to in the destination rect
+    const float width_data_src = m_bufferParams.width;
+    const float height_data_src = m_bufferParams.height;
 
-            if (rb->GetFormat() == HdFormatInvalid) {
-                continue;
-            }
+    const bool converged = IsConverged();
 
-            HdCyclesAov cyclesAov;
-            if (!GetCyclesAov(aov, cyclesAov)) {
-                continue;
-            }
+    // Sized for the largest tile and widest format, so resizing happens once per thread
+    const ccl::int2 tile_size = m_cyclesSession->params.tile_size;
+    const size_t maxTileValues = static_cast<size_t>(std::max(w, tile_size.x)) * std::max(h, tile_size.y) * 4;
+    std::vector<float>& tileData = m_tileScratch.local();
+    if (tileData.size() < maxTileValues) {
+        tileData.resize(maxTileValues);
+    }
 
-            // We don't want a mismatch of formats
-            if (rb->GetFormat() != cyclesAov.format) {
-                continue;
-            }
+    // Blit from the framebuffer to currently selected aovs...
+    for (const HdCyclesResolvedAov& aov : m_resolvedAovs) {
+        auto* rb = static_cast<HdCyclesRenderBuffer*>(aov.renderBuffer);
 
-            bool custom, denoise;
-            GetAovFlags(cyclesAov, custom, denoise);
-
-            // Pixels we will use to get from cycles.
-            size_t numComponents = HdGetComponentCount(cyclesAov.format);
-            ccl::vector<float> tileData(w * h * numComponents);
-
-            rb->SetConverged(IsConverged());
-
-            bool read = false;
-            if (!custom && !denoise) {
-                read = buffers->get_pass_rect(cyclesAov.name.c_str(), exposure, sample, static_cast<int>(numComponents),
-                                              &tileData[0]);
-            } else if (denoise) {
-                read = buffers->get_denoising_pass_rect(GetDenoisePass(cyclesAov.token), exposure, sample,
-                                                        static_cast<int>(numComponents), &tileData[0]);
-            } else if (custom) {
-                read = buffers->get_pass_rect(aov.aovName.GetText(), exposure, sample, static_cast<int>(numComponents),
-                                              &tileData[0]);
-            }
-
-            if (!read) {
-                memset(&tileData[0], 0, tileData.size() * sizeof(float));
-            }
+        // We don't want a mismatch of formats
+        if (rb->GetFormat() != aov.format) {
+            continue;
+        }
 
-            // Translate source subrect to the origin
-            const unsigned int x_src = rtile.x - m_cyclesSession->tile_manager.params.full_x;
-            const unsigned int y_src = rtile.y - m_cyclesSession->tile_manager.params.full_y;
+        rb->SetConverged(converged);
 
-            // Passing the dimension as float to not lose the decimal points in the conversion to int
-            // We need to do this only for tiles becase we are scaling the source rect to calculate
-            // the region to write to in the destination rect
-            const float width_data_src = m_bufferParams.width;
-            const float height_data_src = m_bufferParams.height;
+        bool read = false;
+        if (aov.denoisePass < 0) {
+            read = buffers->get_pass_rect(aov.passName.c_str(), exposure, sample, aov.numComponents, tileData.data());
+        } else {
+            read = buffers->get_denoising_pass_rect(aov.denoisePass, exposure, sample, aov.numComponents,
+                                                    tileData.data());
+        }
 
-            rb->BlitTile(cyclesAov.format, x_src, y_src, rtile.w, rtile.h, width_data_src, height_data_src, 0, rtile.w,
-                         reinterpret_cast<uint8_t*>(tileData.data()));
+        if (!read) {
+            memset(tileData.data(), 0, static_cast<size_t>(w) * h * aov.numComponents * sizeof(float));
         }
+
+        rb->BlitTile(aov.format, x_src, y_src, rtile.w, rtile.h, width_data_src, height_data_src, 0, rtile.w,
+                     reinterpret_cast<uint8_t*>(tileData.data()));
     }
 }
 
@@ -1654,6 +1822,7 @@ HdCyclesRenderParam::_CreateScene()
     SetBackgroundShader(nullptr);
 
     m_cyclesSession->reset(m_bufferParams, m_sessionParams.samples);
+    ++m_sessionResets;
 
     return true;
 }
@@ -1697,8 +1866,15 @@ HdCyclesRenderParam::ResumeRender()
 void
 HdCyclesRenderParam::Interrupt(bool a_forceUpdate)
 {
-    m_shouldUpdate = true;
-    PauseRender();
+    _RequestUpdate();
+}
+
+void
+HdCyclesRenderParam::_RequestUpdate()
+{
+    if (!m_shouldUpdate.exchange(true)) {
+        PauseRender();
+    }
 }
 
 void
@@ -1706,6 +1882,8 @@ HdCyclesRenderParam::CommitResources()
 {
     ccl::thread_scoped_lock lock { m_cyclesScene->mutex };
 
+    _FlushPendingAdditions();
+
     if (m_shouldUpdate) {
         if (m_cyclesScene->lights.size() > 0) {
             if (m_numDomeLights <= 0)
@@ -1826,6 +2004,16 @@ HdCyclesRenderParam::_CyclesExit()
     m_cyclesScene->lights.clear();
     m_cyclesScene->particle_systems.clear();
 
+    m_shadersIndex.Clear();
+    m_geometryIndex.Clear();
+    m_objectsIndex.Clear();
+    m_lightsIndex.Clear();
+
+    m_pendingShaders.clear();
+    m_pendingGeometry.clear();
+    m_pendingObjects.clear();
+    m_pendingLights.clear();
+
     if (m_cyclesSession) {
         delete m_cyclesSession;
         m_cyclesSession = nullptr;
@@ -1862,7 +2050,12 @@ HdCyclesRenderParam::CyclesReset(bool a_forceUpdate)
         m_cyclesScene->film->tag_update(m_cyclesScene);
     }
 
+    _ResetResume();
     m_cyclesSession->reset(m_bufferParams, m_cyclesSession->params.samples);
+    ++m_sessionResets;
+
+    // Not converged until the session reports progress of the new render
+    m_renderProgress = 0.0f;
 }
 
 void
@@ -1916,7 +2109,12 @@ HdCyclesRenderParam::SetViewport(int w, int h)
 void
 HdCyclesRenderParam::DirectReset()
 {
+    _ResetResume();
     m_cyclesSession->reset(m_bufferParams, m_cyclesSession->params.samples);
+    ++m_sessionResets;
+
+    // Not converged until the session reports progress of the new render
+    m_renderProgress = 0.0f;
 }
 
 void
@@ -1927,6 +2125,38 @@ HdCyclesRenderParam::UpdateShadersTag(ccl::vector<ccl::Shader*>& shaders)
     }
 }
 
+void
+HdCyclesRenderParam::_FlushPendingAdditions()
+{
+    ccl::Shader* shader = nullptr;
+    while (m_pendingShaders.try_pop(shader)) {
+        m_shadersIndex.Add(m_cyclesScene->shaders, shader);
+        m_shadersUpdated = true;
+    }
+
+    ccl::Geometry* geometry = nullptr;
+    while (m_pendingGeometry.try_pop(geometry)) {
+        m_geometryIndex.Add(m_cyclesScene->geometry, geometry);
+        m_geometryUpdated = true;
+    }
+
+    ccl::Object* object = nullptr;
+    while (m_pendingObjects.try_pop(object)) {
+        m_objectsIndex.Add(m_cyclesScene->objects, object);
+        m_objectsUpdated = true;
+    }
+
+    ccl::Light* light = nullptr;
+    while (m_pendingLights.try_pop(light)) {
+        m_lightsIndex.Add(m_cyclesScene->lights, light);
+        m_lightsUpdated = true;
+
+        if (light->type == ccl::LIGHT_BACKGROUND) {
+            m_numDomeLights += 1;
+        }
+    }
+}
+
 void
 HdCyclesRenderParam::AddShader(ccl::Shader* shader)
 {
@@ -1935,9 +2165,8 @@ HdCyclesRenderParam::AddShader(ccl::Shader* shader)
         return;
     }
 
-    m_shadersUpdated = true;
-
-    m_cyclesScene->shaders.push_back(shader);
+    m_pendingShaders.push(shader);
+    _RequestUpdate();
 }
 
 
@@ -1949,13 +2178,8 @@ HdCyclesRenderParam::AddLight(ccl::Light* light)
         return;
     }
 
-    m_lightsUpdated = true;
-
-    m_cyclesScene->lights.push_back(light);
-
-    if (light->type == ccl::LIGHT_BACKGROUND) {
-        m_numDomeLights += 1;
-    }
+    m_pendingLights.push(light);
+    _RequestUpdate();
 }
 
 void
@@ -1966,11 +2190,8 @@ HdCyclesRenderParam::AddObject(ccl::Object* object)
         return;
     }
 
-    m_objectsUpdated = true;
-
-    m_cyclesScene->objects.push_back(object);
-
-    Interrupt();
+    m_pendingObjects.push(object);
+    _RequestUpdate();
 }
 
 void
@@ -1981,15 +2202,10 @@ HdCyclesRenderParam::AddObjectArray(std::vector<ccl::Object>& objects)
         return;
     }
 
-    const size_t numObjects = objects.size();
-    const size_t startIndex = m_cyclesScene->objects.size();
-    m_cyclesScene->objects.resize(startIndex + numObjects);
-    for (size_t i = 0; i < numObjects; i++) {
-        m_cyclesScene->objects[startIndex + i] = &objects[i];
+    for (ccl::Object& object : objects) {
+        m_pendingObjects.push(&object);
     }
-
-    m_objectsUpdated = true;
-    Interrupt();
+    _RequestUpdate();
 }
 
 void
@@ -2000,18 +2216,29 @@ HdCyclesRenderParam::RemoveObjectArray(const std::vector<ccl::Object>& objects)
         return;
     }
 
-    size_t numObjectsToRemove = objects.size();
-    const size_t numSceneObjects = m_cyclesScene->objects.size();
-    // Find the first object
-    for (size_t i = 0; i < numSceneObjects; i++) {
-        if (m_cyclesScene->objects[i] == &objects[0]) {
-            m_cyclesScene->objects.erase(m_cyclesScene->objects.begin() + i,
-                                         m_cyclesScene->objects.begin() + i + numObjectsToRemove);
-            break;
+    if (objects.empty()) {
+        return;
+    }
+
+    _FlushPendingAdditions();
+
+    // Few objects are removed one by one, otherwise scene objects are compacted once
+    constexpr size_t compaction_ratio = 8;
+    if (objects.size() * compaction_ratio < m_cyclesScene->objects.size()) {
+        for (const ccl::Object& object : objects) {
+            m_objectsIndex.Remove(m_cyclesScene->objects, &object);
         }
+    } else {
+        const ccl::Object* begin = objects.data();
+        const ccl::Object* end = objects.data() + objects.size();
+        const std::less<const ccl::Object*> less {};
+        m_objectsIndex.RemoveIf(m_cyclesScene->objects, [begin, end, &less](const ccl::Object* object) {
+            return !less(object, begin) && less(object, end);
+        });
     }
+
     m_objectsUpdated = true;
-    Interrupt();
+    _RequestUpdate();
 }
 
 void
@@ -2022,120 +2249,81 @@ HdCyclesRenderParam::AddGeometry(ccl::Geometry* geometry)
         return;
     }
 
-    m_geometryUpdated = true;
-
-    m_cyclesScene->geometry.push_back(geometry);
-
-    Interrupt();
+    m_pendingGeometry.push(geometry);
+    _RequestUpdate();
 }
 
 void
 HdCyclesRenderParam::RemoveShader(ccl::Shader* shader)
 {
-    for (auto it = m_cyclesScene->shaders.begin(); it != m_cyclesScene->shaders.end();) {
-        if (shader == *it) {
-            it = m_cyclesScene->shaders.erase(it);
-
-            m_shadersUpdated = true;
+    _FlushPendingAdditions();
 
-            break;
-        } else {
-            ++it;
-        }
+    if (m_shadersIndex.Remove(m_cyclesScene->shaders, shader)) {
+        m_shadersUpdated = true;
+        _RequestUpdate();
     }
-
-    if (m_shadersUpdated)
-        Interrupt();
 }
 
 void
 HdCyclesRenderParam::RemoveLight(ccl::Light* light)
 {
-    for (auto it = m_cyclesScene->lights.begin(); it != m_cyclesScene->lights.end();) {
-        if (light == *it) {
-            it = m_cyclesScene->lights.erase(it);
-
-            // TODO: This doesnt respect multiple dome lights
-            if (light->type == ccl::LIGHT_BACKGROUND) {
-                m_numDomeLights = std::max(0, m_numDomeLights - 1);
-            }
-
-            m_lightsUpdated = true;
+    _FlushPendingAdditions();
 
-            break;
-        } else {
-            ++it;
+    if (m_lightsIndex.Remove(m_cyclesScene->lights, light)) {
+        // TODO: This doesnt respect multiple dome lights
+        if (light->type == ccl::LIGHT_BACKGROUND) {
+            m_numDomeLights = std::max(0, m_numDomeLights - 1);
         }
-    }
 
-
-    if (m_lightsUpdated)
-        Interrupt();
+        m_lightsUpdated = true;
+        _RequestUpdate();
+    }
 }
 
 
 void
 HdCyclesRenderParam::RemoveObject(ccl::Object* object)
 {
-    for (auto it = m_cyclesScene->objects.begin(); it != m_cyclesScene->objects.end();) {
-        if (object == *it) {
-            it = m_cyclesScene->objects.erase(it);
+    _FlushPendingAdditions();
 
-            m_objectsUpdated = true;
-            break;
-        } else {
-            ++it;
-        }
+    if (m_objectsIndex.Remove(m_cyclesScene->objects, object)) {
+        m_objectsUpdated = true;
+        _RequestUpdate();
     }
-
-    if (m_objectsUpdated)
-        Interrupt();
 }
 
 void
 HdCyclesRenderParam::RemoveGeometry(ccl::Geometry* geometry)
 {
-    for (auto it = m_cyclesScene->geometry.begin(); it != m_cyclesScene->geometry.end();) {
-        if (geometry == *it) {
-            it = m_cyclesScene->geometry.erase(it);
+    _FlushPendingAdditions();
 
-            m_geometryUpdated = true;
-
-            break;
-        } else {
-            ++it;
-        }
+    if (m_geometryIndex.Remove(m_cyclesScene->geometry, geometry)) {
+        m_geometryUpdated = true;
+        _RequestUpdate();
     }
-
-    if (m_geometryUpdated)
-        Interrupt();
 }
 
 void
 HdCyclesRenderParam::AddShaderSafe(ccl::Shader* shader)
 {
-    ccl::thread_scoped_lock lock { m_cyclesScene->mutex };
     AddShader(shader);
 }
 
 void
 HdCyclesRenderParam::AddLightSafe(ccl::Light* light)
 {
-    ccl::thread_scoped_lock lock { m_cyclesScene->mutex };
     AddLight(light);
 }
 
 void
 HdCyclesRenderParam::AddObjectSafe(ccl::Object* object)
 {
-    ccl::thread_scoped_lock lock { m_cyclesScene->mutex };
     AddObject(object);
 }
 
 void
 HdCyclesRenderParam::AddGeometrySafe(ccl::Geometry* geometry)
 {
-    ccl::thread_scoped_lock lock { m_cyclesScene->mutex };
     AddGeometry(geometry);
 }
 
@@ -2293,6 +2481,8 @@ HdCyclesRenderParam::SetAovBindings(HdRenderPassAovBindingVector const& a_aovs)
     ccl::thread_scoped_lock scene_lock { m_cyclesScene->mutex };
 
     m_aovs = a_aovs;
+    _ResolveAovBindings();
+    ++m_sessionResets;
 
     m_bufferParams.passes.clear();
     bool has_combined = false;
@@ -2491,100 +2681,333 @@ HdCyclesRenderParam::RemoveAovBinding(HdRenderBuffer* rb)
     m_aovs.erase(std::remove_if(m_aovs.begin(), m_aovs.end(), [rb](HdRenderPassAovBinding& aov) { 
         return aov.renderBuffer == rb; 
     }), m_aovs.end());
+
+    _ResolveAovBindings();
 }
 // clang-format on
 
 void
-HdCyclesRenderParam::BlitFromCyclesPass(const HdRenderPassAovBinding& aov, int w, int h, int samples)
+HdCyclesRenderParam::_ResolveAovBindings()
 {
-    if (samples < 0) {
-        return;
+    m_resolvedAovs.clear();
+    m_resolvedAovs.reserve(m_aovs.size());
+
+    for (const HdRenderPassAovBinding& aov : m_aovs) {
+        if (!TF_VERIFY(aov.renderBuffer != nullptr)) {
+            continue;
+        }
+
+        HdCyclesAov cyclesAov;
+        if (!GetCyclesAov(aov, cyclesAov)) {
+            continue;
+        }
+
+        bool custom, denoise;
+        GetAovFlags(cyclesAov, custom, denoise);
+
+        HdCyclesResolvedAov resolved;
+        resolved.renderBuffer = aov.renderBuffer;
+        resolved.passName = custom ? aov.aovName.GetString() : cyclesAov.name;
+        resolved.type = cyclesAov.type;
+        resolved.format = cyclesAov.format;
+        resolved.numComponents = static_cast<int>(HdGetComponentCount(cyclesAov.format));
+        resolved.denoisePass = denoise ? GetDenoisePass(cyclesAov.token) : -1;
+
+        // We bump the PrimId() before sending it to hydra, decrementing it after the readback
+        resolved.idOffset = cyclesAov.type == ccl::PASS_OBJECT_ID ? -1 : 0;
+        resolved.filter = cyclesAov.filter;
+        m_resolvedAovs.push_back(std::move(resolved));
     }
+}
 
-    HdCyclesAov cyclesAov;
-    if (!GetCyclesAov(aov, cyclesAov)) {
+void
+HdCyclesRenderParam::BlitFromCyclesPasses(int w, int h, int samples)
+{
+    if (samples < 0 || m_resolvedAovs.empty()) {
         return;
     }
 
-    // The RenderParam logic should guarantee that aov bindings always point to valid renderbuffer
-    auto* rb = static_cast<HdCyclesRenderBuffer*>(aov.renderBuffer);
-    if (!rb) {
+    // Buffers only hold the samples of the range when resuming from a checkpoint
+    const int rangeStart = std::max(m_cyclesSession->tile_manager.range_start_sample, 0);
+    const int rangeSamples = samples + 1 - rangeStart;
+    if (rangeSamples <= 0) {
         return;
     }
 
-    if (rb->GetFormat() == HdFormatInvalid) {
-        return;
+    struct PassReadback {
+        const HdCyclesResolvedAov* aov;
+        HdCyclesRenderBuffer* rb;
+        ccl::RenderBuffers::ComponentType pixelsType;
+        HdFormat format;
+        int32_t idOffset;
+        uint8_t* data;  // Back buffer, null if it is not written
+        bool direct;    // Pass is read from the Cycles buffer by the sweep
+        HdCyclesPassLayout layout;
+        const HdCyclesCheckpoint::Layer* checkpoint;
+    };
+
+    // Validate all bound AOVs up front, the Cycles buffers are then read in one batch
+    std::vector<PassReadback> readbacks;
+    readbacks.reserve(m_resolvedAovs.size());
+
+    for (const HdCyclesResolvedAov& aov : m_resolvedAovs) {
+        // Denoising passes are not read back in progressive mode, keep whatever the buffer holds
+        if (aov.denoisePass >= 0) {
+            continue;
+        }
+
+        // The RenderParam logic should guarantee that aov bindings always point to valid renderbuffer
+        auto* rb = static_cast<HdCyclesRenderBuffer*>(aov.renderBuffer);
+        const HdFormat format = rb->GetFormat();
+        if (format == HdFormatInvalid) {
+            continue;
+        }
+
+        // No point in blitting since the session will be reset
+        const unsigned int dstWidth = rb->GetWidth();
+        const unsigned int dstHeight = rb->GetHeight();
+        if (m_resolutionDisplay[0] != dstWidth || m_resolutionDisplay[1] != dstHeight) {
+            continue;
+        }
+
+        const int n_comps_hd = static_cast<int>(HdGetComponentCount(format));
+        if (aov.numComponents > n_comps_hd) {
+            TF_WARN("Don't know how to narrow aov %s from %d components (cycles) to %d components (HdRenderBuffer)",
+                    aov.passName.c_str(), aov.numComponents, n_comps_hd);
+            continue;
+        }
+
+        ccl::RenderBuffers::ComponentType pixels_type = ccl::RenderBuffers::ComponentType::None;
+        switch (format) {
+        case HdFormatFloat16: pixels_type = ccl::RenderBuffers::ComponentType::Float16; break;
+        case HdFormatFloat16Vec3: pixels_type = ccl::RenderBuffers::ComponentType::Float16x3; break;
+        case HdFormatFloat16Vec4: pixels_type = ccl::RenderBuffers::ComponentType::Float16x4; break;
+        case HdFormatFloat32: pixels_type = ccl::RenderBuffers::ComponentType::Float32; break;
+        case HdFormatFloat32Vec3: pixels_type = ccl::RenderBuffers::ComponentType::Float32x3; break;
+        case HdFormatFloat32Vec4: pixels_type = ccl::RenderBuffers::ComponentType::Float32x4; break;
+        case HdFormatInt32: pixels_type = ccl::RenderBuffers::ComponentType::Int32; break;
+        default: assert(false); break;
+        }
+
+        // todo: Is there a utility to convert HdFormat to string?
+        if (pixels_type == ccl::RenderBuffers::ComponentType::None) {
+            TF_WARN("Unsupported component type %d for aov %s ", static_cast<int>(format), aov.passName.c_str());
+            continue;
+        }
+
+        int32_t idOffset = aov.idOffset;
+        if (idOffset != 0 && format != HdFormatInt32) {
+            TF_WARN("Object ID pass %s has unrecognized type", aov.passName.c_str());
+            idOffset = 0;
+        }
+
+        readbacks.push_back({ &aov, rb, pixels_type, format, idOffset, nullptr, false, {}, nullptr });
     }
 
-    // No point in blitting since the session will be reset
-    const unsigned int dstWidth = rb->GetWidth();
-    const unsigned int dstHeight = rb->GetHeight();
-    if (m_resolutionDisplay[0] != dstWidth || m_resolutionDisplay[1] != dstHeight) {
+    if (readbacks.empty()) {
         return;
     }
 
-    // This acquires the whole object, not just the pixel buffer
-    // It needs to wrap any getters
-    void* data = rb->Map();
-
-    if (data) {
-        const int n_comps_cycles = static_cast<int>(HdGetComponentCount(cyclesAov.format));
-        const int n_comps_hd = static_cast<int>(HdGetComponentCount(rb->GetFormat()));
-
-        if (n_comps_cycles <= n_comps_hd) {
-            ccl::RenderBuffers::ComponentType pixels_type = ccl::RenderBuffers::ComponentType::None;
-            switch (rb->GetFormat()) {
-            case HdFormatFloat16: pixels_type = ccl::RenderBuffers::ComponentType::Float16; break;
-            case HdFormatFloat16Vec3: pixels_type = ccl::RenderBuffers::ComponentType::Float16x3; break;
-            case HdFormatFloat16Vec4: pixels_type = ccl::RenderBuffers::ComponentType::Float16x4; break;
-            case HdFormatFloat32: pixels_type = ccl::RenderBuffers::ComponentType::Float32; break;
-            case HdFormatFloat32Vec3: pixels_type = ccl::RenderBuffers::ComponentType::Float32x3; break;
-            case HdFormatFloat32Vec4: pixels_type = ccl::RenderBuffers::ComponentType::Float32x4; break;
-            case HdFormatInt32: pixels_type = ccl::RenderBuffers::ComponentType::Int32; break;
-            default: assert(false); break;
-            }
+    const float exposure = m_cyclesScene->film->exposure;
+    ccl::RenderBuffers* buffers = m_cyclesSession->buffers;
+    const auto dstWidth = static_cast<unsigned int>(m_resolutionDisplay[0]);
+    const auto dstHeight = static_cast<unsigned int>(m_resolutionDisplay[1]);
+
+    // Cycles writes the whole frame into the back buffers, readers keep the previous frame until EndWrite
+    const GfRect2i region { GfVec2i { 0, 0 }, static_cast<int>(dstWidth), static_cast<int>(dstHeight) };
+    for (PassReadback& readback : readbacks) {
+        HdCyclesRenderBuffer* rb = readback.rb;
+        readback.data = static_cast<uint8_t*>(rb->BeginWrite(region));
+        if (!readback.data) {
+            // Being resized, the session is going to be reset
+            continue;
+        }
 
-            // todo: Is there a utility to convert HdFormat to string?
-            if (pixels_type == ccl::RenderBuffers::ComponentType::None) {
-                TF_WARN("Unsupported component type %d for aov %s ", static_cast<int>(rb->GetFormat()),
-                        aov.aovName.GetText());
-                rb->Unmap();
-                return;
-            }
+        // Resized since the resolution check, session is going to be reset
+        if (rb->GetWidth() != dstWidth || rb->GetHeight() != dstHeight || rb->GetFormat() != readback.format) {
+            rb->DiscardWrite(region);
+            readback.data = nullptr;
+            continue;
+        }
 
-            bool custom, denoise;
-            GetAovFlags(cyclesAov, custom, denoise);
-
-            const int stride = static_cast<int>(HdDataSizeOfFormat(rb->GetFormat()));
-            const float exposure = m_cyclesScene->film->exposure;
-            auto buffers = m_cyclesSession->buffers;
-            if (!custom && !denoise) {
-                buffers->get_pass_rect_as(cyclesAov.name.c_str(), exposure, samples + 1, n_comps_cycles,
-                                          static_cast<uint8_t*>(data), pixels_type, w, h, dstWidth, dstHeight, stride);
-            } else if (custom) {
-                buffers->get_pass_rect_as(aov.aovName.GetText(), exposure, samples + 1, n_comps_cycles,
-                                          static_cast<uint8_t*>(data), pixels_type, w, h, dstWidth, dstHeight, stride);
-            }
+        const HdCyclesResolvedAov& aov = *readback.aov;
+        readback.direct = GetPassLayout(buffers->params, aov.passName, aov.numComponents, exposure, rangeSamples,
+                                        readback.layout);
 
+        // Averages of the checkpoint and the remaining samples, ids and depth are kept as rendered
+        if (aov.filter) {
+            readback.checkpoint = m_resumeCheckpoint.GetBlendLayer(aov.passName, readback.format, dstWidth,
+                                                                   dstHeight);
+        }
 
-            if (cyclesAov.type == ccl::PASS_OBJECT_ID) {
-                if (n_comps_hd == 1 && rb->GetFormat() == HdFormatInt32) {
-                    /* We bump the PrimId() before sending it to hydra, decrementing it here */
-                    int32_t* pixels = static_cast<int32_t*>(data);
-                    for (size_t i = 0; i < rb->GetWidth() * rb->GetHeight(); ++i) {
-                        pixels[i] -= 1;
-                    }
+        // Passes that are not stored per pixel, like the render time, are left to Cycles. None of them are
+        // filtered or ids, they have no fix-ups.
+        if (!readback.direct) {
+            const int stride = static_cast<int>(HdDataSizeOfFormat(readback.format));
+            buffers->get_pass_rect_as(aov.passName.c_str(), exposure, rangeSamples, aov.numComponents,
+                                      readback.data, readback.pixelsType, w, h, dstWidth, dstHeight, stride);
+        }
+    }
+
+    // Nearest pixel of the Cycles buffer for every display column
+    std::vector<unsigned int> columns(dstWidth);
+    for (unsigned int x = 0; x < dstWidth; ++x) {
+        columns[x] = std::min(static_cast<unsigned int>(static_cast<size_t>(x) * w / dstWidth),
+                              static_cast<unsigned int>(w - 1));
+    }
+
+    const float checkpointWeight = m_resumeCheckpoint.GetBlendWeight(rangeSamples);
+    const float* pixels = buffers->buffer.data();
+    const int passStride = buffers->params.get_passes_size();
+
+    // Single sweep over the interleaved Cycles buffer, every row of it is read once for all the AOVs. Values are
+    // resolved, blended with the checkpoint and offset while the row is hot, then written in the buffer format.
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, dstHeight, HdCyclesReadbackGrainRows),
+                      [&](const tbb::blocked_range<size_t>& r) {
+        std::vector<float> scratch;
+        for (size_t y = r.begin(); y < r.end(); ++y) {
+            const size_t sy = std::min(y * static_cast<size_t>(h) / dstHeight, static_cast<size_t>(h - 1));
+            const float* row = pixels + sy * static_cast<size_t>(w) * passStride;
+
+            for (const PassReadback& readback : readbacks) {
+                if (!readback.data || !readback.direct) {
+                    continue;
+                }
+
+                const HdFormat componentFormat = HdGetComponentFormat(readback.format);
+                const int dstComponents = static_cast<int>(HdGetComponentCount(readback.format));
+                const size_t numValues = static_cast<size_t>(dstWidth) * dstComponents;
+                uint8_t* dst = readback.data + y * dstWidth * HdDataSizeOfFormat(readback.format);
+
+                // Float buffers are resolved in place
+                float* values = nullptr;
+                if (componentFormat == HdFormatFloat32) {
+                    values = reinterpret_cast<float*>(dst);
                 } else {
-                    TF_WARN("Object ID pass %s has unrecognized type", aov.aovName.GetText());
+                    scratch.resize(numValues);
+                    values = scratch.data();
+                }
+
+                ReadPassRow(readback.layout, row, passStride, columns.data(), dstWidth,
+                            readback.aov->numComponents, dstComponents, values);
+
+                if (readback.checkpoint) {
+                    const uint8_t* saved = readback.checkpoint->data.data()
+                                           + y * dstWidth * HdDataSizeOfFormat(readback.format);
+                    if (componentFormat == HdFormatFloat32) {
+                        auto savedValues = reinterpret_cast<const float*>(saved);
+                        for (size_t i = 0; i < numValues; ++i) {
+                            values[i] = savedValues[i] * checkpointWeight + values[i] * (1.0f - checkpointWeight);
+                        }
+                    } else {
+                        auto savedValues = reinterpret_cast<const GfHalf*>(saved);
+                        for (size_t i = 0; i < numValues; ++i) {
+                            values[i] = static_cast<float>(savedValues[i]) * checkpointWeight
+                                        + values[i] * (1.0f - checkpointWeight);
+                        }
+                    }
+                }
+
+                if (componentFormat == HdFormatFloat16) {
+                    float_to_half(values, reinterpret_cast<GfHalf*>(dst), numValues);
+                } else if (componentFormat == HdFormatInt32) {
+                    // We bump the PrimId() before sending it to hydra, it is decremented here
+                    auto ids = reinterpret_cast<int32_t*>(dst);
+                    for (size_t i = 0; i < numValues; ++i) {
+                        ids[i] = static_cast<int32_t>(values[i]) + readback.idOffset;
+                    }
                 }
             }
-        } else {
-            TF_WARN("Don't know how to narrow aov %s from %d components (cycles) to %d components (HdRenderBuffer)",
-                    aov.aovName.GetText(), n_comps_cycles, n_comps_hd);
+        }
+    });
+
+    for (const PassReadback& readback : readbacks) {
+        if (readback.data) {
+            readback.rb->EndWrite(region);
+        }
+    }
+
+    // Edits from now on are not part of the checkpointed render anymore
+    m_resumeCheckpoint.SetDisplayed();
+}
+
+void
+HdCyclesRenderParam::SetCheckpoint(const std::string& path, double interval)
+{
+    m_checkpointPath.clear();
+    m_checkpointInterval = interval;
+    m_checkpointTime = 0.0;
+    m_checkpointRequested = false;
+    m_resumeCheckpoint.Clear();
+
+    if (path.empty() || !m_cyclesSession) {
+        return;
+    }
+
+    // Tiles are written once finished, there are no intermediate buffers to save
+    if (m_useTiledRendering) {
+        TF_WARN("Checkpoints are only supported in progressive mode, ignoring %s", path.c_str());
+        return;
+    }
+
+    m_checkpointPath = path;
+
+    if (!m_resumeCheckpoint.Read(path)) {
+        return;
+    }
+
+    const int totalSamples = m_cyclesSession->params.samples;
+    const int checkpointSamples = m_resumeCheckpoint.GetSamples();
+    if (checkpointSamples >= totalSamples) {
+        TF_WARN("Checkpoint %s already has %d of %d samples", path.c_str(), checkpointSamples, totalSamples);
+    }
+
+    // Sample range is absolute, the random sequence continues where the checkpoint stopped
+    m_cyclesSession->tile_manager.range_start_sample = m_resumeCheckpoint.GetRangeStart();
+    m_cyclesSession->tile_manager.range_num_samples = m_resumeCheckpoint.GetRangeSamples(totalSamples);
+}
+
+void
+HdCyclesRenderParam::_ResetResume()
+{
+    // Checkpoint is only modified on this thread, the display copy reads it under the display lock
+    if (m_resumeCheckpoint.IsEmpty()) {
+        return;
+    }
+
+    ccl::thread_scoped_lock display_lock = m_cyclesSession->acquire_display_lock();
+    if (m_resumeCheckpoint.Reset()) {
+        m_cyclesSession->tile_manager.range_start_sample = -1;
+        m_cyclesSession->tile_manager.range_num_samples = -1;
+    }
+}
+
+void
+HdCyclesRenderParam::_WriteCheckpoint(int samples)
+{
+    HdCyclesCheckpoint checkpoint;
+    checkpoint.SetSamples(samples + 1);
+
+    for (const HdCyclesResolvedAov& aov : m_resolvedAovs) {
+        if (aov.denoisePass >= 0) {
+            continue;
+        }
+
+        auto* rb = static_cast<HdCyclesRenderBuffer*>(aov.renderBuffer);
+        const HdFormat format = rb->GetFormat();
+        if (format == HdFormatInvalid) {
+            continue;
+        }
+
+        const void* data = rb->Map();
+        if (data) {
+            checkpoint.SetLayer(aov.passName, format, rb->GetWidth(), rb->GetHeight(), data);
         }
         rb->Unmap();
-    } else {
-        TF_WARN("Failed to map renderbuffer %s for writing on Cycles display callback", aov.aovName.GetText());
+    }
+
+    if (!checkpoint.IsEmpty()) {
+        checkpoint.Write(m_checkpointPath);
     }
 }
 
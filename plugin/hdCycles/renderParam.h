@@ -21,6 +21,7 @@
 #define HD_CYCLES_RENDER_PARAM_H
 
 #include "api.h"
+#include "checkpoint.h"
 
 #include <device/device.h>
 #include <render/buffers.h>
@@ -31,10 +32,21 @@
 #include <pxr/imaging/hd/renderDelegate.h>
 #include <pxr/pxr.h>
 
+#include <tbb/concurrent_queue.h>
+#include <tbb/enumerable_thread_specific.h>
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
 namespace ccl {
 class Session;
 class Scene;
+class Geometry;
+class Light;
 class Mesh;
+class Object;
 class PointCloud;
 class RenderTile;
 class Shader;
@@ -42,6 +54,92 @@ class Shader;
 
 PXR_NAMESPACE_OPEN_SCOPE
 
+///
+/// AOV binding resolved against the Cycles passes, built once per SetAovBindings and read for every tile
+///
+struct HdCyclesResolvedAov {
+    HdRenderBuffer* renderBuffer;
+    std::string passName;  // Cycles pass name, AOV name for custom passes
+    ccl::PassType type;
+    HdFormat format;
+    int numComponents;
+    int denoisePass;  // Denoising pass, -1 for regular passes
+    int32_t idOffset;  // Added to integer ids after the display readback, 0 if none
+    bool filter;  // Pixel filtered pass, can be blended with a checkpoint
+};
+
+///
+/// Pointer to index side table for one of the scene vectors (objects, geometry, shaders, lights).
+/// Removal swaps the last element into the freed slot, scene vector stays dense and order is not preserved.
+/// Items pushed to the scene vector directly, bypassing the table, are still found with a linear search.
+///
+template<typename T> class HdCyclesSceneIndexTable {
+public:
+    void Add(ccl::vector<T*>& items, T* item)
+    {
+        items.push_back(item);
+        m_indices[item] = items.size() - 1;
+    }
+
+    bool Remove(ccl::vector<T*>& items, const T* item)
+    {
+        size_t index = items.size();
+
+        auto it = m_indices.find(item);
+        if (it != m_indices.end()) {
+            if (it->second < items.size() && items[it->second] == item) {
+                index = it->second;
+            }
+            m_indices.erase(it);
+        }
+
+        if (index == items.size()) {
+            auto found = std::find(items.begin(), items.end(), item);
+            if (found == items.end()) {
+                return false;
+            }
+            index = static_cast<size_t>(std::distance(items.begin(), found));
+        }
+
+        T* last = items.back();
+        items[index] = last;
+        items.pop_back();
+        if (last != item) {
+            m_indices[last] = index;
+        }
+
+        return true;
+    }
+
+    /// Remove all items matching the predicate with one compaction pass over the scene vector
+    template<typename Predicate> size_t RemoveIf(ccl::vector<T*>& items, Predicate&& predicate)
+    {
+        size_t write = 0;
+        for (size_t read = 0; read < items.size(); ++read) {
+            T* item = items[read];
+            if (predicate(item)) {
+                m_indices.erase(item);
+                continue;
+            }
+
+            if (write != read) {
+                items[write] = item;
+                m_indices[item] = write;
+            }
+            ++write;
+        }
+
+        const size_t num_removed = items.size() - write;
+        items.resize(write);
+        return num_removed;
+    }
+
+    void Clear() { m_indices.clear(); }
+
+private:
+    std::unordered_map<const T*, size_t> m_indices;
+};
+
 /**
  * @brief The proposed main interface to the cycles session and scene
  * Very much under construction.
@@ -82,7 +180,8 @@ public:
     void RestartRender();
 
     /**
-     * @brief Restarts the current cycles render
+     * @brief Request a session reset on the next CommitResources. Session is paused only by the first
+     * request in the frame.
      * 
      */
     void Interrupt(bool a_forceUpdate = false);
@@ -126,7 +225,23 @@ public:
      */
     bool SetRenderSetting(const TfToken& key, const VtValue& valuekey);
 
-    void BlitFromCyclesPass(const HdRenderPassAovBinding& aov, int w, int h, int samples);
+    /**
+     * @brief Read back all bound AOVs from the Cycles display buffers in one batch
+     * 
+     * @param w Width of the Cycles buffers
+     * @param h Height of the Cycles buffers
+     * @param samples Number of samples rendered so far
+     */
+    void BlitFromCyclesPasses(int w, int h, int samples);
+
+    /**
+     * @brief Periodically save the progressive render to a checkpoint. If the checkpoint
+     * already exists the render resumes from it and only renders the remaining samples
+     * 
+     * @param path Checkpoint file, empty disables checkpoints
+     * @param interval Seconds between checkpoints
+     */
+    void SetCheckpoint(const std::string& path, double interval);
 
     GfVec4f GetDataWindowNDC() const { return m_dataWindowNDC; }
     float MaxOverscan() const;
@@ -218,6 +333,13 @@ public:
      */
     bool SetDeviceType(const std::string& a_deviceType);
 
+    /* ====== Scene mutations ====== */
+
+    // Additions are queued and moved into the scene by CommitResources, they are safe to call from any thread.
+    // Removals take effect immediately, caller can delete the resource right after the call. Any queued
+    // additions are moved into the scene first. Neither of them interrupts the render, the session is reset
+    // once by CommitResources.
+
     /* ====== Thread unsafe operations ====== */
 
     void AddShader(ccl::Shader* shader);
@@ -321,7 +443,19 @@ private:
     bool m_lightsUpdated;
     bool m_shadersUpdated;
 
-    bool m_shouldUpdate;
+    std::atomic<bool> m_shouldUpdate;
+
+    // Display copy is skipped when neither samples nor session changed since the last one
+    std::atomic<int> m_sessionResets;
+    int m_displaySamples;
+    int m_displayResets;
+
+    // Checkpoint is requested by the progress callback and written by the next display copy
+    std::string m_checkpointPath;
+    double m_checkpointInterval;
+    double m_checkpointTime;
+    std::atomic<bool> m_checkpointRequested;
+    HdCyclesCheckpoint m_resumeCheckpoint;
 
     int m_numDomeLights;
 
@@ -378,8 +512,55 @@ private:
     ccl::Session* m_cyclesSession;
     ccl::Scene* m_cyclesScene;
 
+    HdCyclesSceneIndexTable<ccl::Object> m_objectsIndex;
+    HdCyclesSceneIndexTable<ccl::Geometry> m_geometryIndex;
+    HdCyclesSceneIndexTable<ccl::Shader> m_shadersIndex;
+    HdCyclesSceneIndexTable<ccl::Light> m_lightsIndex;
+
+    /**
+     * @brief Move queued additions into the scene. Must be called under the scene lock
+     * 
+     */
+    void _FlushPendingAdditions();
+
+    /**
+     * @brief Flag the scene for a reset on next commit, the first request since the last commit pauses the session
+     * 
+     */
+    void _RequestUpdate();
+
+    tbb::concurrent_queue<ccl::Object*> m_pendingObjects;
+    tbb::concurrent_queue<ccl::Geometry*> m_pendingGeometry;
+    tbb::concurrent_queue<ccl::Shader*> m_pendingShaders;
+    tbb::concurrent_queue<ccl::Light*> m_pendingLights;
+
     HdRenderPassAovBindingVector m_aovs;
 
+    /**
+     * @brief Rebuild the resolved AOV table from the current bindings. Must be called under the display lock
+     * 
+     */
+    void _ResolveAovBindings();
+
+    std::vector<HdCyclesResolvedAov> m_resolvedAovs;
+
+    /**
+     * @brief Save the render buffers of all bound AOVs to the checkpoint file. Must be called under the display lock
+     * 
+     * @param samples Number of samples rendered so far
+     */
+    void _WriteCheckpoint(int samples);
+
+    /**
+     * @brief Stop resuming from the checkpoint once its render was displayed, the session is about to be reset
+     * for an edit and renders all samples again
+     * 
+     */
+    void _ResetResume();
+
+    // Per thread tile read back scratch, grows to the largest tile and is reused for all AOVs
+    tbb::enumerable_thread_specific<std::vector<float>> m_tileScratch;
+
     bool m_settingsHaveChanged = false;
 
 public:
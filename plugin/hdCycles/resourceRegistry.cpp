@@ -21,7 +21,9 @@
 #include "renderDelegate.h"
 #include "renderParam.h"
 
+#include <pxr/base/arch/hash.h>
 #include <pxr/base/work/loops.h>
+#include <pxr/imaging/hd/perfLog.h>
 #include <pxr/usd/sdf/path.h>
 
 #include <render/object.h>
@@ -29,6 +31,52 @@
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
+namespace {
+
+/// Distinct sample time sets kept between commits, a scene rarely has more than a few
+constexpr size_t HdCyclesMaxTimeSamplings = 1024;
+
+template<typename T>
+uint64_t
+HashArray(const VtArray<T>& array, uint64_t seed)
+{
+    return ArchHash64(reinterpret_cast<const char*>(array.cdata()), array.size() * sizeof(T), seed);
+}
+
+///
+/// Subdivision key covers everything that OpenSubdiv tables depend on: faces, scheme, orientation, holes,
+/// subdivision tags and refine level.
+///
+HdInstance<HdCyclesSubdTablesSharedPtr>::ID
+ComputeSubdTablesKey(const HdMeshTopology& topology, int refine_level)
+{
+    uint64_t hash = topology.ComputeHash();
+    hash = ArchHash64(reinterpret_cast<const char*>(&refine_level), sizeof(refine_level), hash);
+
+    const auto subdiv_tags_hash = topology.GetSubdivTags().ComputeHash();
+    return ArchHash64(reinterpret_cast<const char*>(&subdiv_tags_hash), sizeof(subdiv_tags_hash), hash);
+}
+
+///
+/// Topology key covers everything that refiner depends on, HdMeshTopology::ComputeHash does not include
+/// geometry subsets used by the material refinement.
+///
+HdInstance<HdBbMeshTopologySharedPtr>::ID
+ComputeMeshTopologyKey(const HdMeshTopology& topology, int refine_level)
+{
+    uint64_t hash = ComputeSubdTablesKey(topology, refine_level);
+
+    for (const HdGeomSubset& subset : topology.GetGeomSubsets()) {
+        const size_t material_hash = subset.materialId.GetHash();
+        hash = ArchHash64(reinterpret_cast<const char*>(&material_hash), sizeof(material_hash), hash);
+        hash = HashArray(subset.indices, hash);
+    }
+
+    return hash;
+}
+
+}  // namespace
+
 HdCyclesResourceRegistry::HdCyclesResourceRegistry(HdCyclesRenderDelegate* renderDelegate)
     : m_renderDelegate { renderDelegate }
 {
@@ -60,6 +108,21 @@ HdCyclesResourceRegistry::_Commit()
         object_source.second.value->Resolve();
     }
 
+    // * resolve all pending transforms in batches, sources sharing sample times are resampled together
+    std::vector<HdCyclesTransformSource*> transform_sources;
+    for (auto& object_source : m_objects) {
+        HdCyclesTransformSource* transform_source = object_source.second.value->GetPendingTransformSource();
+        if (transform_source) {
+            transform_sources.push_back(transform_source);
+        }
+    }
+    if (m_time_samplings.GetSize() > HdCyclesMaxTimeSamplings) {
+        m_time_samplings.Clear();
+    }
+    if (HdCyclesTransformSource::ResolveBatch(transform_sources, &m_time_samplings) > 0) {
+        requires_reset = true;
+    }
+
     // * commit all pending object resources
     using ValueType = HdInstanceRegistry<HdCyclesObjectSourceSharedPtr>::const_iterator::value_type;
     WorkParallelForEach(m_objects.begin(), m_objects.end(), [&requires_reset, scene](const ValueType& object_source) {
@@ -84,6 +147,10 @@ HdCyclesResourceRegistry::_GarbageCollect()
 
     // delete unique objects
     m_objects.GarbageCollect();
+
+    // delete topologies no longer referenced by any mesh, then subdivision tables they released
+    m_mesh_topologies.GarbageCollect();
+    m_subd_tables.GarbageCollect();
 }
 
 HdInstance<HdCyclesObjectSourceSharedPtr>
@@ -91,3 +158,55 @@ HdCyclesResourceRegistry::GetObjectInstance(const SdfPath& id)
 {
     return m_objects.GetInstance(id.GetHash());
 }
+
+HdBbMeshTopologySharedPtr
+HdCyclesResourceRegistry::GetMeshTopology(const SdfPath& id, const HdMeshTopology& topology, int refine_level)
+{
+    const HdInstance<HdBbMeshTopologySharedPtr>::ID key = ComputeMeshTopologyKey(topology, refine_level);
+
+    // Instance holds the registry lock, refinement is done without it. Two meshes with the same topology
+    // might refine it at the same time, only the first one is kept.
+    {
+        HdInstance<HdBbMeshTopologySharedPtr> instance = m_mesh_topologies.GetInstance(key);
+        if (instance.GetValue()) {
+            return instance.GetValue();
+        }
+    }
+
+    HdCyclesSubdTablesSharedPtr subd_tables;
+    if (HdBbMeshTopology::IsSubdivided(topology, refine_level)) {
+        subd_tables = _GetSubdTables(id, topology, refine_level);
+    }
+
+    auto refined_topology = std::make_shared<HdBbMeshTopology>(id, topology, refine_level, std::move(subd_tables));
+
+    HdInstance<HdBbMeshTopologySharedPtr> instance = m_mesh_topologies.GetInstance(key);
+    if (!instance.GetValue()) {
+        instance.SetValue(refined_topology);
+    }
+    return instance.GetValue();
+}
+
+HdCyclesSubdTablesSharedPtr
+HdCyclesResourceRegistry::_GetSubdTables(const SdfPath& id, const HdMeshTopology& topology, int refine_level)
+{
+    HD_TRACE_FUNCTION();
+
+    const HdInstance<HdCyclesSubdTablesSharedPtr>::ID key = ComputeSubdTablesKey(topology, refine_level);
+
+    // Same two phase lookup as for topologies, building tables is the most expensive part of the refinement
+    {
+        HdInstance<HdCyclesSubdTablesSharedPtr> instance = m_subd_tables.GetInstance(key);
+        if (instance.GetValue()) {
+            return instance.GetValue();
+        }
+    }
+
+    HdCyclesSubdTablesSharedPtr subd_tables = HdCyclesCreateSubdTables(id, topology, refine_level);
+
+    HdInstance<HdCyclesSubdTablesSharedPtr> instance = m_subd_tables.GetInstance(key);
+    if (!instance.GetValue()) {
+        instance.SetValue(subd_tables);
+    }
+    return instance.GetValue();
+}
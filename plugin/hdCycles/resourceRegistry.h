@@ -20,6 +20,7 @@
 #ifndef HDCYCLES_RESOURCEREGISTRY_H
 #define HDCYCLES_RESOURCEREGISTRY_H
 
+#include "meshRefiner.h"
 #include "objectSource.h"
 
 #include <pxr/imaging/hd/bufferSource.h>
@@ -42,12 +43,27 @@ public:
 
     HdInstance<HdCyclesObjectSourceSharedPtr> GetObjectInstance(const SdfPath& id);
 
+    ///
+    /// Triangulated/refined topology shared between meshes. Identical topologies (including subdivision tags,
+    /// geometry subsets and refine level) are refined once and reused, together with the refiner's stencil tables.
+    /// Shared topology keeps the id of the mesh that created it, it is used for diagnostics only.
+    ///
+    HdBbMeshTopologySharedPtr GetMeshTopology(const SdfPath& id, const HdMeshTopology& topology, int refine_level);
+
 private:
     void _Commit() override;
     void _GarbageCollect() override;
 
+    /// OpenSubdiv tables shared between topologies that differ in geometry subsets only
+    HdCyclesSubdTablesSharedPtr _GetSubdTables(const SdfPath& id, const HdMeshTopology& topology, int refine_level);
+
     HdCyclesRenderDelegate* m_renderDelegate;
     HdInstanceRegistry<HdCyclesObjectSourceSharedPtr> m_objects;
+    HdInstanceRegistry<HdBbMeshTopologySharedPtr> m_mesh_topologies;
+    HdInstanceRegistry<HdCyclesSubdTablesSharedPtr> m_subd_tables;
+
+    /// Transform sample times interned across commits, accessed under the scene lock only
+    HdCyclesTimeSamplingCache m_time_samplings;
 };
 
 using HdCyclesResourceRegistrySharedPtr = std::shared_ptr<HdCyclesResourceRegistry>;
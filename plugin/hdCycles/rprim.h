@@ -37,6 +37,15 @@ public:
 
     using HdPrimvarDescriptorMap = std::map<HdInterpolation, HdPrimvarDescriptorVector>;
 
+    /// Object settings authored by primvars, fetched without touching the ccl::Object
+    struct ObjectSettings {
+        bool is_shadow_catcher = false;
+        int pass_id = 0;
+        bool use_holdout = false;
+        ccl::ustring asset_name;
+        ccl::ustring lightgroup;
+    };
+
 protected:
     HdBbRPrim(SdfPath const& id, SdfPath const& instancerId)
         : T { id, instancerId }
@@ -62,8 +71,15 @@ protected:
     void GetObjectPrimvars(HdPrimvarDescriptorMap const& descriptor_map, HdSceneDelegate* sceneDelegate,
                            const HdDirtyBits* dirtyBits)
     {
-        assert(m_cyclesObject != nullptr);
+        ObjectSettings settings;
+        FetchObjectPrimvars(descriptor_map, sceneDelegate, dirtyBits, &settings);
+        ApplyObjectSettings(settings);
+    }
 
+    /// Query object primvars, visibility and motion settings are stored in the rprim. Does not touch the scene.
+    void FetchObjectPrimvars(HdPrimvarDescriptorMap const& descriptor_map, HdSceneDelegate* sceneDelegate,
+                             const HdDirtyBits* dirtyBits, ObjectSettings* settings)
+    {
         const SdfPath& id = T::GetId();
 
         // visibility
@@ -81,11 +97,7 @@ protected:
         m_motionDeformSteps = 3;
 
         // pass and names
-        m_cyclesObject->is_shadow_catcher = false;
-        m_cyclesObject->pass_id = 0;
-        m_cyclesObject->use_holdout = false;
-        m_cyclesObject->asset_name = "";
-        m_cyclesObject->lightgroup = "";
+        *settings = ObjectSettings {};
 
         for (auto& descriptor_interpolation : descriptor_map) {
             for (auto& pv : descriptor_interpolation.second) {
@@ -155,34 +167,34 @@ protected:
                 if (primvar_name == usdCyclesTokens->primvarsCyclesObjectAsset_name) {
                     VtValue value = T::GetPrimvar(sceneDelegate, pv.name);
                     auto& assetName = value.Get<std::string>();
-                    m_cyclesObject->asset_name = ccl::ustring(assetName);
+                    settings->asset_name = ccl::ustring(assetName);
                     continue;
                 }
 
                 if (primvar_name == usdCyclesTokens->primvarsCyclesObjectLightgroup) {
                     VtValue value = T::GetPrimvar(sceneDelegate, pv.name);
                     auto& lightGroup = value.Get<std::string>();
-                    m_cyclesObject->lightgroup = ccl::ustring(lightGroup);
+                    settings->lightgroup = ccl::ustring(lightGroup);
                     continue;
                 }
 
                 // pass
                 if (primvar_name == usdCyclesTokens->primvarsCyclesObjectPass_id) {
                     VtValue value = T::GetPrimvar(sceneDelegate, pv.name);
-                    m_cyclesObject->pass_id = value.Get<int>();
+                    settings->pass_id = value.Get<int>();
                     continue;
                 }
 
                 // shadows
                 if (primvar_name == usdCyclesTokens->primvarsCyclesObjectIs_shadow_catcher) {
                     VtValue value = T::GetPrimvar(sceneDelegate, pv.name);
-                    m_cyclesObject->is_shadow_catcher = value.Get<bool>();
+                    settings->is_shadow_catcher = value.Get<bool>();
                     continue;
                 }
 
                 if (primvar_name == usdCyclesTokens->primvarsCyclesObjectUse_holdout) {
                     VtValue value = T::GetPrimvar(sceneDelegate, pv.name);
-                    m_cyclesObject->use_holdout = value.Get<bool>();
+                    settings->use_holdout = value.Get<bool>();
                     continue;
                 }
             }
@@ -197,6 +209,18 @@ protected:
         m_visibilityFlags |= visTransmission ? ccl::PATH_RAY_TRANSMIT : 0;
     }
 
+    /// Write fetched settings to the ccl::Object. Must be called under the scene lock
+    void ApplyObjectSettings(const ObjectSettings& settings)
+    {
+        assert(m_cyclesObject != nullptr);
+
+        m_cyclesObject->is_shadow_catcher = settings.is_shadow_catcher;
+        m_cyclesObject->pass_id = settings.pass_id;
+        m_cyclesObject->use_holdout = settings.use_holdout;
+        m_cyclesObject->asset_name = settings.asset_name;
+        m_cyclesObject->lightgroup = settings.lightgroup;
+    }
+
     void UpdateObject(ccl::Scene* scene, HdDirtyBits* dirtyBits, bool rebuildBvh)
     {
         assert(m_cyclesObject != nullptr);
@@ -22,7 +22,14 @@
 
 #include <util/util_transform.h>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <unordered_set>
+#include <vector>
 
 namespace {
 
@@ -129,8 +136,64 @@ HdCyclesAreTimeSamplesUniformlyDistributed(const HdTimeSampleArray<TYPE, CAPACIT
     return true;
 }
 
+/// Frame centered motion blur only
+bool
+HdCyclesIsShutterCentered(const float* times, unsigned int num_samples)
+{
+    const float shutter_open = times[0];
+    const float shutter_close = times[num_samples - 1];
+    return std::abs(std::abs(shutter_close) - std::abs(shutter_open)) <= HdCyclesIndexedTimeSample::epsilon;
+}
+
 }  // namespace
 
+const HdCyclesTimeSampling&
+HdCyclesTimeSamplingCache::Get(const float* times, unsigned int num_samples, unsigned int new_num_samples)
+{
+    Key key { new_num_samples, std::vector<float>(times, times + num_samples) };
+    auto it = m_samplings.find(key);
+    if (it != m_samplings.end()) {
+        return it->second;
+    }
+
+    HdCyclesTimeSampling& sampling = m_samplings[std::move(key)];
+
+    // Overlaps are removed from sample indices, values are picked by the sources
+    HdTimeSampleArray<ccl::uint, HD_CYCLES_MAX_TRANSFORM_STEPS> indexed;
+    indexed.Resize(num_samples);
+    for (unsigned int i = 0; i < num_samples; ++i) {
+        indexed.times[i] = times[i];
+        indexed.values[i] = i;
+    }
+    indexed = HdCyclesTimeSamplesRemoveOverlaps(indexed);
+
+    const auto num_unique = static_cast<unsigned int>(indexed.count);
+    sampling.indices.assign(indexed.values.begin(), indexed.values.end());
+    if (num_unique <= 1) {
+        return sampling;
+    }
+
+    sampling.centered = HdCyclesIsShutterCentered(indexed.times.data(), num_unique);
+    if (!sampling.centered) {
+        return sampling;
+    }
+
+    // Same rules as for a single source, samples are copied as they are if no resampling is needed
+    const unsigned int num_req_samples = new_num_samples > 0 ? new_num_samples : num_unique;
+    if (num_req_samples != num_unique || !HdCyclesAreTimeSamplesUniformlyDistributed(indexed)) {
+        sampling.weights = HdCyclesTransformSource::ComputeResampleWeights(indexed.times.data(), num_unique,
+                                                                           num_req_samples);
+    } else {
+        sampling.weights.Resize(num_unique);
+        for (unsigned int i = 0; i < num_unique; ++i) {
+            sampling.weights.times[i] = indexed.times[i];
+            sampling.weights.values[i] = { i, i, 0.0f };
+        }
+    }
+
+    return sampling;
+}
+
 HdCyclesTransformSource::HdCyclesTransformSource(ccl::Object* object, const HdCyclesMatrix4dTimeSampleArray& samples,
                                                  const GfMatrix4d& fallback, unsigned int new_num_samples)
     : m_object { object }
@@ -150,83 +213,143 @@ HdCyclesTransformSource::_CheckValid() const
     return m_samples.count < HD_CYCLES_MAX_TRANSFORM_STEPS;
 }
 
-HdCyclesTransformTimeSampleArray
-HdCyclesTransformSource::ResampleUniform(const HdCyclesMatrix4dTimeSampleArray& samples, unsigned int new_num_samples)
+HdCyclesResampleWeightArray
+HdCyclesTransformSource::ComputeResampleWeights(const float* times, unsigned int num_samples,
+                                                unsigned int new_num_samples)
 {
     if (new_num_samples % 2 == 0)
         new_num_samples += 1;
 
-    HdCyclesTransformTimeSampleArray resampled;
-    resampled.Resize(new_num_samples);
-
-    const auto num_samples = static_cast<unsigned int>(samples.count);
+    HdCyclesResampleWeightArray weights;
+    weights.Resize(new_num_samples);
 
     // sample - point in time, segment - width between two samples
     // 3 samples = 2 segments => num_segments = num_samples - 1
-    const float shutter_time = samples.times[num_samples - 1] - samples.times[0];
+    const float shutter_time = times[num_samples - 1] - times[0];
     const unsigned int new_num_segments = new_num_samples > 1 ? new_num_samples - 1 : 1;
     const float new_segment_width = shutter_time / static_cast<float>(new_num_segments);
 
     //
     unsigned int sample = 1;
     for (unsigned int i = 0; i < new_num_samples; ++i) {
-        const float time = samples.times.front() + static_cast<float>(i) * new_segment_width;
+        const float time = times[0] + static_cast<float>(i) * new_segment_width;
 
         // Search for segment: [sample - 1, sample]
-        for (; sample < samples.count;) {
-            if (time >= samples.times[sample - 1] && time <= samples.times[sample]) {
+        for (; sample < num_samples;) {
+            if (time >= times[sample - 1] && time <= times[sample]) {
                 break;
             }
             ++sample;
         }
 
-        resampled.times[i] = time;
+        weights.times[i] = time;
 
         const unsigned int iXfPrev = sample - 1;
-        const unsigned int iXfNext = sample;
+        const unsigned int iXfNext = std::min(sample, num_samples - 1);
 
         // boundary conditions and any other overlapping sample
-        if (std::abs(time - samples.times[iXfPrev]) <= HdCyclesIndexedTimeSample::epsilon) {
-            resampled.values[i] = mat4d_to_transform(samples.values[iXfPrev]);
+        if (std::abs(time - times[iXfPrev]) <= HdCyclesIndexedTimeSample::epsilon) {
+            weights.values[i] = { iXfPrev, iXfPrev, 0.0f };
             continue;
         }
 
-        if (std::abs(time - samples.times[iXfNext]) <= HdCyclesIndexedTimeSample::epsilon) {
-            resampled.values[i] = mat4d_to_transform(samples.values[iXfNext]);
+        if (std::abs(time - times[iXfNext]) <= HdCyclesIndexedTimeSample::epsilon) {
+            weights.values[i] = { iXfNext, iXfNext, 0.0f };
             continue;
         }
 
-        // in-between samples compute u coordinate
-        ccl::Transform xfPrev = mat4d_to_transform(samples.values[iXfPrev]);
-        ccl::Transform xfNext = mat4d_to_transform(samples.values[iXfNext]);
+        // Weighting by distance to sample
+        const float timeDiff = times[iXfNext] - times[iXfPrev];
+        const float t = (time - times[iXfPrev]) / timeDiff;
+        assert(t >= 0.0f && t <= 1.0f);
+
+        weights.values[i] = { iXfPrev, iXfNext, t };
+    }
+
+    return weights;
+}
+
+void
+HdCyclesTransformSource::ResampleUniform(const HdCyclesResampleWeightArray& weights,
+                                         const ccl::Transform* transforms, size_t count, ccl::Transform* resampled)
+{
+    if (weights.count == 0 || count == 0) {
+        return;
+    }
+
+    // Input samples referenced by an interpolated weight are decomposed once per batch of objects
+    unsigned int num_samples = 0;
+    bool interpolate = false;
+    for (unsigned int i = 0; i < weights.count; ++i) {
+        num_samples = std::max(num_samples, weights.values[i].next + 1);
+        interpolate |= weights.values[i].prev != weights.values[i].next;
+    }
+
+    constexpr size_t grain_size = 256;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, count, grain_size), [&](const tbb::blocked_range<size_t>& r) {
+        const size_t begin = r.begin();
+        const size_t batch = r.size();
+
+        std::vector<ccl::DecomposedTransform> decomposed;
+        if (interpolate) {
+            decomposed.resize(num_samples * batch);
+            for (unsigned int sample = 0; sample < num_samples; ++sample) {
+                transform_motion_decompose(decomposed.data() + sample * batch, transforms + sample * count + begin,
+                                           batch);
+            }
+        }
+
+        for (unsigned int i = 0; i < weights.count; ++i) {
+            const HdCyclesResampleWeight& weight = weights.values[i];
+            ccl::Transform* dst = resampled + i * count + begin;
+
+            // Matching an input sample, copied as it is
+            if (weight.prev == weight.next) {
+                std::copy_n(transforms + weight.prev * count + begin, batch, dst);
+                continue;
+            }
+
+            const ccl::DecomposedTransform* prev = decomposed.data() + weight.prev * batch;
+            const ccl::DecomposedTransform* next = decomposed.data() + weight.next * batch;
+            for (size_t j = 0; j < batch; ++j) {
+                ccl::DecomposedTransform dxf[2] = { prev[j], next[j] };
 
-        ccl::DecomposedTransform dxf[2];
-        transform_motion_decompose(dxf + 0, &xfPrev, 1);
-        transform_motion_decompose(dxf + 1, &xfNext, 1);
+                // Preferring the smaller rotation difference
+                if (ccl::len_squared(dxf[0].x - dxf[1].x) > ccl::len_squared(dxf[0].x + dxf[1].x)) {
+                    dxf[1].x = -dxf[1].x;
+                }
 
-        // Preferring the smaller rotation difference
-        if (ccl::len_squared(dxf[0].x - dxf[1].x) > ccl::len_squared(dxf[0].x + dxf[1].x)) {
-            dxf[1].x = -dxf[1].x;
+                transform_motion_array_interpolate(dst + j, dxf, 2, weight.t);
+            }
         }
+    });
+}
 
-        // Weighting by distance to sample
-        const float timeDiff = samples.times[iXfNext] - samples.times[iXfPrev];
-        const float t = (resampled.times[i] - samples.times[iXfPrev]) / timeDiff;
-        assert(t >= 0.0f && t <= 1.0f);
+HdCyclesTransformTimeSampleArray
+HdCyclesTransformSource::ResampleUniform(const HdCyclesMatrix4dTimeSampleArray& samples, unsigned int new_num_samples)
+{
+    const auto num_samples = static_cast<unsigned int>(samples.count);
+    const HdCyclesResampleWeightArray weights = ComputeResampleWeights(samples.times.data(), num_samples,
+                                                                       new_num_samples);
 
-        transform_motion_array_interpolate(&resampled.values[i], dxf, 2, t);
+    HdCyclesTransformSmallVector transforms(num_samples);
+    for (unsigned int i = 0; i < num_samples; ++i) {
+        transforms[i] = mat4d_to_transform(samples.values[i]);
     }
 
+    HdCyclesTransformTimeSampleArray resampled;
+    resampled.Resize(static_cast<unsigned int>(weights.count));
+    for (unsigned int i = 0; i < weights.count; ++i) {
+        resampled.times[i] = weights.times[i];
+    }
+
+    ResampleUniform(weights, transforms.data(), 1, resampled.values.data());
     return resampled;
 }
 
 bool
-HdCyclesTransformSource::Resolve()
+HdCyclesTransformSource::_ResolveWithoutMotion()
 {
-    if (!_TryLock()) {
-        return false;
-    }
-
     ccl::Object* object = m_object;
 
     // Hd outputs duplicated time samples, remove all duplicates and keep time samples in ascending order
@@ -254,9 +377,7 @@ HdCyclesTransformSource::Resolve()
     }
 
     // Frame centered motion blur only, with fallback to default value
-    const float shutter_open = m_samples.times[0];
-    const float shutter_close = m_samples.times[static_cast<unsigned int>(m_samples.count) - 1];
-    if (std::abs(std::abs(shutter_close) - std::abs(shutter_open)) > HdCyclesIndexedTimeSample::epsilon) {
+    if (!HdCyclesIsShutterCentered(m_samples.times.data(), static_cast<unsigned int>(m_samples.count))) {
         object->motion.resize(0);
         object->tfm = mat4d_to_transform(m_fallback);
 
@@ -265,23 +386,90 @@ HdCyclesTransformSource::Resolve()
         return true;
     }
 
+    return false;
+}
+
+bool
+HdCyclesTransformSource::_ResolveStatic()
+{
+    for (unsigned int i = 1; i < m_samples.count; ++i) {
+        if (m_samples.values[i] != m_samples.values[0]) {
+            return false;
+        }
+    }
+
+    ccl::Object* object = m_object;
+    object->motion.resize(0);
+    object->tfm = mat4d_to_transform(m_samples.count ? m_samples.values[0] : m_fallback);
+
+    // Marked as finished
+    _SetResolved();
+    return true;
+}
+
+unsigned int
+HdCyclesTransformSource::_GetNumRequestedSamples() const
+{
+    return m_new_num_samples > 0 ? m_new_num_samples : static_cast<unsigned int>(m_samples.count);
+}
+
+bool
+HdCyclesTransformSource::_RequiresResampling() const
+{
     // Resample motion samples if necessary:
     // * resample if number of samples is even
     // * resample if samples are not distributed evenly
     // * otherwise copy as they are
     //
-    auto num_inp_samples = static_cast<unsigned int>(m_samples.count);
-    auto num_req_samples = m_new_num_samples > 0 ? m_new_num_samples : num_inp_samples;
+    return static_cast<unsigned int>(m_samples.count) != _GetNumRequestedSamples()
+           || !HdCyclesAreTimeSamplesUniformlyDistributed(m_samples);
+}
+
+bool
+HdCyclesTransformSource::_LessSampling(const HdCyclesTransformSource* lhs, const HdCyclesTransformSource* rhs)
+{
+    if (lhs->m_samples.count != rhs->m_samples.count) {
+        return lhs->m_samples.count < rhs->m_samples.count;
+    }
+    if (lhs->m_new_num_samples != rhs->m_new_num_samples) {
+        return lhs->m_new_num_samples < rhs->m_new_num_samples;
+    }
+    return std::lexicographical_compare(lhs->m_samples.times.begin(), lhs->m_samples.times.end(),
+                                        rhs->m_samples.times.begin(), rhs->m_samples.times.end());
+}
+
+bool
+HdCyclesTransformSource::_SameSampling(const HdCyclesTransformSource* lhs, const HdCyclesTransformSource* rhs)
+{
+    return !_LessSampling(lhs, rhs) && !_LessSampling(rhs, lhs);
+}
+
+void
+HdCyclesTransformSource::_CommitMotion(const ccl::Transform* motion, size_t stride, unsigned int num_steps)
+{
+    ccl::Object* object = m_object;
+    object->tfm = ccl::transform_identity();
+    object->motion.resize(num_steps);
+    for (unsigned int i {}; i < num_steps; ++i) {
+        object->motion[i] = motion[i * stride];
+    }
+}
+
+bool
+HdCyclesTransformSource::Resolve()
+{
+    if (!_TryLock()) {
+        return false;
+    }
 
-    // Check if resampling is required
-    bool requires_resampling = false;
-    if (num_inp_samples != num_req_samples || !HdCyclesAreTimeSamplesUniformlyDistributed(m_samples)) {
-        requires_resampling = true;
+    if (_ResolveWithoutMotion()) {
+        return true;
     }
 
     // Resampling
+    auto num_req_samples = _GetNumRequestedSamples();
     HdCyclesTransformTimeSampleArray motion_transforms;
-    if (requires_resampling) {
+    if (_RequiresResampling()) {
         motion_transforms = ResampleUniform(m_samples, num_req_samples);
     } else {
         motion_transforms.Resize(num_req_samples);
@@ -291,13 +479,117 @@ HdCyclesTransformSource::Resolve()
     }
 
     // Commit samples
-    object->tfm = ccl::transform_identity();
-    object->motion.resize(motion_transforms.count);
-    for (unsigned int i {}; i < motion_transforms.count; ++i) {
-        object->motion[i] = motion_transforms.values[i];
-    }
+    _CommitMotion(motion_transforms.values.data(), 1, static_cast<unsigned int>(motion_transforms.count));
 
     // Marked as finished
     _SetResolved();
     return true;
 }
+
+size_t
+HdCyclesTransformSource::ResolveBatch(const std::vector<HdCyclesTransformSource*>& sources,
+                                      HdCyclesTimeSamplingCache* cache)
+{
+    HdCyclesTimeSamplingCache local_cache;
+    if (!cache) {
+        cache = &local_cache;
+    }
+
+    // Static sources are resolved right away, the rest is grouped by input sample times
+    std::vector<HdCyclesTransformSource*> pending(sources.size(), nullptr);
+    std::atomic<size_t> num_resolved { 0 };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, sources.size(), 64), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t i = r.begin(); i < r.end(); ++i) {
+            HdCyclesTransformSource* source = sources[i];
+            if (!source->IsValid() || source->IsResolved() || !source->_TryLock()) {
+                continue;
+            }
+            ++num_resolved;
+            if (!source->_ResolveStatic()) {
+                pending[i] = source;
+            }
+        }
+    });
+
+    pending.erase(std::remove(pending.begin(), pending.end(), nullptr), pending.end());
+    std::sort(pending.begin(), pending.end(), _LessSampling);
+
+    std::vector<HdCyclesTransformSource*> moving;
+    std::vector<ccl::Transform> transforms;
+    std::vector<ccl::Transform> motion;
+    for (auto begin = pending.begin(); begin != pending.end();) {
+        auto end = std::find_if_not(begin + 1, pending.end(), [begin](const HdCyclesTransformSource* source) {
+            return _SameSampling(*begin, source);
+        });
+
+        HdCyclesTransformSource** group = &*begin;
+        const auto group_size = static_cast<size_t>(end - begin);
+        begin = end;
+
+        const HdCyclesTimeSampling& sampling = cache->Get(group[0]->m_samples.times.data(),
+                                                          static_cast<unsigned int>(group[0]->m_samples.count),
+                                                          group[0]->m_new_num_samples);
+        const auto num_samples = static_cast<unsigned int>(sampling.indices.size());
+
+        // Samples might still be the same once overlaps are removed
+        std::vector<uint8_t> is_moving(group_size, 0);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, group_size, 256), [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); ++i) {
+                HdCyclesTransformSource* source = group[i];
+                const GfMatrix4d& first = source->m_samples.values[sampling.indices[0]];
+
+                bool no_motion = true;
+                for (unsigned int j = 1; j < num_samples && no_motion; ++j) {
+                    no_motion = source->m_samples.values[sampling.indices[j]] == first;
+                }
+
+                ccl::Object* object = source->m_object;
+                if (no_motion) {
+                    object->motion.resize(0);
+                    object->tfm = mat4d_to_transform(first);
+                    source->_SetResolved();
+                } else if (!sampling.centered) {
+                    object->motion.resize(0);
+                    object->tfm = mat4d_to_transform(source->m_fallback);
+                    source->_SetResolveError();
+                } else {
+                    is_moving[i] = 1;
+                }
+            }
+        });
+
+        moving.clear();
+        for (size_t i = 0; i < group_size; ++i) {
+            if (is_moving[i]) {
+                moving.push_back(group[i]);
+            }
+        }
+        if (moving.empty()) {
+            continue;
+        }
+
+        // Sample major, so that resampling reads one row per unique input sample
+        const size_t count = moving.size();
+        transforms.resize(num_samples * count);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, count, 256), [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); ++i) {
+                for (unsigned int j = 0; j < num_samples; ++j) {
+                    transforms[j * count + i] = mat4d_to_transform(moving[i]->m_samples.values[sampling.indices[j]]);
+                }
+            }
+        });
+
+        const auto num_steps = static_cast<unsigned int>(sampling.weights.count);
+        motion.resize(num_steps * count);
+        ResampleUniform(sampling.weights, transforms.data(), count, motion.data());
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, count, 256), [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); ++i) {
+                moving[i]->_CommitMotion(motion.data() + i, count, num_steps);
+                moving[i]->_SetResolved();
+            }
+        });
+    }
+
+    return num_resolved;
+}
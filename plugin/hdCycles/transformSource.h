@@ -28,8 +28,11 @@
 #include <render/geometry.h>
 #include <render/object.h>
 
+#include <map>
 #include <numeric>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -50,6 +53,47 @@ using HdCyclesTransformTimeSampleArray = HdTimeSampleArray<ccl::Transform, HD_CY
 
 using HdCyclesTransformSmallVector = TfSmallVector<ccl::Transform, HD_CYCLES_MAX_TRANSFORM_STEPS>;
 
+///
+/// Uniform resampling weight, the resampled transform interpolates between the prev and next input samples.
+/// Prev and next are the same if the resampled time matches an input sample
+///
+struct HdCyclesResampleWeight {
+    ccl::uint prev;
+    ccl::uint next;
+    float t;
+};
+
+using HdCyclesResampleWeightArray = HdTimeSampleArray<HdCyclesResampleWeight, HD_CYCLES_MAX_TRANSFORM_STEPS>;
+
+///
+/// Sample times with overlaps removed and the resampling weights derived from them
+///
+struct HdCyclesTimeSampling {
+    /// Input sample of each unique time, in ascending time order
+    TfSmallVector<ccl::uint, HD_CYCLES_MAX_TRANSFORM_STEPS> indices;
+    /// Only frame centered shutter is supported
+    bool centered = false;
+    /// Weights of the committed motion steps, indexing unique samples
+    HdCyclesResampleWeightArray weights;
+};
+
+///
+/// Interned time samplings, nearly all sources in a scene share the same shutter sample times
+///
+class HdCyclesTimeSamplingCache {
+public:
+    /// Get sampling for the input times and requested number of samples, computed on first use.
+    /// Not thread safe, reference is valid until Clear
+    const HdCyclesTimeSampling& Get(const float* times, unsigned int num_samples, unsigned int new_num_samples);
+
+    size_t GetSize() const { return m_samplings.size(); }
+    void Clear() { m_samplings.clear(); }
+
+private:
+    using Key = std::pair<unsigned int, std::vector<float>>;
+    std::map<Key, HdCyclesTimeSampling> m_samplings;
+};
+
 ///
 /// Common abstract base for all properties to be committed to the object
 ///
@@ -80,9 +124,40 @@ public:
     static HdCyclesTransformTimeSampleArray ResampleUniform(const HdCyclesMatrix4dTimeSampleArray& samples,
                                                             unsigned int new_num_samples);
 
+    /// Weights of a uniform resampling of sorted sample times, independent of the transforms
+    static HdCyclesResampleWeightArray ComputeResampleWeights(const float* times, unsigned int num_samples,
+                                                              unsigned int new_num_samples);
+
+    /// Resample transforms of many objects sampled at the same times,
+    /// input is laid out as transforms[sample * count + object] and output as resampled[new_sample * count + object]
+    static void ResampleUniform(const HdCyclesResampleWeightArray& weights, const ccl::Transform* transforms,
+                                size_t count, ccl::Transform* resampled);
+
+    /// Resolve many sources at once, sources sharing the same sample times are resampled in one batch.
+    /// Samplings are taken from the cache if given, otherwise they are computed once per call
+    /// Returns number of resolved sources
+    static size_t ResolveBatch(const std::vector<HdCyclesTransformSource*>& sources,
+                               HdCyclesTimeSamplingCache* cache = nullptr);
+
 private:
     bool _CheckValid() const override;
 
+    /// Resolve sources without motion or with an unsupported shutter, false if the motion has to be committed
+    bool _ResolveWithoutMotion();
+
+    /// Resolve sources whose samples are all the same, motion is not committed for them
+    bool _ResolveStatic();
+
+    unsigned int _GetNumRequestedSamples() const;
+    bool _RequiresResampling() const;
+
+    /// Sources are batched if their input sample times and requested samples are the same
+    static bool _LessSampling(const HdCyclesTransformSource* lhs, const HdCyclesTransformSource* rhs);
+    static bool _SameSampling(const HdCyclesTransformSource* lhs, const HdCyclesTransformSource* rhs);
+
+    /// Commit motion transforms laid out as motion[step * stride]
+    void _CommitMotion(const ccl::Transform* motion, size_t stride, unsigned int num_steps);
+
     ccl::Object* m_object;
     HdCyclesMatrix4dTimeSampleArray m_samples;
     GfMatrix4d m_fallback;
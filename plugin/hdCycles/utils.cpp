@@ -26,12 +26,19 @@
 #include <subd/subd_dice.h>
 #include <subd/subd_split.h>
 #include <util/util_path.h>
+#include <util/util_system.h>
 #include <util/util_transform.h>
 
 #include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/vt/array.h>
 #include <pxr/imaging/hd/extComputationUtils.h>
+#include <pxr/imaging/hd/types.h>
 #include <pxr/usd/sdf/assetPath.h>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#    include <immintrin.h>
+#endif
+
 #ifdef USE_HBOOST
 #    include <hboost/filesystem.hpp>
 #else
@@ -651,102 +658,405 @@ HdCyclesIsPrimvarExists(TfToken const& a_name, HdCyclesPDPIMap const& a_primvarD
     return false;
 }
 
-template<>
-inline float
-to_cycles<float>(const float& v) noexcept
+/* ========= Array conversion ========= */
+
+namespace {
+
+// Cycles float3 is padded to 4 floats on the cpu, kernels below store full 4 float elements
+static_assert(sizeof(ccl::float3) == 4 * sizeof(float), "Unexpected Cycles float3 layout");
+
+#if defined(__x86_64__) || defined(_M_X64)
+#    define HD_CYCLES_ARRAY_SIMD
+#    if defined(__GNUC__) || defined(__clang__)
+#        define HD_CYCLES_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#    else
+#        define HD_CYCLES_TARGET_AVX2
+#    endif
+#endif
+
+void
+vec3f_to_float3_scalar(const GfVec3f* a_src, ccl::float3* a_dst, size_t a_count)
 {
-    return v;
+    for (size_t i = 0; i < a_count; ++i) {
+        a_dst[i] = vec3f_to_float3(a_src[i]);
+    }
 }
-template<>
-inline float
-to_cycles<double>(const double& v) noexcept
+
+void
+vec4f_to_float3_scalar(const GfVec4f* a_src, ccl::float3* a_dst, size_t a_count)
 {
-    return static_cast<float>(v);
+    for (size_t i = 0; i < a_count; ++i) {
+        a_dst[i] = vec4f_to_float3(a_src[i]);
+    }
 }
-template<>
-inline float
-to_cycles<int>(const int& v) noexcept
+
+void
+half_to_float_scalar(const GfHalf* a_src, float* a_dst, size_t a_count)
 {
-    return static_cast<float>(v);
+    for (size_t i = 0; i < a_count; ++i) {
+        a_dst[i] = static_cast<float>(a_src[i]);
+    }
 }
 
+void
+double_to_float_scalar(const double* a_src, float* a_dst, size_t a_count)
+{
+    for (size_t i = 0; i < a_count; ++i) {
+        a_dst[i] = static_cast<float>(a_src[i]);
+    }
+}
 
-template<>
-inline ccl::float2
-to_cycles<GfVec2f>(const GfVec2f& v) noexcept
+void
+float_to_half_scalar(const float* a_src, GfHalf* a_dst, size_t a_count)
 {
-    return ccl::make_float2(v[0], v[1]);
+    for (size_t i = 0; i < a_count; ++i) {
+        a_dst[i] = GfHalf(a_src[i]);
+    }
 }
-template<>
-inline ccl::float2
-to_cycles<GfVec2h>(const GfVec2h& v) noexcept
+
+void
+float_to_unorm8_scalar(const float* a_src, uint8_t* a_dst, size_t a_count)
 {
-    return ccl::make_float2(static_cast<float>(v[0]), static_cast<float>(v[1]));
+    for (size_t i = 0; i < a_count; ++i) {
+        // NaN is mapped to 0, same as the simd kernels
+        float value = a_src[i] > 0.0f ? a_src[i] : 0.0f;
+        value = value < 1.0f ? value : 1.0f;
+        a_dst[i] = static_cast<uint8_t>(value * 255.0f);
+    }
 }
-template<>
-inline ccl::float2
-to_cycles<GfVec2d>(const GfVec2d& v) noexcept
+
+void
+offset_int32_scalar(int32_t* a_data, int32_t a_offset, size_t a_count)
 {
-    return ccl::make_float2(static_cast<float>(v[0]), static_cast<float>(v[1]));
+    for (size_t i = 0; i < a_count; ++i) {
+        a_data[i] += a_offset;
+    }
 }
-template<>
-inline ccl::float2
-to_cycles<GfVec2i>(const GfVec2i& v) noexcept
+
+#ifdef HD_CYCLES_ARRAY_SIMD
+
+void
+vec3f_to_float3_sse(const GfVec3f* a_src, ccl::float3* a_dst, size_t a_count)
 {
-    return ccl::make_float2(static_cast<float>(v[0]), static_cast<float>(v[1]));
+    const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    auto src = reinterpret_cast<const float*>(a_src);
+    auto dst = reinterpret_cast<float*>(a_dst);
+
+    // unaligned load reads one float past the element, the last element is converted separately
+    size_t i = 0;
+    for (; i + 1 < a_count; ++i) {
+        _mm_storeu_ps(dst + 4 * i, _mm_and_ps(_mm_loadu_ps(src + 3 * i), mask));
+    }
+    vec3f_to_float3_scalar(a_src + i, a_dst + i, a_count - i);
 }
 
-template<>
-inline ccl::float3
-to_cycles<GfVec3f>(const GfVec3f& v) noexcept
+void
+vec4f_to_float3_sse(const GfVec4f* a_src, ccl::float3* a_dst, size_t a_count)
 {
-    return ccl::make_float3(v[0], v[1], v[2]);
+    const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    auto src = reinterpret_cast<const float*>(a_src);
+    auto dst = reinterpret_cast<float*>(a_dst);
+
+    for (size_t i = 0; i < a_count; ++i) {
+        _mm_storeu_ps(dst + 4 * i, _mm_and_ps(_mm_loadu_ps(src + 4 * i), mask));
+    }
 }
-template<>
-inline ccl::float3
-to_cycles<GfVec3h>(const GfVec3h& v) noexcept
+
+void
+double_to_float_sse(const double* a_src, float* a_dst, size_t a_count)
 {
-    return ccl::make_float3(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]));
+    size_t i = 0;
+    for (; i + 4 <= a_count; i += 4) {
+        const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(a_src + i));
+        const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(a_src + i + 2));
+        _mm_storeu_ps(a_dst + i, _mm_movelh_ps(lo, hi));
+    }
+    double_to_float_scalar(a_src + i, a_dst + i, a_count - i);
 }
-template<>
-inline ccl::float3
-to_cycles<GfVec3d>(const GfVec3d& v) noexcept
+
+void
+float_to_unorm8_sse(const float* a_src, uint8_t* a_dst, size_t a_count)
 {
-    return ccl::make_float3(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+
+    // max before min maps NaN to 0
+    auto convert = [&](const float* src) -> __m128i {
+        const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), zero), one);
+        return _mm_cvttps_epi32(_mm_mul_ps(value, scale));
+    };
+
+    size_t i = 0;
+    for (; i + 16 <= a_count; i += 16) {
+        const __m128i lo = _mm_packs_epi32(convert(a_src + i), convert(a_src + i + 4));
+        const __m128i hi = _mm_packs_epi32(convert(a_src + i + 8), convert(a_src + i + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a_dst + i), _mm_packus_epi16(lo, hi));
+    }
+    float_to_unorm8_scalar(a_src + i, a_dst + i, a_count - i);
 }
-template<>
-inline ccl::float3
-to_cycles<GfVec3i>(const GfVec3i& v) noexcept
+
+void
+offset_int32_sse(int32_t* a_data, int32_t a_offset, size_t a_count)
 {
-    return ccl::make_float3(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]));
+    const __m128i offset = _mm_set1_epi32(a_offset);
+    auto data = reinterpret_cast<__m128i*>(a_data);
+
+    size_t i = 0;
+    for (; i + 8 <= a_count; i += 8) {
+        const __m128i lo = _mm_loadu_si128(data + i / 4);
+        const __m128i hi = _mm_loadu_si128(data + i / 4 + 1);
+        _mm_storeu_si128(data + i / 4, _mm_add_epi32(lo, offset));
+        _mm_storeu_si128(data + i / 4 + 1, _mm_add_epi32(hi, offset));
+    }
+    offset_int32_scalar(a_data + i, a_offset, a_count - i);
 }
 
-template<>
-inline ccl::float4
-to_cycles<GfVec4f>(const GfVec4f& v) noexcept
+HD_CYCLES_TARGET_AVX2 void
+vec3f_to_float3_avx2(const GfVec3f* a_src, ccl::float3* a_dst, size_t a_count)
 {
-    return ccl::make_float4(v[0], v[1], v[2], v[3]);
+    // two elements per iteration: xyz xyz -> xyz0 xyz0
+    const __m256i permute = _mm256_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5);
+    const __m256 mask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+    auto src = reinterpret_cast<const float*>(a_src);
+    auto dst = reinterpret_cast<float*>(a_dst);
+
+    // 8 float load reads two floats past the pair, the last elements are converted separately
+    size_t i = 0;
+    for (; i + 3 <= a_count; i += 2) {
+        const __m256 xyz = _mm256_permutevar8x32_ps(_mm256_loadu_ps(src + 3 * i), permute);
+        _mm256_storeu_ps(dst + 4 * i, _mm256_and_ps(xyz, mask));
+    }
+    vec3f_to_float3_sse(a_src + i, a_dst + i, a_count - i);
 }
-template<>
-inline ccl::float4
-to_cycles<GfVec4h>(const GfVec4h& v) noexcept
+
+HD_CYCLES_TARGET_AVX2 void
+vec4f_to_float3_avx2(const GfVec4f* a_src, ccl::float3* a_dst, size_t a_count)
 {
-    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]),
-                            static_cast<float>(v[3]));
+    const __m256 mask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+    auto src = reinterpret_cast<const float*>(a_src);
+    auto dst = reinterpret_cast<float*>(a_dst);
+
+    size_t i = 0;
+    for (; i + 2 <= a_count; i += 2) {
+        _mm256_storeu_ps(dst + 4 * i, _mm256_and_ps(_mm256_loadu_ps(src + 4 * i), mask));
+    }
+    vec4f_to_float3_sse(a_src + i, a_dst + i, a_count - i);
 }
-template<>
-inline ccl::float4
-to_cycles<GfVec4d>(const GfVec4d& v) noexcept
+
+HD_CYCLES_TARGET_AVX2 void
+half_to_float_avx2(const GfHalf* a_src, float* a_dst, size_t a_count)
+{
+    auto src = reinterpret_cast<const uint16_t*>(a_src);
+
+    size_t i = 0;
+    for (; i + 8 <= a_count; i += 8) {
+        const __m128i halfs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(a_dst + i, _mm256_cvtph_ps(halfs));
+    }
+    half_to_float_scalar(a_src + i, a_dst + i, a_count - i);
+}
+
+HD_CYCLES_TARGET_AVX2 void
+double_to_float_avx2(const double* a_src, float* a_dst, size_t a_count)
 {
-    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]),
-                            static_cast<float>(v[3]));
+    size_t i = 0;
+    for (; i + 8 <= a_count; i += 8) {
+        const __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(a_src + i));
+        const __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(a_src + i + 4));
+        _mm256_storeu_ps(a_dst + i, _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1));
+    }
+    double_to_float_sse(a_src + i, a_dst + i, a_count - i);
 }
-template<>
-inline ccl::float4
-to_cycles<GfVec4i>(const GfVec4i& v) noexcept
+
+HD_CYCLES_TARGET_AVX2 void
+float_to_half_avx2(const float* a_src, GfHalf* a_dst, size_t a_count)
+{
+    auto dst = reinterpret_cast<uint16_t*>(a_dst);
+
+    size_t i = 0;
+    for (; i + 8 <= a_count; i += 8) {
+        const __m128i halfs = _mm256_cvtps_ph(_mm256_loadu_ps(a_src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), halfs);
+    }
+    float_to_half_scalar(a_src + i, a_dst + i, a_count - i);
+}
+
+HD_CYCLES_TARGET_AVX2 void
+offset_int32_avx2(int32_t* a_data, int32_t a_offset, size_t a_count)
+{
+    const __m256i offset = _mm256_set1_epi32(a_offset);
+    auto data = reinterpret_cast<__m256i*>(a_data);
+
+    size_t i = 0;
+    for (; i + 8 <= a_count; i += 8) {
+        _mm256_storeu_si256(data + i / 8, _mm256_add_epi32(_mm256_loadu_si256(data + i / 8), offset));
+    }
+    offset_int32_scalar(a_data + i, a_offset, a_count - i);
+}
+
+#endif  // HD_CYCLES_ARRAY_SIMD
+
+///
+/// Conversion kernels resolved once for the running cpu
+///
+struct HdCyclesArrayConversions {
+    HdCyclesArrayConversions()
+    {
+        if (!Select(HdCyclesArrayConversionIsa::AVX2) && !Select(HdCyclesArrayConversionIsa::SSE)) {
+            Select(HdCyclesArrayConversionIsa::Scalar);
+        }
+    }
+
+    static HdCyclesArrayConversions& Get()
+    {
+        static HdCyclesArrayConversions conversions;
+        return conversions;
+    }
+
+    static bool IsSupported(HdCyclesArrayConversionIsa a_isa)
+    {
+#ifdef HD_CYCLES_ARRAY_SIMD
+        return a_isa != HdCyclesArrayConversionIsa::AVX2 || ccl::system_cpu_support_avx2();
+#else
+        return a_isa == HdCyclesArrayConversionIsa::Scalar;
+#endif
+    }
+
+    bool Select(HdCyclesArrayConversionIsa a_isa)
+    {
+        if (!IsSupported(a_isa)) {
+            return false;
+        }
+
+        vec3f_to_float3 = &vec3f_to_float3_scalar;
+        vec4f_to_float3 = &vec4f_to_float3_scalar;
+        half_to_float = &half_to_float_scalar;
+        double_to_float = &double_to_float_scalar;
+        float_to_half = &float_to_half_scalar;
+        float_to_unorm8 = &float_to_unorm8_scalar;
+        offset_int32 = &offset_int32_scalar;
+
+#ifdef HD_CYCLES_ARRAY_SIMD
+        if (a_isa != HdCyclesArrayConversionIsa::Scalar) {
+            vec3f_to_float3 = &vec3f_to_float3_sse;
+            vec4f_to_float3 = &vec4f_to_float3_sse;
+            double_to_float = &double_to_float_sse;
+            float_to_unorm8 = &float_to_unorm8_sse;
+            offset_int32 = &offset_int32_sse;
+        }
+
+        if (a_isa == HdCyclesArrayConversionIsa::AVX2) {
+            vec3f_to_float3 = &vec3f_to_float3_avx2;
+            vec4f_to_float3 = &vec4f_to_float3_avx2;
+            half_to_float = &half_to_float_avx2;
+            double_to_float = &double_to_float_avx2;
+            float_to_half = &float_to_half_avx2;
+            offset_int32 = &offset_int32_avx2;
+        }
+#endif
+
+        isa = a_isa;
+        return true;
+    }
+
+    HdCyclesArrayConversionIsa isa = HdCyclesArrayConversionIsa::Scalar;
+    void (*vec3f_to_float3)(const GfVec3f*, ccl::float3*, size_t) = &vec3f_to_float3_scalar;
+    void (*vec4f_to_float3)(const GfVec4f*, ccl::float3*, size_t) = &vec4f_to_float3_scalar;
+    void (*half_to_float)(const GfHalf*, float*, size_t) = &half_to_float_scalar;
+    void (*double_to_float)(const double*, float*, size_t) = &double_to_float_scalar;
+    void (*float_to_half)(const float*, GfHalf*, size_t) = &float_to_half_scalar;
+    void (*float_to_unorm8)(const float*, uint8_t*, size_t) = &float_to_unorm8_scalar;
+    void (*offset_int32)(int32_t*, int32_t, size_t) = &offset_int32_scalar;
+};
+
+// Components of the source array are converted as one flat array
+template<typename Dst, typename Src>
+VtValue
+components_to_float_array(const VtValue& a_value, void (*a_convert)(const Src*, float*, size_t))
+{
+    static_assert(sizeof(Dst) % sizeof(float) == 0, "Destination must be made of floats");
+
+    VtArray<Dst> dst(a_value.GetArraySize());
+    a_convert(static_cast<const Src*>(HdGetValueData(a_value)), reinterpret_cast<float*>(dst.data()),
+              dst.size() * (sizeof(Dst) / sizeof(float)));
+    return VtValue { dst };
+}
+
+}  // namespace
+
+void
+vec3f_to_float3(const GfVec3f* a_src, ccl::float3* a_dst, size_t a_count)
+{
+    HdCyclesArrayConversions::Get().vec3f_to_float3(a_src, a_dst, a_count);
+}
+
+void
+vec4f_to_float3(const GfVec4f* a_src, ccl::float3* a_dst, size_t a_count)
+{
+    HdCyclesArrayConversions::Get().vec4f_to_float3(a_src, a_dst, a_count);
+}
+
+void
+half_to_float(const GfHalf* a_src, float* a_dst, size_t a_count)
+{
+    HdCyclesArrayConversions::Get().half_to_float(a_src, a_dst, a_count);
+}
+
+void
+double_to_float(const double* a_src, float* a_dst, size_t a_count)
+{
+    HdCyclesArrayConversions::Get().double_to_float(a_src, a_dst, a_count);
+}
+
+void
+float_to_half(const float* a_src, GfHalf* a_dst, size_t a_count)
+{
+    HdCyclesArrayConversions::Get().float_to_half(a_src, a_dst, a_count);
+}
+
+void
+float_to_unorm8(const float* a_src, uint8_t* a_dst, size_t a_count)
+{
+    HdCyclesArrayConversions::Get().float_to_unorm8(a_src, a_dst, a_count);
+}
+
+void
+offset_int32(int32_t* a_data, int32_t a_offset, size_t a_count)
+{
+    HdCyclesArrayConversions::Get().offset_int32(a_data, a_offset, a_count);
+}
+
+VtValue
+array_to_float_array(const VtValue& a_value)
+{
+    if (!a_value.IsArrayValued() || a_value.GetArraySize() == 0) {
+        return a_value;
+    }
+
+    switch (HdGetValueTupleType(a_value).type) {
+    case HdTypeDouble: return components_to_float_array<float>(a_value, &double_to_float);
+    case HdTypeDoubleVec2: return components_to_float_array<GfVec2f>(a_value, &double_to_float);
+    case HdTypeDoubleVec3: return components_to_float_array<GfVec3f>(a_value, &double_to_float);
+    case HdTypeDoubleVec4: return components_to_float_array<GfVec4f>(a_value, &double_to_float);
+    case HdTypeHalfFloat: return components_to_float_array<float>(a_value, &half_to_float);
+    case HdTypeHalfFloatVec2: return components_to_float_array<GfVec2f>(a_value, &half_to_float);
+    case HdTypeHalfFloatVec3: return components_to_float_array<GfVec3f>(a_value, &half_to_float);
+    case HdTypeHalfFloatVec4: return components_to_float_array<GfVec4f>(a_value, &half_to_float);
+    default: return a_value;
+    }
+}
+
+bool
+HdCyclesSetArrayConversionIsa(HdCyclesArrayConversionIsa a_isa)
+{
+    return HdCyclesArrayConversions::Get().Select(a_isa);
+}
+
+HdCyclesArrayConversionIsa
+HdCyclesGetArrayConversionIsa()
 {
-    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]),
-                            static_cast<float>(v[3]));
+    return HdCyclesArrayConversions::Get().isa;
 }
 
 /* ========= MikkTSpace ========= */
@@ -39,6 +39,7 @@
 #include <util/util_transform.h>
 
 #include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/half.h>
 #include <pxr/base/gf/matrix4f.h>
 #include <pxr/base/gf/vec2f.h>
 #include <pxr/base/gf/vec3f.h>
@@ -149,60 +150,135 @@ ccl::Transform
 mat4f_to_transform(const GfMatrix4f& mat);
 
 
+/**
+ * @brief Scalar conversion to Cycles types, only specializations below are defined
+ *
+ */
 template<typename T, typename U>
-inline U
-to_cycles(const T& vec) noexcept
-{
-}
+U
+to_cycles(const T& vec) noexcept = delete;
 
 template<>
 inline float
-to_cycles<float, float>(const float& v) noexcept;
+to_cycles<float, float>(const float& v) noexcept
+{
+    return v;
+}
 template<>
 inline float
-to_cycles<double, float>(const double& v) noexcept;
+to_cycles<double, float>(const double& v) noexcept
+{
+    return static_cast<float>(v);
+}
 template<>
 inline float
-to_cycles<int, float>(const int& v) noexcept;
+to_cycles<int, float>(const int& v) noexcept
+{
+    return static_cast<float>(v);
+}
 
 template<>
 inline ccl::float2
-to_cycles<GfVec2f, ccl::float2>(const GfVec2f& v) noexcept;
+to_cycles<GfVec2f, ccl::float2>(const GfVec2f& v) noexcept
+{
+    return ccl::make_float2(v[0], v[1]);
+}
 template<>
 inline ccl::float2
-to_cycles<GfVec2h, ccl::float2>(const GfVec2h& v) noexcept;
+to_cycles<GfVec2h, ccl::float2>(const GfVec2h& v) noexcept
+{
+    return ccl::make_float2(static_cast<float>(v[0]), static_cast<float>(v[1]));
+}
 template<>
 inline ccl::float2
-to_cycles<GfVec2d, ccl::float2>(const GfVec2d& v) noexcept;
+to_cycles<GfVec2d, ccl::float2>(const GfVec2d& v) noexcept
+{
+    return ccl::make_float2(static_cast<float>(v[0]), static_cast<float>(v[1]));
+}
 template<>
 inline ccl::float2
-to_cycles<GfVec2i, ccl::float2>(const GfVec2i& v) noexcept;
+to_cycles<GfVec2i, ccl::float2>(const GfVec2i& v) noexcept
+{
+    return ccl::make_float2(static_cast<float>(v[0]), static_cast<float>(v[1]));
+}
 
 template<>
 inline ccl::float3
-to_cycles<GfVec3f, ccl::float3>(const GfVec3f& v) noexcept;
+to_cycles<GfVec3f, ccl::float3>(const GfVec3f& v) noexcept
+{
+    return ccl::make_float3(v[0], v[1], v[2]);
+}
 template<>
 inline ccl::float3
-to_cycles<GfVec3h, ccl::float3>(const GfVec3h& v) noexcept;
+to_cycles<GfVec3h, ccl::float3>(const GfVec3h& v) noexcept
+{
+    return ccl::make_float3(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]));
+}
 template<>
 inline ccl::float3
-to_cycles<GfVec3d, ccl::float3>(const GfVec3d& v) noexcept;
+to_cycles<GfVec3d, ccl::float3>(const GfVec3d& v) noexcept
+{
+    return ccl::make_float3(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]));
+}
 template<>
 inline ccl::float3
-to_cycles<GfVec3i, ccl::float3>(const GfVec3i& v) noexcept;
+to_cycles<GfVec3i, ccl::float3>(const GfVec3i& v) noexcept
+{
+    return ccl::make_float3(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]));
+}
 
 template<>
 inline ccl::float4
-to_cycles<GfVec3f, ccl::float4>(const GfVec3f& v) noexcept;
+to_cycles<GfVec3f, ccl::float4>(const GfVec3f& v) noexcept
+{
+    return ccl::make_float4(v[0], v[1], v[2], 1.0f);
+}
 template<>
 inline ccl::float4
-to_cycles<GfVec3h, ccl::float4>(const GfVec3h& v) noexcept;
+to_cycles<GfVec3h, ccl::float4>(const GfVec3h& v) noexcept
+{
+    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]), 1.0f);
+}
 template<>
 inline ccl::float4
-to_cycles<GfVec3d, ccl::float4>(const GfVec3d& v) noexcept;
+to_cycles<GfVec3d, ccl::float4>(const GfVec3d& v) noexcept
+{
+    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]), 1.0f);
+}
 template<>
 inline ccl::float4
-to_cycles<GfVec3i, ccl::float4>(const GfVec3i& v) noexcept;
+to_cycles<GfVec3i, ccl::float4>(const GfVec3i& v) noexcept
+{
+    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]), 1.0f);
+}
+
+template<>
+inline ccl::float4
+to_cycles<GfVec4f, ccl::float4>(const GfVec4f& v) noexcept
+{
+    return ccl::make_float4(v[0], v[1], v[2], v[3]);
+}
+template<>
+inline ccl::float4
+to_cycles<GfVec4h, ccl::float4>(const GfVec4h& v) noexcept
+{
+    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]),
+                            static_cast<float>(v[3]));
+}
+template<>
+inline ccl::float4
+to_cycles<GfVec4d, ccl::float4>(const GfVec4d& v) noexcept
+{
+    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]),
+                            static_cast<float>(v[3]));
+}
+template<>
+inline ccl::float4
+to_cycles<GfVec4i, ccl::float4>(const GfVec4i& v) noexcept
+{
+    return ccl::make_float4(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]),
+                            static_cast<float>(v[3]));
+}
 
 /**
  * @brief Convert GfVec2i to Cycles int2 representation
@@ -376,6 +452,110 @@ vec3f_to_float4(const GfVec3f& a_vec, float a_alpha = 1.0f);
 ccl::float4
 vec4f_to_float4(const GfVec4f& a_vec);
 
+/* ========= Array conversion ========= */
+
+// Array conversions used by the primvar copy loops. SSE is used on x86-64 by default, AVX2 is selected at runtime
+// when supported by the cpu. Source and destination must not overlap.
+
+/**
+ * @brief Convert array of GfVec3f to Cycles float3 representation, padding is zeroed
+ *
+ * @param a_src
+ * @param a_dst
+ * @param a_count Number of elements
+ */
+void
+vec3f_to_float3(const GfVec3f* a_src, ccl::float3* a_dst, size_t a_count);
+
+/**
+ * @brief Lossy convert array of GfVec4f to Cycles float3 representation, padding is zeroed
+ *
+ * @param a_src
+ * @param a_dst
+ * @param a_count Number of elements
+ */
+void
+vec4f_to_float3(const GfVec4f* a_src, ccl::float3* a_dst, size_t a_count);
+
+/**
+ * @brief Convert array of half to float
+ *
+ * @param a_src
+ * @param a_dst
+ * @param a_count Number of elements
+ */
+void
+half_to_float(const GfHalf* a_src, float* a_dst, size_t a_count);
+
+/**
+ * @brief Lossy convert array of double to float
+ *
+ * @param a_src
+ * @param a_dst
+ * @param a_count Number of elements
+ */
+void
+double_to_float(const double* a_src, float* a_dst, size_t a_count);
+
+/**
+ * @brief Lossy convert array of float to half
+ *
+ * @param a_src
+ * @param a_dst
+ * @param a_count Number of elements
+ */
+void
+float_to_half(const float* a_src, GfHalf* a_dst, size_t a_count);
+
+/**
+ * @brief Convert array of float to unsigned normalized 8 bit, values are clamped to [0, 1] and truncated
+ *
+ * @param a_src
+ * @param a_dst
+ * @param a_count Number of elements
+ */
+void
+float_to_unorm8(const float* a_src, uint8_t* a_dst, size_t a_count);
+
+/**
+ * @brief Add offset to every element of int32 array in place
+ *
+ * @param a_data
+ * @param a_offset
+ * @param a_count Number of elements
+ */
+void
+offset_int32(int32_t* a_data, int32_t a_offset, size_t a_count);
+
+/**
+ * @brief Convert double or half array value to float array of the same dimension with the array conversions,
+ * e.g. VtVec3dArray to VtVec3fArray. Other values are returned as they are
+ *
+ * @param a_value
+ * @return Converted value
+ */
+VtValue
+array_to_float_array(const VtValue& a_value);
+
+/// Instruction set used by the array conversions
+enum class HdCyclesArrayConversionIsa { Scalar, SSE, AVX2 };
+
+/**
+ * @brief Force instruction set of the array conversions, the best one supported by the cpu is used by default.
+ * Meant for tests, must not be called while conversions are running
+ *
+ * @param a_isa
+ * @return false if instruction set is not supported by the build or the cpu, conversions are left as they are
+ */
+bool
+HdCyclesSetArrayConversionIsa(HdCyclesArrayConversionIsa a_isa);
+
+/**
+ * @brief Instruction set currently used by the array conversions
+ */
+HdCyclesArrayConversionIsa
+HdCyclesGetArrayConversionIsa();
+
 /* ========= Primvars ========= */
 
 // HdCycles primvar handling. Designed reference based on HdArnold implementation
@@ -62,6 +62,7 @@ TF_DEFINE_PRIVATE_TOKENS(_tokens,
 HdCyclesVolume::HdCyclesVolume(SdfPath const& id, SdfPath const& instancerId, HdCyclesRenderDelegate* a_renderDelegate)
     : HdBbRPrim<HdVolume>(id, instancerId)
     , m_cyclesVolume(nullptr)
+    , m_instances(a_renderDelegate->GetCyclesRenderParam())
     , m_renderDelegate(a_renderDelegate)
 {
     static const HdCyclesConfig& config = HdCyclesConfig::GetInstance();
@@ -93,12 +94,7 @@ HdCyclesVolume::~HdCyclesVolume()
         delete m_cyclesVolume;
     }
 
-    for (auto instance : m_cyclesInstances) {
-        if (instance) {
-            m_renderDelegate->GetCyclesRenderParam()->RemoveObjectSafe(instance);
-            delete instance;
-        }
-    }
+    m_instances.Clear();
 }
 
 void
@@ -248,7 +244,7 @@ HdCyclesVolume::_UpdateGrids()
 void
 HdCyclesVolume::_UpdateObject(ccl::Scene* scene, HdCyclesRenderParam* param, HdDirtyBits* dirtyBits, bool rebuildBvh)
 {
-    if (m_cyclesInstances.empty()) {
+    if (m_instances.IsEmpty()) {
         m_cyclesObject->visibility = _sharedData.visible ? m_visibilityFlags : 0;
     } else {
         m_cyclesObject->visibility = 0;
@@ -375,56 +371,15 @@ HdCyclesVolume::Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam,
         const SdfPath& instancer_id = GetInstancerId();
         auto instancer = dynamic_cast<HdCyclesInstancer*>(sceneDelegate->GetRenderIndex().GetInstancer(instancer_id));
         if (instancer) {
-            // Clear all instances...
-            for (auto instance : m_cyclesInstances) {
-                if (instance) {
-                    m_renderDelegate->GetCyclesRenderParam()->RemoveObject(instance);
-                    delete instance;
-                }
-            }
-            m_cyclesInstances.clear();
-
-            // create new instances
-            auto instanceTransforms = instancer->SampleInstanceTransforms(id);
-            auto newNumInstances = (instanceTransforms.count > 0) ? instanceTransforms.values[0].size() : 0;
-
-            if (newNumInstances != 0) {
-                using size_type = typename decltype(m_transformSamples.values)::size_type;
-
-                std::vector<TfSmallVector<GfMatrix4d, 1>> combinedTransforms;
-                combinedTransforms.reserve(newNumInstances);
-                for (size_t i = 0; i < newNumInstances; ++i) {
-                    // Apply prototype transform (m_transformSamples) to all the instances
-                    combinedTransforms.emplace_back(instanceTransforms.count);
-                    auto& instanceTransform = combinedTransforms.back();
-
-                    if (m_transformSamples.count == 0
-                        || (m_transformSamples.count == 1 && (m_transformSamples.values[0] == GfMatrix4d(1)))) {
-                        for (size_type j = 0; j < instanceTransforms.count; ++j) {
-                            instanceTransform[j] = instanceTransforms.values[j][i];
-                        }
-                    } else {
-                        for (size_type j = 0; j < instanceTransforms.count; ++j) {
-                            GfMatrix4d xf_j = m_transformSamples.Resample(instanceTransforms.times[j]);
-                            instanceTransform[j] = xf_j * instanceTransforms.values[j][i];
-                        }
-                    }
-                }
-
-                for (size_t j = 0; j < newNumInstances; ++j) {
-                    ccl::Object* instanceObj = _CreateObject();
+            const unsigned int motion_steps = m_useMotionBlur ? static_cast<unsigned int>(HD_CYCLES_MOTION_STEPS) : 0;
+            m_instances.SetTransforms(instancer->SampleInstanceTransforms(id), m_transformSamples, obj_tfm,
+                                      motion_steps);
+            m_instances.SetVisibility(_sharedData.visible ? m_visibilityFlags : 0);
+            m_instances.SetColors(VtVec3fArray {}, m_cyclesObject->color);
+            m_instances.SetInstancerId(instancer_id);
+            m_instances.Commit(scene, m_cyclesVolume, *m_cyclesObject);
 
-                    instanceObj->visibility = _sharedData.visible ? m_visibilityFlags : 0;
-                    instanceObj->tfm = mat4d_to_transform(combinedTransforms[j].data()[0]) * obj_tfm;
-                    instanceObj->geometry = m_cyclesVolume;
-
-                    m_cyclesInstances.push_back(instanceObj);
-
-                    m_renderDelegate->GetCyclesRenderParam()->AddObject(instanceObj);
-                }
-
-                update_volumes = true;
-            }
+            update_volumes = true;
         }
     }
 
@@ -23,6 +23,7 @@
 #include "api.h"
 
 #include "hdcycles.h"
+#include "instanceArray.h"
 #include "renderDelegate.h"
 #include "rprim.h"
 #include "utils.h"
@@ -159,7 +160,7 @@ private:
 
     HdCyclesObjectSourceSharedPtr m_object_source;
 
-    std::vector<ccl::Object*> m_cyclesInstances;
+    HdCyclesInstanceArray m_instances;
 
     HdCyclesRenderDelegate* m_renderDelegate;
 
@@ -19,6 +19,11 @@
 
 #include "engine.h"
 
+#include <hdCycles/renderBuffer.h>
+#include <hdCycles/renderDelegate.h>
+#include <hdCycles/renderParam.h>
+#include <hdCycles/utils.h>
+
 #include <pxr/pxr.h>
 #include <pxr/usdImaging/usdImaging/delegate.h>
 
@@ -35,16 +40,27 @@
 #include <pxr/imaging/hgi/tokens.h>
 
 #include <pxr/base/arch/systemInfo.h>
+#include <pxr/base/gf/rect2i.h>
+#include <pxr/base/tf/stringUtils.h>
 #include <pxr/base/plug/plugin.h>
 #include <pxr/base/plug/registry.h>
 
+#include <pxr/usd/usdRender/product.h>
 #include <pxr/usd/usdRender/settings.h>
 #include <pxr/usd/usdRender/spec.h>
+#include <pxr/usd/usdRender/tokens.h>
+#include <pxr/usd/usdRender/var.h>
 #include <pxr/usd/usd/common.h>
 
 #include <OpenImageIO/imageio.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include <tbb/task_scheduler_init.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #ifdef USE_HBOOST
 #    include <hboost/program_options.hpp>
 #else
@@ -83,8 +99,544 @@ IsConverged(const HdTaskSharedPtrVector& tasks)
     return converged;
 }
 
+// Viewport and render buffer size until a resolution is set
+constexpr int DefaultWidth = 1200;
+constexpr int DefaultHeight = 700;
+
+///
+/// Render buffer format of RenderVar data type, invalid if the type has no matching format
+///
+HdFormat
+GetRenderVarFormat(const TfToken& dataType)
+{
+    const std::string& type = dataType.GetString();
+    if (type == "float") {
+        return HdFormatFloat32;
+    } else if (type == "float2" || type == "texCoord2f") {
+        return HdFormatFloat32Vec2;
+    } else if (type == "float3" || type == "color3f" || type == "vector3f" || type == "normal3f" || type == "point3f") {
+        return HdFormatFloat32Vec3;
+    } else if (type == "float4" || type == "color4f") {
+        return HdFormatFloat32Vec4;
+    } else if (type == "half") {
+        return HdFormatFloat16;
+    } else if (type == "half3" || type == "color3h") {
+        return HdFormatFloat16Vec3;
+    } else if (type == "half4" || type == "color4h") {
+        return HdFormatFloat16Vec4;
+    } else if (type == "int") {
+        return HdFormatInt32;
+    }
+    return HdFormatInvalid;
+}
+
+// Tiles of the output image, pixels are converted and written one row of tiles at a time
+constexpr int OutputTileSize = 64;
+
+///
+/// Bound AOV written as one part (subimage) of the output image
+///
+struct OutputPart {
+    HdRenderBuffer* buffer;
+    OIIO::ImageSpec spec;
+    bool packHalf;  // File stores half floats
+};
+
+bool
+IsCryptomatteAov(const TfToken& aovName, const std::vector<std::string>& cryptomatteNames)
+{
+    for (const std::string& name : cryptomatteNames) {
+        if (TfStringStartsWith(aovName.GetString(), name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string
+GetChannelName(const TfToken& aovName, int channel, int numChannels)
+{
+    static const char* rgba[] = { "R", "G", "B", "A" };
+    if (aovName == HdAovTokens->color) {
+        return rgba[channel];
+    }
+    if (aovName == HdAovTokens->depth && numChannels == 1) {
+        return aovName.GetString() + ".Z";
+    }
+    return aovName.GetString() + "." + rgba[channel];
+}
+
+///
+/// Convert rows of the render buffer to the pixel type of the file, float or half
+///
+void
+ConvertRows(const uint8_t* src, HdFormat format, size_t numValues, bool packHalf, uint8_t* dst)
+{
+    switch (HdGetComponentFormat(format)) {
+    case HdFormatFloat32: {
+        auto values = reinterpret_cast<const float*>(src);
+        if (packHalf) {
+            float_to_half(values, reinterpret_cast<GfHalf*>(dst), numValues);
+        } else {
+            memcpy(dst, values, numValues * sizeof(float));
+        }
+    } break;
+    case HdFormatFloat16: {
+        auto values = reinterpret_cast<const GfHalf*>(src);
+        if (packHalf) {
+            memcpy(dst, values, numValues * sizeof(GfHalf));
+        } else {
+            half_to_float(values, reinterpret_cast<float*>(dst), numValues);
+        }
+    } break;
+    case HdFormatInt32: {
+        // Ids are stored as plain float values, not normalized
+        auto values = reinterpret_cast<const int32_t*>(src);
+        auto out = reinterpret_cast<float*>(dst);
+        for (size_t i = 0; i < numValues; ++i) {
+            out[i] = static_cast<float>(values[i]);
+        }
+    } break;
+    case HdFormatUNorm8: {
+        auto out = reinterpret_cast<float*>(dst);
+        for (size_t i = 0; i < numValues; ++i) {
+            out[i] = static_cast<float>(src[i]) / 255.0f;
+        }
+    } break;
+    default: memset(dst, 0, numValues * (packHalf ? sizeof(GfHalf) : sizeof(float))); break;
+    }
+}
+
+///
+/// Write the render buffer to the currently open subimage, one row of tiles at a time.
+/// Conversion of the rows runs on worker threads, memory is bounded by a single row of tiles.
+///
+bool
+WritePart(OIIO::ImageOutput* out, const OutputPart& part, bool tiled)
+{
+    HdRenderBuffer* buffer = part.buffer;
+    const HdFormat format = buffer->GetFormat();
+    const int width = part.spec.width;
+    const int height = part.spec.height;
+    const size_t rowValues = static_cast<size_t>(width) * HdGetComponentCount(format);
+    const size_t srcRowSize = static_cast<size_t>(width) * HdDataSizeOfFormat(format);
+    const size_t dstRowSize = rowValues * (part.packHalf ? sizeof(GfHalf) : sizeof(float));
+    const OIIO::TypeDesc type = part.packHalf ? OIIO::TypeDesc::HALF : OIIO::TypeDesc::FLOAT;
+
+    auto data = static_cast<const uint8_t*>(buffer->Map());
+    if (!data) {
+        buffer->Unmap();
+        return false;
+    }
+
+    std::vector<uint8_t> band(dstRowSize * OutputTileSize);
+
+    bool written = true;
+    for (int y = 0; y < height && written; y += OutputTileSize) {
+        const int yend = std::min(y + OutputTileSize, height);
+
+        tbb::parallel_for(tbb::blocked_range<int>(y, yend), [&](const tbb::blocked_range<int>& r) {
+            for (int row = r.begin(); row < r.end(); ++row) {
+                ConvertRows(data + static_cast<size_t>(row) * srcRowSize, format, rowValues, part.packHalf,
+                            band.data() + static_cast<size_t>(row - y) * dstRowSize);
+            }
+        });
+
+        written = tiled ? out->write_tiles(0, width, y, yend, 0, 1, type, band.data())
+                        : out->write_scanlines(y, yend, 0, type, band.data());
+    }
+
+    buffer->Unmap();
+    return written;
+}
+
+///
+/// Cryptomatte metadata reported by the render delegate, layer names are used to identify cryptomatte AOVs
+///
+VtDictionary
+GetCryptomatteMetadata(HdRenderDelegate* renderDelegate, std::vector<std::string>& names)
+{
+    VtDictionary metadata;
+    for (const auto& stat : renderDelegate->GetRenderStats()) {
+        if (!TfStringStartsWith(stat.first, "cryptomatte/") || !stat.second.IsHolding<std::string>()) {
+            continue;
+        }
+        metadata[stat.first] = stat.second;
+        if (TfStringEndsWith(stat.first, "/name")) {
+            names.push_back(stat.second.UncheckedGet<std::string>());
+        }
+    }
+    return metadata;
+}
+
+///
+/// One part per bound AOV, formats without multiple subimages only get the first one
+///
+std::vector<OutputPart>
+GetOutputParts(const HdRenderPassAovBindingVector& bindings, const VtDictionary& cryptomatteMetadata,
+               const std::vector<std::string>& cryptomatteNames, bool tiled, bool multipart)
+{
+    using namespace OIIO;
+
+    std::vector<OutputPart> parts;
+    for (const HdRenderPassAovBinding& binding : bindings) {
+        HdRenderBuffer* buffer = binding.renderBuffer;
+        if (!buffer || buffer->GetFormat() == HdFormatInvalid) {
+            continue;
+        }
+
+        const HdFormat format = buffer->GetFormat();
+        const HdFormat componentFormat = HdGetComponentFormat(format);
+        const int numChannels = static_cast<int>(HdGetComponentCount(format));
+
+        // Colors are packed to half, cryptomatte hashes, depth and ids keep full precision
+        const bool packHalf = componentFormat == HdFormatFloat16
+                          || (componentFormat == HdFormatFloat32 && numChannels >= 3
+                              && !IsCryptomatteAov(binding.aovName, cryptomatteNames));
+
+        const int width = static_cast<int>(buffer->GetWidth());
+        const int height = static_cast<int>(buffer->GetHeight());
+        const TypeDesc type = packHalf ? TypeDesc::HALF : TypeDesc::FLOAT;
+        OutputPart part { buffer, ImageSpec(width, height, numChannels, type), packHalf };
+        part.spec.channelnames.clear();
+        for (int c = 0; c < numChannels; ++c) {
+            part.spec.channelnames.push_back(GetChannelName(binding.aovName, c, numChannels));
+        }
+        if (numChannels == 4) {
+            part.spec.alpha_channel = 3;
+        }
+        if (tiled) {
+            part.spec.tile_width = OutputTileSize;
+            part.spec.tile_height = OutputTileSize;
+        }
+        part.spec.attribute("compression", "zip");
+        part.spec.attribute("oiio:subimagename", binding.aovName.GetString());
+        for (const auto& metadata : cryptomatteMetadata) {
+            part.spec.attribute(metadata.first, metadata.second.UncheckedGet<std::string>());
+        }
+        parts.push_back(std::move(part));
+
+        if (!multipart) {
+            break;
+        }
+    }
+    return parts;
+}
+
 }  //namespace
 
+///
+/// Writes the bound AOVs as layers of a single tiled image, which unlike separate parts can be written in any
+/// order. Output tiles are written as soon as every render buffer has been written over them, the remaining
+/// ones when the stream is closed. Tiles are converted on worker threads, memory is bounded by a row of tiles.
+///
+class UsdImagingBbOutputStream {
+public:
+    explicit UsdImagingBbOutputStream(const std::string& filename);
+    ~UsdImagingBbOutputStream();
+
+    const std::string& GetFilename() const { return _filename; }
+    bool IsOpen() const { return static_cast<bool>(_out); }
+
+    /// Open the file for the parts, false if the format can't store them as layers
+    bool Open(const std::vector<OutputPart>& parts, const VtDictionary& metadata);
+
+    /// Track writes to the render buffers from now on, tiles are final once written
+    void Track();
+
+    /// Write the tiles completed since the last update
+    void Update();
+
+    /// Write the remaining tiles and close the file
+    bool Close();
+
+private:
+    struct Layer {
+        HdRenderBuffer* buffer;
+        HdCyclesRenderBuffer* cyclesBuffer;  // Null if writes can't be tracked
+        HdFormat format;
+        bool packHalf;
+        size_t offset;  // Bytes before the layer in a pixel of the file
+        size_t size;    // Bytes of the layer in a pixel of the file
+        uint64_t version;
+        std::vector<bool> covered;  // Pixels written since tracking started
+    };
+
+    void _Cover(Layer& layer, const GfRect2i& region);
+    bool _WriteTiles(const std::vector<int>& tiles);
+
+    std::string _filename;
+    std::unique_ptr<OIIO::ImageOutput> _out;
+    std::vector<Layer> _layers;
+    int _width;
+    int _height;
+    int _tilesX;
+    int _tilesY;
+    size_t _pixelSize;
+
+    std::vector<int> _remaining;  // Pixels of the tile not covered yet, summed over the layers
+    std::vector<bool> _written;   // Tiles written to the file
+    std::vector<int> _ready;      // Tiles covered by every layer but not written yet
+    bool _tracked;                // False once the writes are no longer known, the rest is written on close
+    bool _failed;
+};
+
+UsdImagingBbOutputStream::UsdImagingBbOutputStream(const std::string& filename)
+    : _filename(filename)
+    , _width(0)
+    , _height(0)
+    , _tilesX(0)
+    , _tilesY(0)
+    , _pixelSize(0)
+    , _tracked(false)
+    , _failed(false)
+{
+}
+
+UsdImagingBbOutputStream::~UsdImagingBbOutputStream()
+{
+    if (_out) {
+        Close();
+    }
+}
+
+bool
+UsdImagingBbOutputStream::Open(const std::vector<OutputPart>& parts, const VtDictionary& metadata)
+{
+    using namespace OIIO;
+
+    if (parts.empty()) {
+        return false;
+    }
+
+    // Tiles are written as they complete and layers keep their own pixel type. OpenEXR takes tiles in any order
+    // with the random line order.
+    std::unique_ptr<ImageOutput> out = ImageOutput::create(_filename);
+    if (!out || !out->supports("tiles") || !out->supports("channelformats")
+        || !(out->supports("random_access") || strcmp(out->format_name(), "openexr") == 0)) {
+        return false;
+    }
+
+    _width = parts[0].spec.width;
+    _height = parts[0].spec.height;
+
+    ImageSpec spec(_width, _height, 0, TypeDesc::FLOAT);
+    spec.channelnames.clear();
+    _layers.clear();
+    _pixelSize = 0;
+    for (const OutputPart& part : parts) {
+        if (part.spec.width != _width || part.spec.height != _height) {
+            return false;
+        }
+
+        const TypeDesc type = part.packHalf ? TypeDesc::HALF : TypeDesc::FLOAT;
+        for (int c = 0; c < part.spec.nchannels; ++c) {
+            if (part.spec.channelnames[c] == "A") {
+                spec.alpha_channel = spec.nchannels;
+            }
+            spec.channelnames.push_back(part.spec.channelnames[c]);
+            spec.channelformats.push_back(type);
+            spec.nchannels += 1;
+        }
+
+        const size_t size = static_cast<size_t>(part.spec.nchannels) * type.size();
+        _layers.push_back({ part.buffer, dynamic_cast<HdCyclesRenderBuffer*>(part.buffer), part.buffer->GetFormat(),
+                            part.packHalf, _pixelSize, size, 0, {} });
+        _pixelSize += size;
+    }
+
+    spec.tile_width = OutputTileSize;
+    spec.tile_height = OutputTileSize;
+    spec.attribute("compression", "zip");
+    spec.attribute("openexr:lineOrder", "randomY");
+    for (const auto& entry : metadata) {
+        spec.attribute(entry.first, entry.second.UncheckedGet<std::string>());
+    }
+
+    if (!out->open(_filename, spec)) {
+        return false;
+    }
+
+    _tilesX = (_width + OutputTileSize - 1) / OutputTileSize;
+    _tilesY = (_height + OutputTileSize - 1) / OutputTileSize;
+    _written.assign(static_cast<size_t>(_tilesX) * _tilesY, false);
+    _ready.clear();
+    _tracked = false;
+    _failed = false;
+    _out = std::move(out);
+    return true;
+}
+
+void
+UsdImagingBbOutputStream::Track()
+{
+    if (!_out) {
+        return;
+    }
+
+    _remaining.resize(_written.size());
+    for (int ty = 0; ty < _tilesY; ++ty) {
+        for (int tx = 0; tx < _tilesX; ++tx) {
+            const int tileWidth = std::min(OutputTileSize, _width - tx * OutputTileSize);
+            const int tileHeight = std::min(OutputTileSize, _height - ty * OutputTileSize);
+            _remaining[ty * _tilesX + tx] = tileWidth * tileHeight * static_cast<int>(_layers.size());
+        }
+    }
+
+    _tracked = true;
+    for (Layer& layer : _layers) {
+        if (!layer.cyclesBuffer) {
+            _tracked = false;
+            break;
+        }
+        layer.version = layer.cyclesBuffer->GetVersion();
+        layer.covered.assign(static_cast<size_t>(_width) * _height, false);
+    }
+}
+
+void
+UsdImagingBbOutputStream::Update()
+{
+    if (!_out || !_tracked) {
+        return;
+    }
+
+    std::vector<GfRect2i> regions;
+    for (Layer& layer : _layers) {
+        uint64_t latest = 0;
+        if (!layer.cyclesBuffer->GetChangedRegions(layer.version, &regions, &latest)
+            || layer.cyclesBuffer->GetWidth() != static_cast<unsigned int>(_width)
+            || layer.cyclesBuffer->GetHeight() != static_cast<unsigned int>(_height)) {
+            // Too many writes since the last update or resized, which tiles are done is no longer known
+            _tracked = false;
+            return;
+        }
+
+        layer.version = latest;
+        for (const GfRect2i& region : regions) {
+            _Cover(layer, region);
+        }
+    }
+
+    if (!_ready.empty() && _WriteTiles(_ready)) {
+        _ready.clear();
+    }
+}
+
+void
+UsdImagingBbOutputStream::_Cover(Layer& layer, const GfRect2i& region)
+{
+    const GfRect2i clipped = region.GetIntersection(GfRect2i { GfVec2i { 0, 0 }, _width, _height });
+    for (int y = clipped.GetMinY(); y <= clipped.GetMaxY(); ++y) {
+        const int ty = y / OutputTileSize;
+        for (int x = clipped.GetMinX(); x <= clipped.GetMaxX(); ++x) {
+            const size_t pixel = static_cast<size_t>(y) * _width + x;
+            if (layer.covered[pixel]) {
+                continue;
+            }
+            layer.covered[pixel] = true;
+
+            const int tile = ty * _tilesX + x / OutputTileSize;
+            if (--_remaining[tile] == 0 && !_written[tile]) {
+                _ready.push_back(tile);
+            }
+        }
+    }
+}
+
+bool
+UsdImagingBbOutputStream::_WriteTiles(const std::vector<int>& tiles)
+{
+    // Mapped data has to hold at least the writes the tiles were completed with
+    std::vector<const uint8_t*> data(_layers.size(), nullptr);
+    bool mapped = true;
+    for (size_t i = 0; i < _layers.size(); ++i) {
+        const Layer& layer = _layers[i];
+        uint64_t version = 0;
+        if (layer.cyclesBuffer) {
+            data[i] = static_cast<const uint8_t*>(layer.cyclesBuffer->Map(&version));
+        } else {
+            data[i] = static_cast<const uint8_t*>(layer.buffer->Map());
+        }
+        mapped = mapped && data[i] && (!_tracked || version >= layer.version);
+    }
+
+    bool written = mapped;
+    for (size_t first = 0; first < tiles.size() && written; first += static_cast<size_t>(_tilesX)) {
+        const size_t last = std::min(tiles.size(), first + static_cast<size_t>(_tilesX));
+        std::vector<std::vector<uint8_t>> pixels(last - first);
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(first, last, 1), [&](const tbb::blocked_range<size_t>& r) {
+            std::vector<uint8_t> row;
+            for (size_t i = r.begin(); i < r.end(); ++i) {
+                const int x = (tiles[i] % _tilesX) * OutputTileSize;
+                const int y = (tiles[i] / _tilesX) * OutputTileSize;
+                const int tileWidth = std::min(OutputTileSize, _width - x);
+                const int tileHeight = std::min(OutputTileSize, _height - y);
+
+                // Rows of every layer are converted and interleaved into the pixels of the file
+                std::vector<uint8_t>& tile = pixels[i - first];
+                tile.resize(static_cast<size_t>(tileWidth) * tileHeight * _pixelSize);
+                for (size_t l = 0; l < _layers.size(); ++l) {
+                    const Layer& layer = _layers[l];
+                    const size_t numChannels = HdGetComponentCount(layer.format);
+                    const size_t srcPixelSize = HdDataSizeOfFormat(layer.format);
+                    row.resize(tileWidth * layer.size);
+
+                    for (int j = 0; j < tileHeight; ++j) {
+                        const size_t src = (static_cast<size_t>(y + j) * _width + x) * srcPixelSize;
+                        ConvertRows(data[l] + src, layer.format, tileWidth * numChannels, layer.packHalf, row.data());
+                        uint8_t* dst = tile.data() + static_cast<size_t>(j) * tileWidth * _pixelSize + layer.offset;
+                        for (int k = 0; k < tileWidth; ++k) {
+                            memcpy(dst + k * _pixelSize, row.data() + k * layer.size, layer.size);
+                        }
+                    }
+                }
+            }
+        });
+
+        for (size_t i = first; i < last && written; ++i) {
+            const int x = (tiles[i] % _tilesX) * OutputTileSize;
+            const int y = (tiles[i] / _tilesX) * OutputTileSize;
+            written = _out->write_tiles(x, std::min(x + OutputTileSize, _width), y,
+                                        std::min(y + OutputTileSize, _height), 0, 1, OIIO::TypeDesc::UNKNOWN,
+                                        pixels[i - first].data());
+            _written[tiles[i]] = written;
+        }
+    }
+
+    for (size_t i = 0; i < _layers.size(); ++i) {
+        if (data[i]) {
+            _layers[i].buffer->Unmap();
+        }
+    }
+
+    _failed = _failed || (mapped && !written);
+    return written;
+}
+
+bool
+UsdImagingBbOutputStream::Close()
+{
+    if (!_out) {
+        return false;
+    }
+
+    // Tiles that were never completed while rendering, all of them if the writes were not tracked
+    _tracked = false;
+    std::vector<int> remaining;
+    for (size_t tile = 0; tile < _written.size(); ++tile) {
+        if (!_written[tile]) {
+            remaining.push_back(static_cast<int>(tile));
+        }
+    }
+
+    const bool written = _WriteTiles(remaining) && !_failed;
+    _out->close();
+    _out.reset();
+    return written;
+}
+
 TF_DEFINE_PRIVATE_TOKENS(_tokens, (renderBufferDescriptor));
 
 ///
@@ -147,7 +699,8 @@ HdRendererPlugin* UsdImagingBbEngine::FindPlugin(std::string const& pluginName)
 }
 
 bool
-UsdImagingBbEngine::CreateDelegates(HdRendererPlugin* plugin, const HdRenderSettingsMap& render_settings)
+UsdImagingBbEngine::CreateDelegates(HdRendererPlugin* plugin, const HdRenderSettingsMap& render_settings,
+                                    const std::vector<UsdImagingBbAov>& aovs)
 {
     //
     // Create Render Delegate
@@ -183,19 +736,49 @@ UsdImagingBbEngine::CreateDelegates(HdRendererPlugin* plugin, const HdRenderSett
     _engine = std::make_unique<HdEngine>();
 
     //
-    // Render Buffers
+    // Render Buffers, one per AOV. Color is rendered when nothing is requested
     //
-    _renderBufferId = SdfPath { "/task_controller/render_buffer" };
-    {
-        _bufferIds.emplace_back("/task_controller/render_buffer");
-        _renderIndex->InsertBprim(HdPrimTypeTokens->renderBuffer, _paramsDelegate.get(), _renderBufferId);
-        _renderBuffer = dynamic_cast<HdRenderBuffer*>(
-            _renderIndex->GetBprim(HdPrimTypeTokens->renderBuffer, _renderBufferId));
+    std::vector<UsdImagingBbAov> outputs = aovs;
+    if (outputs.empty()) {
+        outputs.push_back({ HdAovTokens->color, TfToken {}, HdFormatInvalid });
+    }
+
+    // AOV binding must not be empty, empty is assumed to be GL
+    HdRenderPassAovBindingVector aov_binding;
+    for (const UsdImagingBbAov& aov : outputs) {
+        const SdfPath bufferId = SdfPath { "/task_controller" }.AppendChild(
+            TfToken { "aov_" + TfMakeValidIdentifier(aov.name.GetString()) });
+        if (_renderIndex->GetBprim(HdPrimTypeTokens->renderBuffer, bufferId)) {
+            TF_WARN("Skipping duplicate AOV %s", aov.name.GetText());
+            continue;
+        }
+
+        HdFormat format = aov.format;
+        if (format == HdFormatInvalid) {
+            const TfToken& source = aov.sourceName.IsEmpty() ? aov.name : aov.sourceName;
+            format = _renderDelegate->GetDefaultAovDescriptor(source).format;
+        }
+        if (format == HdFormatInvalid) {
+            format = HdFormatFloat32Vec4;
+        }
+
+        _bufferIds.push_back(bufferId);
+        _renderIndex->InsertBprim(HdPrimTypeTokens->renderBuffer, _paramsDelegate.get(), bufferId);
+        auto buffer = dynamic_cast<HdRenderBuffer*>(_renderIndex->GetBprim(HdPrimTypeTokens->renderBuffer, bufferId));
 
         HdRenderBufferDescriptor desc {};
+        desc.dimensions = GfVec3i { DefaultWidth, DefaultHeight, 1 };
         desc.multiSampled = false;
-        desc.format = HdFormatFloat32Vec4;
-        _paramsDelegate->SetParameter(_renderBufferId, _tokens->renderBufferDescriptor, desc);
+        desc.format = format;
+        _paramsDelegate->SetParameter(bufferId, _tokens->renderBufferDescriptor, desc);
+
+        aov_binding.emplace_back();
+        aov_binding.back().aovName = aov.name;
+        aov_binding.back().renderBufferId = bufferId;
+        aov_binding.back().renderBuffer = buffer;
+        if (!aov.sourceName.IsEmpty()) {
+            aov_binding.back().aovSettings[UsdRenderTokens->sourceName] = VtValue { aov.sourceName.GetString() };
+        }
     }
 
     //
@@ -210,15 +793,7 @@ UsdImagingBbEngine::CreateDelegates(HdRendererPlugin* plugin, const HdRenderSett
         _renderIndex->InsertTask<HdxRenderTask>(_paramsDelegate.get(), _renderTaskId);
 
         HdxRenderTaskParams params {};
-        params.viewport = GfVec4d(0, 0, 1200, 700);
-
-        // AOV binding must not be empty, empty is assumed to be GL
-        HdRenderPassAovBindingVector aov_binding;
-        aov_binding.emplace_back();
-        aov_binding.back().aovName = HdAovTokens->color;
-        aov_binding.back().renderBufferId = _renderBufferId;
-        aov_binding.back().renderBuffer = _renderBuffer;
-
+        params.viewport = GfVec4d(0, 0, DefaultWidth, DefaultHeight);
         params.aovBindings = aov_binding;
         _paramsDelegate->SetParameter(_renderTaskId, HdTokens->params, params);
 
@@ -246,38 +821,112 @@ UsdImagingBbEngine::Render()
 {
     auto tasks = GetTasks(_renderIndex.get(), _taskIds);
 
+    bool started = false;
     do {
         TF_PY_ALLOW_THREADS_IN_SCOPE();
         _engine->Execute(&_sceneDelegate->GetRenderIndex(), &tasks);
+
+        // Buffers are allocated and cleared by the first execution, tiles written from then on are final
+        if (_stream && !started && !_OpenStream()) {
+            _stream.reset();
+        }
+        if (_stream) {
+            _stream->Update();
+        }
+        started = true;
     } while (!IsConverged(tasks));
 }
 
+void
+UsdImagingBbEngine::StreamToFile(const std::string& filename)
+{
+    _stream.reset(new UsdImagingBbOutputStream { filename });
+}
+
 bool
-UsdImagingBbEngine::WriteToFile(const std::string& filename) const
+UsdImagingBbEngine::_OpenStream()
+{
+    // Progressive renders write every tile many times, only tiles that Cycles renders once can be streamed
+    auto cyclesDelegate = dynamic_cast<HdCyclesRenderDelegate*>(_renderDelegate);
+    if (!cyclesDelegate || !cyclesDelegate->GetCyclesRenderParam()) {
+        return false;
+    }
+
+    HdCyclesRenderParam* renderParam = cyclesDelegate->GetCyclesRenderParam();
+    if (!renderParam->IsTiledRender() || !renderParam->GetCyclesSession()
+        || renderParam->GetCyclesSession()->params.progressive_refine) {
+        return false;
+    }
+
+    std::vector<std::string> cryptomatteNames;
+    const VtDictionary cryptomatteMetadata = GetCryptomatteMetadata(_renderDelegate, cryptomatteNames);
+    const auto params = _paramsDelegate->GetParameter<HdxRenderTaskParams>(_renderTaskId, HdTokens->params);
+    if (!_stream->Open(GetOutputParts(params.aovBindings, cryptomatteMetadata, cryptomatteNames, true, true),
+                       cryptomatteMetadata)) {
+        return false;
+    }
+
+    _stream->Track();
+    return true;
+}
+
+bool
+UsdImagingBbEngine::WriteToFile(const std::string& filename)
 {
     using namespace OIIO;
+
+    // Tiles were streamed while rendering, only the remaining ones are left
+    std::unique_ptr<UsdImagingBbOutputStream> stream = std::move(_stream);
+    if (stream && stream->IsOpen() && stream->GetFilename() == filename) {
+        return stream->Close();
+    }
+
+    std::vector<std::string> cryptomatteNames;
+    const VtDictionary cryptomatteMetadata = GetCryptomatteMetadata(_renderDelegate, cryptomatteNames);
+    const auto params = _paramsDelegate->GetParameter<HdxRenderTaskParams>(_renderTaskId, HdTokens->params);
+
+    // Same layered image as a streamed render, written in one go
+    stream.reset(new UsdImagingBbOutputStream { filename });
+    if (stream->Open(GetOutputParts(params.aovBindings, cryptomatteMetadata, cryptomatteNames, true, true),
+                     cryptomatteMetadata)) {
+        return stream->Close();
+    }
+
+    // Formats without per channel types get one part per AOV
     std::unique_ptr<ImageOutput> out = ImageOutput::create(filename);
     if (!out) {
         return false;
     }
 
-    HdFormat format = _renderBuffer->GetFormat();
-    if (format != HdFormatFloat32Vec4) {
+    const bool tiled = out->supports("tiles");
+    const bool multipart = out->supports("multiimage");
+    std::vector<OutputPart> parts = GetOutputParts(params.aovBindings, cryptomatteMetadata, cryptomatteNames, tiled,
+                                                   multipart);
+    if (parts.empty()) {
         return false;
     }
 
-    void* data = _renderBuffer->Map();
+    std::vector<ImageSpec> specs;
+    specs.reserve(parts.size());
+    for (const OutputPart& part : parts) {
+        specs.push_back(part.spec);
+    }
 
-    unsigned int xres = _renderBuffer->GetWidth();
-    unsigned int yres = _renderBuffer->GetHeight();
+    if (!out->open(filename, static_cast<int>(specs.size()), specs.data())) {
+        return false;
+    }
 
-    ImageSpec spec(xres, yres, 4, TypeDesc::TypeFloat4);
-    out->open(filename, spec);
-    out->write_image(TypeDesc::FLOAT, data);
-    out->close();
+    bool written = true;
+    for (size_t i = 0; i < parts.size() && written; ++i) {
+        if (i > 0 && !out->open(filename, parts[i].spec, ImageOutput::AppendSubimage)) {
+            written = false;
+            break;
+        }
+        written = WritePart(out.get(), parts[i], tiled);
+    }
 
-    _renderBuffer->Unmap();
-    return true;
+    out->close();
+    return written;
 }
 
 void
@@ -340,6 +989,26 @@ UsdImagingBbEngine::SetResolution(int x, int y)
     }
 }
 
+void
+UsdImagingBbEngine::SetTime(double frame)
+{
+    // Delegates, the Cycles session and its scene are kept, only time varying prims are synced again
+    _sceneDelegate->SetTime(UsdTimeCode { frame });
+}
+
+bool
+UsdImagingBbEngine::SetCheckpoint(const std::string& path, double interval)
+{
+    // Checkpoints are specific to Blackbird, other delegates can't resume
+    auto cyclesDelegate = dynamic_cast<HdCyclesRenderDelegate*>(_renderDelegate);
+    if (!cyclesDelegate || !cyclesDelegate->GetCyclesRenderParam()) {
+        return false;
+    }
+
+    cyclesDelegate->GetCyclesRenderParam()->SetCheckpoint(path, interval);
+    return true;
+}
+
 bool
 UsdImagingBbEngine::ReadRenderSettings(const std::string& path, HdRenderSettingsMap& render_settings)
 {
@@ -375,6 +1044,50 @@ UsdImagingBbEngine::ReadRenderSettings(const std::string& path, HdRenderSettings
     return true;
 }
 
+bool
+UsdImagingBbEngine::ReadRenderVars(const std::string& path, std::vector<UsdImagingBbAov>& aovs)
+{
+    UsdRenderSettings settings = UsdRenderSettings::Get(_stage, SdfPath { path });
+    if (!settings) {
+        return false;
+    }
+
+    // Ordered vars of all products, AOVs are bound once even if shared by multiple products
+    SdfPathVector products;
+    settings.GetProductsRel().GetForwardedTargets(&products);
+    for (const SdfPath& productPath : products) {
+        UsdRenderProduct product { _stage->GetPrimAtPath(productPath) };
+        if (!product) {
+            continue;
+        }
+
+        SdfPathVector vars;
+        product.GetOrderedVarsRel().GetForwardedTargets(&vars);
+        for (const SdfPath& varPath : vars) {
+            UsdRenderVar var { _stage->GetPrimAtPath(varPath) };
+            if (!var) {
+                continue;
+            }
+
+            const TfToken name = var.GetPrim().GetName();
+            auto found = std::find_if(aovs.begin(), aovs.end(),
+                                      [&name](const UsdImagingBbAov& aov) { return aov.name == name; });
+            if (found != aovs.end()) {
+                continue;
+            }
+
+            std::string sourceName;
+            var.GetSourceNameAttr().Get(&sourceName);
+            TfToken dataType;
+            var.GetDataTypeAttr().Get(&dataType);
+
+            aovs.push_back({ name, TfToken { sourceName }, GetRenderVarFormat(dataType) });
+        }
+    }
+
+    return true;
+}
+
 PXR_NAMESPACE_CLOSE_SCOPE
 
 #include <iostream>
@@ -384,6 +1097,35 @@ PXR_NAMESPACE_USING_DIRECTIVE
 namespace po = BOOST_NS::program_options;
 using BOOST_NS::array;
 using Resolution = std::vector<int>;
+using FrameRange = std::vector<double>;
+
+namespace {
+
+// Output filename of a frame, '#' characters are replaced by the zero padded frame number.
+// Without them the frame number is inserted before the extension.
+std::string
+GetFrameFilename(const std::string& filename, double frame)
+{
+    const auto number = static_cast<int>(std::round(frame));
+
+    const size_t first = filename.find('#');
+    if (first == std::string::npos) {
+        // Dot of the extension, not one in a directory name
+        size_t split = filename.rfind('.');
+        const size_t separator = filename.find_last_of("/\\");
+        if (split == std::string::npos || (separator != std::string::npos && split < separator)) {
+            split = filename.size();
+        }
+        return filename.substr(0, split) + TfStringPrintf(".%04d", number) + filename.substr(split);
+    }
+
+    const size_t last = filename.find_first_not_of('#', first);
+    const size_t padding = (last == std::string::npos ? filename.size() : last) - first;
+    return filename.substr(0, first) + TfStringPrintf("%0*d", static_cast<int>(padding), number)
+           + (last == std::string::npos ? std::string {} : filename.substr(last));
+}
+
+}  // namespace
 
 
 int
@@ -396,7 +1138,12 @@ main(int argc, char** argv)
         ("usd-input", po::value<std::string>(), "The USD file for the scene")
         ("camera,c", po::value<std::string>(), "Render from the specified camera")
         ("output,o", po::value<std::string>(), "Output image")
-        ("res,r", po::value<Resolution>(), "Image resolution (e.g. '--res 1280 720')")
+        ("res,r", po::value<Resolution>()->multitoken(), "Image resolution (e.g. '--res 1280 720')")
+        ("frames,f", po::value<FrameRange>()->multitoken(), "Render inclusive frame range, output '#' are replaced by the frame (e.g. '--frames 1 24')")
+        ("frame-step", po::value<double>()->default_value(1.0), "Step between frames of the range")
+        ("checkpoint", po::value<std::string>(), "Periodically save the render to the checkpoint file, resume from it if it exists")
+        ("checkpoint-interval", po::value<double>()->default_value(300.0), "Seconds between checkpoints")
+        ("aov,a", po::value<std::vector<std::string>>()->composing(), "AOV to render as name[:type], repeatable (e.g. '--aov depth:float'). Overrides RenderVars")
         ("renderer,R", po::value<std::string>()->default_value("HdCyclesRendererPlugin"), "Choose a specific delegate. Default is Blackbird")
         ("threads,j",po::value<int>()->default_value(-1),"Choose an specific delegate. Default is Blackbird")
         ("settings,s",po::value<std::string>()->default_value("/Render/rendersettings1"),"Render using properties defined by node.");
@@ -461,9 +1208,29 @@ main(int argc, char** argv)
         }
     }
 
+    // AOVs from the command line or the render settings RenderVars
+    std::vector<UsdImagingBbAov> aovs;
+    if (var_map.count("aov")) {
+        for (const std::string& aov : var_map["aov"].as<std::vector<std::string>>()) {
+            const size_t separator = aov.find(':');
+            const TfToken name { aov.substr(0, separator) };
+            HdFormat format = HdFormatInvalid;
+            if (separator != std::string::npos) {
+                format = GetRenderVarFormat(TfToken { aov.substr(separator + 1) });
+                if (format == HdFormatInvalid) {
+                    std::cout << "Unknown type of aov: " << aov << '\n';
+                    return EXIT_FAILURE;
+                }
+            }
+            aovs.push_back({ name, TfToken {}, format });
+        }
+    } else {
+        engine.ReadRenderVars(var_map["settings"].as<std::string>(), aovs);
+    }
+
     // create delegates
     {
-        if (!engine.CreateDelegates(plugin, render_settings)) {
+        if (!engine.CreateDelegates(plugin, render_settings, aovs)) {
             std::cout << "Unable to create render and scene delegate\n";
             return EXIT_FAILURE;
         }
@@ -484,12 +1251,60 @@ main(int argc, char** argv)
         }
     }
 
-    engine.Render();
+    // command line resolution wins over render settings
+    if (var_map.count("res")) {
+        auto res = var_map["res"].as<Resolution>();
+        if (res.size() != 2) {
+            std::cout << "Resolution requires width and height (e.g. '--res 1280 720')" << '\n';
+            return EXIT_FAILURE;
+        }
+        engine.SetResolution(res[0], res[1]);
+    }
+
+    // resume from and periodically save the checkpoint, before the first render starts the session
+    if (var_map.count("checkpoint")) {
+        if (var_map.count("frames")) {
+            std::cout << "Checkpoints are not supported with frame ranges" << '\n';
+            return EXIT_FAILURE;
+        }
 
-    // write
-    {
-        auto output = var_map["output"].as<std::string>();
+        const auto checkpoint = var_map["checkpoint"].as<std::string>();
+        if (!engine.SetCheckpoint(checkpoint, var_map["checkpoint-interval"].as<double>())) {
+            std::cout << "Renderer doesn't support checkpoints: " << checkpoint << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto output = var_map["output"].as<std::string>();
+
+    // single frame at the default time
+    if (!var_map.count("frames")) {
+        engine.StreamToFile(output);
+        engine.Render();
         engine.WriteToFile(output);
+        return EXIT_SUCCESS;
+    }
+
+    // frame range, the delegates and the Cycles session are reused for every frame
+    auto range = var_map["frames"].as<FrameRange>();
+    const double step = var_map["frame-step"].as<double>();
+    if (range.size() != 2 || range[0] > range[1] || step <= 0.0) {
+        std::cout << "Frame range requires start, end and a positive step (e.g. '--frames 1 24')" << '\n';
+        return EXIT_FAILURE;
+    }
+
+    const auto num_frames = static_cast<int>(std::floor((range[1] - range[0]) / step + 1e-6)) + 1;
+    for (int i = 0; i < num_frames; ++i) {
+        const double frame = range[0] + static_cast<double>(i) * step;
+        engine.SetTime(frame);
+
+        const std::string filename = GetFrameFilename(output, frame);
+        engine.StreamToFile(filename);
+        engine.Render();
+        if (!engine.WriteToFile(filename)) {
+            std::cout << "Unable to write frame " << frame << " to " << filename << '\n';
+            return EXIT_FAILURE;
+        }
     }
 
     return EXIT_SUCCESS;
@@ -27,6 +27,7 @@
 #include <memory>
 #include <pxr/imaging/hd/renderDelegate.h>
 #include <string>
+#include <vector>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -39,6 +40,16 @@ class HdRenderDelegate;
 class HdxTask;
 class HdRenderBuffer;
 class HdRendererPlugin;
+class UsdImagingBbOutputStream;
+
+///
+/// Render output requested from the command line or the render settings, one render buffer is bound per AOV
+///
+struct UsdImagingBbAov {
+    TfToken name;
+    TfToken sourceName;  // Empty if the AOV name is the source
+    HdFormat format;     // Invalid for the render delegate default
+};
 
 class UsdImagingBbEngine final {
 public:
@@ -48,16 +59,25 @@ public:
     HdRendererPlugin* FindPlugin(std::string const& pluginName);
     bool OpenUsdScene(std::string const& filename);
     bool ReadRenderSettings(const std::string& path, HdRenderSettingsMap& render_settings_map);
+    bool ReadRenderVars(const std::string& path, std::vector<UsdImagingBbAov>& aovs);
 
-    bool CreateDelegates(HdRendererPlugin* plugin, const HdRenderSettingsMap& render_settings);
+    bool CreateDelegates(HdRendererPlugin* plugin, const HdRenderSettingsMap& render_settings,
+                         const std::vector<UsdImagingBbAov>& aovs);
 
     void SetCamera(std::string const& camera);
     void SetResolution(int x, int y);
+    void SetTime(double frame);
+    bool SetCheckpoint(const std::string& path, double interval);
+
+    /// Write tiles to the file while rendering when Cycles renders them only once, WriteToFile completes it
+    void StreamToFile(std::string const& filename);
 
     void Render();
-    bool WriteToFile(std::string const& filename) const;
+    bool WriteToFile(std::string const& filename);
 
 private:
+    bool _OpenStream();
+
     TfToken renderDelegateId;
     HdRenderDelegate* _renderDelegate;
 
@@ -71,9 +91,9 @@ private:
     std::vector<SdfPath> _taskIds;
     std::vector<SdfPath> _bufferIds;
 
-    HdRenderBuffer* _renderBuffer;
-    SdfPath _renderBufferId;
     SdfPath _renderTaskId;
+
+    std::unique_ptr<UsdImagingBbOutputStream> _stream;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
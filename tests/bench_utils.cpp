@@ -0,0 +1,130 @@
+//  Copyright 2021 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+// Micro benchmark comparing element wise conversion loops with array conversions
+
+#include <hdCycles/utils.h>
+
+#include <pxr/base/vt/array.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+constexpr size_t num_elements = 1 << 20;
+constexpr int num_iterations = 50;
+
+template<typename Fn>
+double
+Measure(Fn&& fn)
+{
+    fn();  // warm up
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_iterations; ++i) {
+        fn();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / num_iterations;
+}
+
+void
+Report(const char* name, double scalar_ms, double array_ms)
+{
+    std::printf("%-16s scalar: %8.3f ms  array: %8.3f ms  speedup: %5.2fx\n", name, scalar_ms, array_ms,
+                scalar_ms / array_ms);
+}
+
+}  // namespace
+
+int
+main()
+{
+    {
+        VtVec3fArray src(num_elements, GfVec3f { 1.0f, 2.0f, 3.0f });
+        std::vector<ccl::float3> dst(num_elements);
+        Report("vec3f->float3", Measure([&] {
+                   for (size_t i = 0; i < num_elements; ++i) {
+                       dst[i] = vec3f_to_float3(src[i]);
+                   }
+               }),
+               Measure([&] { vec3f_to_float3(src.cdata(), dst.data(), num_elements); }));
+    }
+
+    {
+        VtVec4fArray src(num_elements, GfVec4f { 1.0f, 2.0f, 3.0f, 4.0f });
+        std::vector<ccl::float3> dst(num_elements);
+        Report("vec4f->float3", Measure([&] {
+                   for (size_t i = 0; i < num_elements; ++i) {
+                       dst[i] = vec4f_to_float3(src[i]);
+                   }
+               }),
+               Measure([&] { vec4f_to_float3(src.cdata(), dst.data(), num_elements); }));
+    }
+
+    {
+        VtHalfArray src(num_elements, GfHalf { 1.5f });
+        std::vector<float> dst(num_elements);
+        Report("half->float", Measure([&] {
+                   for (size_t i = 0; i < num_elements; ++i) {
+                       dst[i] = static_cast<float>(src[i]);
+                   }
+               }),
+               Measure([&] { half_to_float(src.cdata(), dst.data(), num_elements); }));
+    }
+
+    {
+        VtDoubleArray src(num_elements, 1.5);
+        std::vector<float> dst(num_elements);
+        Report("double->float", Measure([&] {
+                   for (size_t i = 0; i < num_elements; ++i) {
+                       dst[i] = to_cycles<double, float>(src[i]);
+                   }
+               }),
+               Measure([&] { double_to_float(src.cdata(), dst.data(), num_elements); }));
+    }
+
+    {
+        std::vector<float> src(num_elements, 0.75f);
+        std::vector<GfHalf> dst(num_elements);
+        Report("float->half", Measure([&] {
+                   for (size_t i = 0; i < num_elements; ++i) {
+                       dst[i] = GfHalf { src[i] };
+                   }
+               }),
+               Measure([&] { float_to_half(src.data(), dst.data(), num_elements); }));
+    }
+
+    {
+        std::vector<float> src(num_elements, 0.75f);
+        std::vector<uint8_t> dst(num_elements);
+        Report("float->unorm8", Measure([&] {
+                   for (size_t i = 0; i < num_elements; ++i) {
+                       dst[i] = static_cast<uint8_t>(src[i] * 255.0f);
+                   }
+               }),
+               Measure([&] { float_to_unorm8(src.data(), dst.data(), num_elements); }));
+    }
+
+    return 0;
+}
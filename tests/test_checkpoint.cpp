@@ -0,0 +1,161 @@
+//  Copyright 2021 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <doctest/doctest.h>
+
+#include <hdCycles/checkpoint.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+TEST_SUITE("Testing HdCyclesCheckpoint")
+{
+    const std::string path = "test_checkpoint.bin";
+
+    TEST_CASE("Write and read back")
+    {
+        const std::vector<float> color { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f };
+        const std::vector<int32_t> ids { 3, 7 };
+
+        HdCyclesCheckpoint checkpoint;
+        checkpoint.SetSamples(16);
+        checkpoint.SetLayer("Combined", HdFormatFloat32Vec4, 2, 1, color.data());
+        checkpoint.SetLayer("ObjectID", HdFormatInt32, 2, 1, ids.data());
+        REQUIRE(checkpoint.Write(path));
+
+        HdCyclesCheckpoint read;
+        REQUIRE(read.Read(path));
+        CHECK(read.GetSamples() == 16);
+
+        const HdCyclesCheckpoint::Layer* layer = read.GetLayer("Combined");
+        REQUIRE(layer != nullptr);
+        CHECK(layer->format == HdFormatFloat32Vec4);
+        CHECK(layer->width == 2);
+        CHECK(layer->height == 1);
+        REQUIRE(layer->data.size() == color.size() * sizeof(float));
+        CHECK(memcmp(layer->data.data(), color.data(), layer->data.size()) == 0);
+
+        layer = read.GetLayer("ObjectID");
+        REQUIRE(layer != nullptr);
+        CHECK(memcmp(layer->data.data(), ids.data(), layer->data.size()) == 0);
+
+        std::remove(path.c_str());
+    }
+
+    TEST_CASE("Missing and invalid files")
+    {
+        HdCyclesCheckpoint checkpoint;
+        CHECK(checkpoint.Read(path) == false);
+        CHECK(checkpoint.IsEmpty());
+
+        FILE* file = fopen(path.c_str(), "wb");
+        REQUIRE(file != nullptr);
+        fputs("not a checkpoint", file);
+        fclose(file);
+
+        CHECK(checkpoint.Read(path) == false);
+        CHECK(checkpoint.IsEmpty());
+
+        std::remove(path.c_str());
+    }
+
+    TEST_CASE("Blend weighted by samples")
+    {
+        const std::vector<float> saved { 1.0f, 2.0f };
+        const std::vector<int32_t> ids { 3, 7 };
+
+        HdCyclesCheckpoint checkpoint;
+        checkpoint.SetSamples(30);
+        checkpoint.SetLayer("Depth", HdFormatFloat32, 2, 1, saved.data());
+        checkpoint.SetLayer("ObjectID", HdFormatInt32, 2, 1, ids.data());
+
+        std::vector<float> rendered { 5.0f, 6.0f };
+        REQUIRE(checkpoint.Blend("Depth", HdFormatFloat32, 2, 1, 10, rendered.data()));
+        CHECK(rendered[0] == doctest::Approx(2.0f));
+        CHECK(rendered[1] == doctest::Approx(3.0f));
+
+        // Mismatching layers and integer formats are kept
+        CHECK(checkpoint.Blend("Depth", HdFormatFloat32, 1, 2, 10, rendered.data()) == false);
+        CHECK(checkpoint.Blend("Missing", HdFormatFloat32, 2, 1, 10, rendered.data()) == false);
+
+        std::vector<int32_t> renderedIds { 1, 2 };
+        CHECK(checkpoint.Blend("ObjectID", HdFormatInt32, 2, 1, 10, renderedIds.data()) == false);
+        CHECK(renderedIds[0] == 1);
+    }
+
+    TEST_CASE("Blend layer and weight for readbacks")
+    {
+        const std::vector<float> saved { 1.0f, 2.0f };
+        const std::vector<int32_t> ids { 3, 7 };
+
+        HdCyclesCheckpoint checkpoint;
+        CHECK(checkpoint.GetBlendWeight(10) == 0.0f);
+
+        checkpoint.SetSamples(30);
+        checkpoint.SetLayer("Depth", HdFormatFloat32, 2, 1, saved.data());
+        checkpoint.SetLayer("ObjectID", HdFormatInt32, 2, 1, ids.data());
+
+        CHECK(checkpoint.GetBlendLayer("Depth", HdFormatFloat32, 2, 1) == checkpoint.GetLayer("Depth"));
+        CHECK(checkpoint.GetBlendLayer("Depth", HdFormatFloat16, 2, 1) == nullptr);
+        CHECK(checkpoint.GetBlendLayer("Depth", HdFormatFloat32, 1, 2) == nullptr);
+        CHECK(checkpoint.GetBlendLayer("ObjectID", HdFormatInt32, 2, 1) == nullptr);
+
+        CHECK(checkpoint.GetBlendWeight(10) == doctest::Approx(0.75f));
+        CHECK(checkpoint.GetBlendWeight(0) == 0.0f);
+    }
+
+    TEST_CASE("Reset after resuming renders all samples")
+    {
+        const std::vector<float> saved { 1.0f, 2.0f };
+
+        HdCyclesCheckpoint checkpoint;
+        CHECK(checkpoint.GetRangeStart() == -1);
+        CHECK(checkpoint.GetRangeSamples(32) == -1);
+
+        checkpoint.SetSamples(8);
+        checkpoint.SetLayer("Depth", HdFormatFloat32, 2, 1, saved.data());
+        CHECK(checkpoint.GetRangeStart() == 8);
+        CHECK(checkpoint.GetRangeSamples(32) == 24);
+
+        // Startup resets happen before the resumed render is displayed
+        CHECK(checkpoint.Reset() == false);
+        CHECK(checkpoint.GetRangeStart() == 8);
+
+        checkpoint.SetDisplayed();
+        CHECK(checkpoint.Reset());
+        CHECK(checkpoint.IsEmpty());
+        CHECK(checkpoint.GetRangeStart() == -1);
+        CHECK(checkpoint.GetRangeSamples(32) == -1);
+
+        // Pixels of the new render are kept as rendered
+        std::vector<float> rendered { 5.0f, 6.0f };
+        CHECK(checkpoint.GetBlendLayer("Depth", HdFormatFloat32, 2, 1) == nullptr);
+        CHECK(checkpoint.GetBlendWeight(32) == 0.0f);
+        CHECK(checkpoint.Blend("Depth", HdFormatFloat32, 2, 1, 32, rendered.data()) == false);
+        CHECK(rendered[0] == 5.0f);
+        CHECK(rendered[1] == 6.0f);
+
+        // Further resets have nothing left to clear
+        checkpoint.SetDisplayed();
+        CHECK(checkpoint.Reset() == false);
+    }
+}
@@ -0,0 +1,574 @@
+//  Copyright 2021 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <doctest/doctest.h>
+
+#include <hdCycles/renderBuffer.h>
+
+#include <pxr/base/gf/rect2i.h>
+#include <pxr/base/gf/vec2i.h>
+#include <pxr/base/gf/vec3i.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+constexpr int width = 4;
+constexpr int height = 4;
+
+/// Fills the region of a one byte per pixel image
+void
+FillRegion(uint8_t* data, int data_width, const GfRect2i& region, uint8_t value)
+{
+    for (int y = region.GetMinY(); y <= region.GetMaxY(); ++y) {
+        for (int x = region.GetMinX(); x <= region.GetMaxX(); ++x) {
+            data[y * data_width + x] = value;
+        }
+    }
+}
+
+/// Writes the value to the region of the render buffer and to the expected image
+void
+WriteRegion(HdCyclesRenderBuffer& buffer, const GfRect2i& region, uint8_t value, std::vector<uint8_t>& expected)
+{
+    auto data = static_cast<uint8_t*>(buffer.BeginWrite(region));
+    REQUIRE(data != nullptr);
+    FillRegion(data, width, region, value);
+    buffer.EndWrite(region);
+
+    FillRegion(expected.data(), width, region, value);
+}
+
+/// Checks the latest buffer seen by a reader
+void
+CheckMapped(HdCyclesRenderBuffer& buffer, const std::vector<uint8_t>& expected)
+{
+    auto data = static_cast<const uint8_t*>(buffer.Map());
+    REQUIRE(data != nullptr);
+    CHECK(std::vector<uint8_t>(data, data + expected.size()) == expected);
+    buffer.Unmap();
+}
+
+}  // namespace
+
+TEST_SUITE("Testing HdCyclesRenderBuffer")
+{
+    const GfRect2i full { GfVec2i { 0, 0 }, width, height };
+
+    TEST_CASE("Writes before allocation")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        CHECK(buffer.BeginWrite(full) == nullptr);
+        CHECK(buffer.Map() == nullptr);
+        CHECK_FALSE(buffer.IsMapped());
+    }
+
+    TEST_CASE("Writer never touches the mapped buffer")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, full, 1, expected);
+
+        uint64_t mapped_version = 0;
+        auto mapped = static_cast<const uint8_t*>(buffer.Map(&mapped_version));
+        REQUIRE(mapped != nullptr);
+        CHECK(mapped_version == buffer.GetVersion());
+        const std::vector<uint8_t> pinned = expected;
+
+        // Every write has to go to one of the other buffers, also when the reader keeps the buffer for a while
+        for (uint8_t value = 2; value < 8; ++value) {
+            auto data = static_cast<uint8_t*>(buffer.BeginWrite(full));
+            REQUIRE(data != nullptr);
+            CHECK(data != mapped);
+            FillRegion(data, width, full, value);
+            buffer.EndWrite(full);
+
+            FillRegion(expected.data(), width, full, value);
+            CHECK(std::vector<uint8_t>(mapped, mapped + pinned.size()) == pinned);
+        }
+
+        // Concurrent readers share the pinned buffer
+        uint64_t shared_version = 0;
+        CHECK(buffer.Map(&shared_version) == mapped);
+        CHECK(shared_version == mapped_version);
+        buffer.Unmap();
+        CHECK(buffer.IsMapped());
+        buffer.Unmap();
+        CHECK_FALSE(buffer.IsMapped());
+
+        // Next reader gets the latest buffer
+        CheckMapped(buffer, expected);
+    }
+
+    TEST_CASE("Stale region is copied forward after a partial write")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, full, 1, expected);
+
+        // Each back buffer is behind the latest by the regions written to the other buffers
+        const GfRect2i regions[] = {
+            GfRect2i { GfVec2i { 1, 1 }, 2, 2 }, GfRect2i { GfVec2i { 0, 0 }, 1, 4 },
+            GfRect2i { GfVec2i { 2, 3 }, 2, 1 }, GfRect2i { GfVec2i { 3, 0 }, 1, 1 },
+            GfRect2i { GfVec2i { 0, 2 }, 4, 1 }, GfRect2i { GfVec2i { 1, 1 }, 2, 2 },
+        };
+
+        uint8_t value = 2;
+        for (const GfRect2i& region : regions) {
+            CAPTURE(static_cast<int>(value));
+            WriteRegion(buffer, region, value++, expected);
+            CheckMapped(buffer, expected);
+        }
+
+        // Writes while a reader holds the buffer still see the latest data
+        auto mapped = static_cast<const uint8_t*>(buffer.Map());
+        REQUIRE(mapped != nullptr);
+        for (const GfRect2i& region : regions) {
+            CAPTURE(static_cast<int>(value));
+            WriteRegion(buffer, region, value++, expected);
+        }
+        buffer.Unmap();
+        CheckMapped(buffer, expected);
+    }
+
+    TEST_CASE("Separate stale regions are copied forward individually")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, full, 1, expected);
+
+        // Buffer the reader holds falls behind by the corners written in the meantime
+        auto mapped = static_cast<const uint8_t*>(buffer.Map());
+        REQUIRE(mapped != nullptr);
+        const GfRect2i corners[] = {
+            GfRect2i { GfVec2i { 0, 0 }, 1, 1 },
+            GfRect2i { GfVec2i { 3, 3 }, 1, 1 },
+            GfRect2i { GfVec2i { 3, 0 }, 1, 1 },
+        };
+        uint8_t value = 2;
+        for (const GfRect2i& corner : corners) {
+            WriteRegion(buffer, corner, value++, expected);
+        }
+        buffer.Unmap();
+
+        // Whichever buffer the writes land in, each of them needs every corner
+        const GfRect2i center { GfVec2i { 1, 1 }, 2, 2 };
+        for (int i = 0; i < 3; ++i) {
+            CAPTURE(i);
+            WriteRegion(buffer, center, value++, expected);
+            CheckMapped(buffer, expected);
+        }
+    }
+
+    TEST_CASE("Discarded write keeps the latest data")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        const GfRect2i region { GfVec2i { 1, 1 }, 2, 2 };
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, full, 1, expected);
+        WriteRegion(buffer, region, 2, expected);
+
+        // Back buffer is only behind by the region, the full write is dropped after it was partially filled
+        const uint64_t version = buffer.GetVersion();
+        auto data = static_cast<uint8_t*>(buffer.BeginWrite(full));
+        REQUIRE(data != nullptr);
+        FillRegion(data, width, full, 9);
+        buffer.DiscardWrite(full);
+
+        CHECK(buffer.GetVersion() == version);
+        CHECK(buffer.GetChangedRegion(version).IsEmpty());
+        CheckMapped(buffer, expected);
+
+        // Same back buffer is picked again, it has to be refreshed outside of the region
+        WriteRegion(buffer, region, 3, expected);
+        CheckMapped(buffer, expected);
+    }
+
+    TEST_CASE("Allocate waits for readers to unmap")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, full, 1, expected);
+
+        uint64_t version = 0;
+        auto mapped = static_cast<const uint8_t*>(buffer.Map(&version));
+        REQUIRE(mapped != nullptr);
+
+        std::atomic<bool> allocated { false };
+        std::thread resize { [&]() {
+            buffer.Allocate(GfVec3i { 8, 2, 1 }, HdFormatUNorm8, false);
+            allocated = true;
+        } };
+
+        // Mapped data stays valid until the reader is done with it
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK_FALSE(allocated.load());
+        CHECK(std::vector<uint8_t>(mapped, mapped + expected.size()) == expected);
+
+        buffer.Unmap();
+        resize.join();
+        CHECK(allocated.load());
+
+        CHECK(buffer.GetWidth() == 8);
+        CHECK(buffer.GetHeight() == 2);
+        CHECK(buffer.GetChangedRegion(version) == GfRect2i(GfVec2i { 0, 0 }, 8, 2));
+        CheckMapped(buffer, std::vector<uint8_t>(8 * 2, 0));
+    }
+
+    TEST_CASE("Concurrent writers share the back buffer")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, full, 1, expected);
+        const uint64_t version = buffer.GetVersion();
+
+        const GfRect2i left { GfVec2i { 0, 0 }, 2, 4 };
+        const GfRect2i right { GfVec2i { 2, 1 }, 2, 2 };
+        auto left_data = static_cast<uint8_t*>(buffer.BeginWrite(left));
+        auto right_data = static_cast<uint8_t*>(buffer.BeginWrite(right));
+        REQUIRE(left_data != nullptr);
+        CHECK(right_data == left_data);
+
+        FillRegion(left_data, width, left, 2);
+        FillRegion(expected.data(), width, left, 2);
+        buffer.EndWrite(left);
+
+        // Nothing is published while a writer is still busy
+        CHECK(buffer.GetVersion() == version);
+        CheckMapped(buffer, std::vector<uint8_t>(width * height, 1));
+
+        FillRegion(right_data, width, right, 3);
+        FillRegion(expected.data(), width, right, 3);
+        buffer.EndWrite(right);
+
+        // Regions of the batch are published together
+        std::vector<GfRect2i> regions;
+        uint64_t latest = 0;
+        CHECK(buffer.GetChangedRegions(version, &regions, &latest));
+        CHECK(latest == version + 1);
+        REQUIRE(regions.size() == 2);
+        CHECK(std::find(regions.begin(), regions.end(), left) != regions.end());
+        CHECK(std::find(regions.begin(), regions.end(), right) != regions.end());
+        CheckMapped(buffer, expected);
+    }
+
+    TEST_CASE("Discarded region of a shared write keeps the latest data")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, full, 1, expected);
+        const uint64_t version = buffer.GetVersion();
+
+        const GfRect2i top { GfVec2i { 0, 0 }, 4, 2 };
+        const GfRect2i bottom { GfVec2i { 0, 2 }, 4, 2 };
+        auto data = static_cast<uint8_t*>(buffer.BeginWrite(top));
+        REQUIRE(data != nullptr);
+        REQUIRE(buffer.BeginWrite(bottom) == data);
+
+        FillRegion(data, width, bottom, 9);
+        buffer.DiscardWrite(bottom);
+        FillRegion(data, width, top, 2);
+        FillRegion(expected.data(), width, top, 2);
+        buffer.EndWrite(top);
+
+        CHECK(buffer.GetVersion() == version + 1);
+        CHECK(buffer.GetChangedRegion(version) == top);
+        CheckMapped(buffer, expected);
+
+        // Batch where every writer discards publishes nothing
+        data = static_cast<uint8_t*>(buffer.BeginWrite(full));
+        REQUIRE(data != nullptr);
+        FillRegion(data, width, full, 9);
+        buffer.DiscardWrite(full);
+        CHECK(buffer.GetVersion() == version + 1);
+
+        WriteRegion(buffer, bottom, 3, expected);
+        CheckMapped(buffer, expected);
+    }
+
+    TEST_CASE("Writers are turned away while a resize waits for readers")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, full, 1, expected);
+        REQUIRE(buffer.Map() != nullptr);
+
+        std::thread resize { [&]() { buffer.Allocate(GfVec3i { 8, 2, 1 }, HdFormatUNorm8, false); } };
+
+        // Writers don't queue up behind the resize, they get nothing until it is done
+        bool turned_away = false;
+        for (int i = 0; i < 1000; ++i) {
+            auto data = static_cast<uint8_t*>(buffer.BeginWrite(full));
+            if (!data) {
+                turned_away = true;
+                break;
+            }
+            FillRegion(data, width, full, 2);
+            buffer.EndWrite(full);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(turned_away);
+
+        buffer.Unmap();
+        resize.join();
+        CHECK(buffer.GetWidth() == 8);
+        CHECK(buffer.BeginWrite(GfRect2i { GfVec2i { 0, 0 }, 8, 2 }) != nullptr);
+        buffer.EndWrite(GfRect2i { GfVec2i { 0, 0 }, 8, 2 });
+    }
+
+    TEST_CASE("Tiles are blitted concurrently")
+    {
+        constexpr int frame_size = 64;
+        constexpr int tile_size = 16;
+        constexpr int tiles = frame_size / tile_size;
+
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { frame_size, frame_size, 1 }, HdFormatUNorm8, false));
+
+        // Every thread renders a column of tiles several times while a reader keeps mapping the buffer
+        std::atomic<bool> done { false };
+        std::thread reader { [&]() {
+            while (!done.load()) {
+                if (buffer.Map()) {
+                    buffer.Unmap();
+                }
+            }
+        } };
+
+        std::vector<std::thread> writers;
+        for (int column = 0; column < tiles; ++column) {
+            writers.emplace_back([&buffer, column]() {
+                for (int pass = 0; pass < 50; ++pass) {
+                    for (int row = 0; row < tiles; ++row) {
+                        const std::vector<uint8_t> tile(tile_size * tile_size,
+                                                        static_cast<uint8_t>(column * tiles + row + pass));
+                        buffer.BlitTile(HdFormatUNorm8, column * tile_size, row * tile_size, tile_size, tile_size,
+                                        frame_size, frame_size, 0, tile_size, tile.data());
+                    }
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        done = true;
+        reader.join();
+
+        std::vector<uint8_t> expected(frame_size * frame_size);
+        for (int y = 0; y < frame_size; ++y) {
+            for (int x = 0; x < frame_size; ++x) {
+                expected[y * frame_size + x] = static_cast<uint8_t>((x / tile_size) * tiles + y / tile_size + 49);
+            }
+        }
+        auto data = static_cast<const uint8_t*>(buffer.Map());
+        REQUIRE(data != nullptr);
+        CHECK(std::vector<uint8_t>(data, data + expected.size()) == expected);
+        buffer.Unmap();
+    }
+
+    TEST_CASE("Changed region is empty when nothing was written")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        const uint64_t version = buffer.GetVersion();
+        CHECK(buffer.GetChangedRegion(version).IsEmpty());
+        CHECK(buffer.GetChangedRegion(version + 1).IsEmpty());
+
+        std::vector<uint8_t> expected(width * height, 0);
+        WriteRegion(buffer, GfRect2i { GfVec2i { 1, 2 }, 1, 1 }, 1, expected);
+        CHECK(buffer.GetChangedRegion(buffer.GetVersion()).IsEmpty());
+    }
+
+    TEST_CASE("Changed region is the union of the writes since the version")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        const GfRect2i first { GfVec2i { 0, 0 }, 1, 1 };
+        const GfRect2i second { GfVec2i { 2, 1 }, 1, 2 };
+        const GfRect2i third { GfVec2i { 1, 3 }, 1, 1 };
+
+        std::vector<uint8_t> expected(width * height, 0);
+        const uint64_t version = buffer.GetVersion();
+        WriteRegion(buffer, first, 1, expected);
+        const uint64_t first_version = buffer.GetVersion();
+        WriteRegion(buffer, second, 2, expected);
+        WriteRegion(buffer, third, 3, expected);
+
+        CHECK(buffer.GetChangedRegion(version) == GfRect2i(GfVec2i { 0, 0 }, 3, 4));
+        CHECK(buffer.GetChangedRegion(first_version) == GfRect2i(GfVec2i { 1, 1 }, 2, 3));
+        CHECK(buffer.GetChangedRegion(buffer.GetVersion() - 1) == third);
+
+        // Every write is reported on its own
+        std::vector<GfRect2i> regions;
+        uint64_t latest = 0;
+        CHECK(buffer.GetChangedRegions(version, &regions, &latest));
+        CHECK(latest == buffer.GetVersion());
+        REQUIRE(regions.size() == 3);
+        CHECK(std::find(regions.begin(), regions.end(), first) != regions.end());
+        CHECK(std::find(regions.begin(), regions.end(), second) != regions.end());
+        CHECK(std::find(regions.begin(), regions.end(), third) != regions.end());
+
+        // Reader mapping the latest buffer gets its version
+        uint64_t mapped_version = 0;
+        REQUIRE(buffer.Map(&mapped_version) != nullptr);
+        buffer.Unmap();
+        CHECK(mapped_version == buffer.GetVersion());
+        CHECK(buffer.GetChangedRegion(mapped_version).IsEmpty());
+    }
+
+    TEST_CASE("Changed region falls back to the full buffer")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        const GfRect2i pixel { GfVec2i { 1, 1 }, 1, 1 };
+        std::vector<uint8_t> expected(width * height, 0);
+
+        // Versions from before the allocation
+        CHECK(buffer.GetChangedRegion(0) == full);
+        const uint64_t version = buffer.GetVersion();
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+        WriteRegion(buffer, pixel, 1, expected);
+        CHECK(buffer.GetChangedRegion(version) == full);
+
+        // Versions older than the history of written regions
+        const uint64_t old_version = buffer.GetVersion();
+        for (int i = 0; i < 1000; ++i) {
+            WriteRegion(buffer, pixel, static_cast<uint8_t>(i), expected);
+        }
+        CHECK(buffer.GetChangedRegion(old_version) == full);
+        CHECK(buffer.GetChangedRegion(buffer.GetVersion() - 1) == pixel);
+
+        std::vector<GfRect2i> regions;
+        CHECK_FALSE(buffer.GetChangedRegions(old_version, &regions, nullptr));
+        CHECK(regions == std::vector<GfRect2i> { full });
+
+        // Writes from before a resize are not part of the smaller buffer
+        const uint64_t resize_version = buffer.GetVersion();
+        WriteRegion(buffer, GfRect2i { GfVec2i { 3, 3 }, 1, 1 }, 1, expected);
+        REQUIRE(buffer.Allocate(GfVec3i { 2, 2, 1 }, HdFormatUNorm8, false));
+        CHECK(buffer.GetChangedRegion(resize_version) == GfRect2i(GfVec2i { 0, 0 }, 2, 2));
+    }
+    TEST_CASE("Blit tile without scaling")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        const std::vector<uint8_t> tile { 1, 2, 3, 4 };
+        buffer.BlitTile(HdFormatUNorm8, 1, 2, 2, 2, width, height, 0, 2, tile.data());
+
+        std::vector<uint8_t> expected(width * height, 0);
+        expected[2 * width + 1] = 1;
+        expected[2 * width + 2] = 2;
+        expected[3 * width + 1] = 3;
+        expected[3 * width + 2] = 4;
+        CheckMapped(buffer, expected);
+
+        // Same pixels from a tile with an offset and padded rows
+        const std::vector<uint8_t> padded { 9, 5, 6, 9, 7, 8, 9 };
+        buffer.BlitTile(HdFormatUNorm8, 1, 2, 2, 2, width, height, 1, 3, padded.data());
+
+        expected[2 * width + 1] = 5;
+        expected[2 * width + 2] = 6;
+        expected[3 * width + 1] = 7;
+        expected[3 * width + 2] = 8;
+        CheckMapped(buffer, expected);
+
+        // Rows shorter than the tile are rejected
+        const uint64_t version = buffer.GetVersion();
+        buffer.BlitTile(HdFormatUNorm8, 1, 2, 2, 2, width, height, 0, 1, tile.data());
+        CHECK(buffer.GetVersion() == version);
+        CheckMapped(buffer, expected);
+    }
+
+    TEST_CASE("Blit scaled tiles")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        // Frame of 2x2 pixels, every source pixel covers 2x2 pixels of the buffer
+        const std::vector<uint8_t> tile { 1, 2, 3, 4 };
+        buffer.BlitTile(HdFormatUNorm8, 0, 0, 2, 2, 2.0f, 2.0f, 0, 2, tile.data());
+        CheckMapped(buffer, { 1, 1, 2, 2, 1, 1, 2, 2, 3, 3, 4, 4, 3, 3, 4, 4 });
+
+        const std::vector<uint8_t> pixel { 7 };
+        buffer.BlitTile(HdFormatUNorm8, 1, 1, 1, 1, 2.0f, 2.0f, 0, 1, pixel.data());
+        CheckMapped(buffer, { 1, 1, 2, 2, 1, 1, 2, 2, 3, 3, 7, 7, 3, 3, 7, 7 });
+
+        // Frame of 8x8 pixels, every other source pixel is kept
+        std::vector<uint8_t> frame(8 * 8);
+        for (size_t i = 0; i < frame.size(); ++i) {
+            frame[i] = static_cast<uint8_t>(i);
+        }
+        buffer.BlitTile(HdFormatUNorm8, 0, 0, 8, 8, 8.0f, 8.0f, 0, 8, frame.data());
+
+        std::vector<uint8_t> expected(width * height);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                expected[y * width + x] = static_cast<uint8_t>(y * 2 * 8 + x * 2);
+            }
+        }
+        CheckMapped(buffer, expected);
+    }
+
+    TEST_CASE("Blit tiles clamped to the buffer")
+    {
+        HdCyclesRenderBuffer buffer { nullptr, SdfPath { "/buffer" } };
+        REQUIRE(buffer.Allocate(GfVec3i { width, height, 1 }, HdFormatUNorm8, false));
+
+        // Frame of 3x3 pixels, rounding moves the tile at (2, 2) to (3, 3) and past the edge of the buffer
+        const std::vector<uint8_t> tile { 1, 2, 3, 4 };
+        buffer.BlitTile(HdFormatUNorm8, 2, 2, 2, 2, 3.0f, 3.0f, 0, 2, tile.data());
+
+        std::vector<uint8_t> expected(width * height, 0);
+        expected[3 * width + 3] = 1;
+        CheckMapped(buffer, expected);
+        CHECK(buffer.GetChangedRegion(buffer.GetVersion() - 1) == GfRect2i(GfVec2i { 3, 3 }, 1, 1));
+
+        // Tile starting past the edge is skipped
+        const uint64_t version = buffer.GetVersion();
+        buffer.BlitTile(HdFormatUNorm8, 3, 0, 2, 2, 3.0f, 3.0f, 0, 2, tile.data());
+        CHECK(buffer.GetVersion() == version);
+        CheckMapped(buffer, expected);
+    }
+}
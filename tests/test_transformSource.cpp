@@ -185,4 +185,80 @@ TEST_SUITE("Testing HdCyclesTransformSource")
         CHECK(src.Resolve() == true);
         CHECK(src.GetObject()->motion.size() == 3);
     }
-}
\ No newline at end of file
+
+    TEST_CASE("Batched resample of many objects")
+    {
+        const float times[] = { -0.5f, 0.5f };
+        auto weights = HdCyclesTransformSource::ComputeResampleWeights(times, 2, 3);
+        REQUIRE(weights.count == 3);
+
+        // Sample major input, two objects moving along x
+        const ccl::Transform transforms[] = {
+            ccl::transform_translate(0.0f, 0.0f, 0.0f),
+            ccl::transform_translate(10.0f, 0.0f, 0.0f),
+            ccl::transform_translate(2.0f, 0.0f, 0.0f),
+            ccl::transform_translate(14.0f, 0.0f, 0.0f),
+        };
+
+        ccl::Transform resampled[6];
+        HdCyclesTransformSource::ResampleUniform(weights, transforms, 2, resampled);
+        CHECK(resampled[0].x.w == doctest::Approx { 0.0f });
+        CHECK(resampled[1].x.w == doctest::Approx { 10.0f });
+        CHECK(resampled[2].x.w == doctest::Approx { 1.0f });
+        CHECK(resampled[3].x.w == doctest::Approx { 12.0f });
+        CHECK(resampled[4].x.w == doctest::Approx { 2.0f });
+        CHECK(resampled[5].x.w == doctest::Approx { 14.0f });
+    }
+
+    TEST_CASE("Resolve sources in batch")
+    {
+        auto static_object = std::make_unique<ccl::Object>();
+        auto moving_object = std::make_unique<ccl::Object>();
+
+        HdCyclesMatrix4dTimeSampleArray static_samples;
+        static_samples.Resize(1);
+        static_samples.values[0].SetTranslate(GfVec3d { 1.0, 0.0, 0.0 });
+
+        HdCyclesMatrix4dTimeSampleArray moving_samples;
+        moving_samples.Resize(2);
+        moving_samples.times[0] = -0.5;
+        moving_samples.times[1] = +0.5;
+        moving_samples.values[0].SetTranslate(GfVec3d { 0.0, 0.0, 0.0 });
+        moving_samples.values[1].SetTranslate(GfVec3d { 2.0, 0.0, 0.0 });
+
+        HdCyclesTransformSource static_src { static_object.get(), static_samples, _fallback };
+        HdCyclesTransformSource moving_src { moving_object.get(), moving_samples, _fallback, 3 };
+        std::vector<HdCyclesTransformSource*> sources { &static_src, &moving_src };
+
+        CHECK(HdCyclesTransformSource::ResolveBatch(sources) == 2);
+        CHECK(static_src.IsResolved() == true);
+        CHECK(moving_src.IsResolved() == true);
+        CHECK(static_object->motion.size() == 0);
+        REQUIRE(moving_object->motion.size() == 3);
+        CHECK(moving_object->motion[1].x.w == doctest::Approx { 1.0f });
+
+        // Already resolved sources are skipped
+        CHECK(HdCyclesTransformSource::ResolveBatch(sources) == 0);
+    }
+
+    TEST_CASE("Time samplings are interned")
+    {
+        HdCyclesTimeSamplingCache cache;
+
+        const float times[] = { -0.5f, -0.5f, 0.0f, 0.5f };
+        const HdCyclesTimeSampling& sampling = cache.Get(times, 4, 0);
+        CHECK(&cache.Get(times, 4, 0) == &sampling);
+        CHECK(cache.GetSize() == 1);
+
+        // Overlapping sample is removed, remaining samples are copied
+        CHECK(sampling.centered == true);
+        REQUIRE(sampling.indices.size() == 3);
+        CHECK(sampling.indices[2] == 3);
+        REQUIRE(sampling.weights.count == 3);
+        CHECK(sampling.weights.values[1].prev == sampling.weights.values[1].next);
+
+        // Requested number of samples is a part of the key
+        CHECK(cache.Get(times, 4, 5).weights.count == 5);
+        CHECK(cache.GetSize() == 2);
+    }
+}
@@ -0,0 +1,317 @@
+//  Copyright 2021 Tangent Animation
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied,
+//  including without limitation, as related to merchantability and fitness
+//  for a particular purpose.
+//
+//  In no event shall any copyright holder be liable for any damages of any kind
+//  arising from the use of this software, whether in contract, tort or otherwise.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+
+#include <doctest/doctest.h>
+
+#include <hdCycles/utils.h>
+
+#include <pxr/base/vt/array.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace {
+
+/// Forces the array conversion instruction set, the one selected for the cpu is restored at the end of the scope
+struct ForcedArrayConversionIsa {
+    explicit ForcedArrayConversionIsa(HdCyclesArrayConversionIsa isa)
+        : previous { HdCyclesGetArrayConversionIsa() }
+        , supported { HdCyclesSetArrayConversionIsa(isa) }
+    {
+    }
+
+    ~ForcedArrayConversionIsa() { HdCyclesSetArrayConversionIsa(previous); }
+
+    HdCyclesArrayConversionIsa previous;
+    bool supported;
+};
+
+/// Runs the test for every instruction set supported by the build and the cpu
+template<typename Fn>
+void
+ForEachArrayConversionIsa(Fn fn)
+{
+    for (auto isa : { HdCyclesArrayConversionIsa::Scalar, HdCyclesArrayConversionIsa::SSE,
+                      HdCyclesArrayConversionIsa::AVX2 }) {
+        ForcedArrayConversionIsa forced { isa };
+        if (!forced.supported) {
+            MESSAGE("Skipping unsupported array conversion instruction set " << static_cast<int>(isa));
+            continue;
+        }
+
+        CAPTURE(static_cast<int>(isa));
+        fn();
+    }
+}
+
+}  // namespace
+
+TEST_SUITE("Testing array conversions")
+{
+    // sizes cover every tail length of the widest kernel, offset source and destination make loads unaligned
+    constexpr size_t max_size = 37;
+    constexpr size_t max_offset = 3;
+
+    TEST_CASE("Scalar and SSE are always available on x86-64")
+    {
+        {
+            ForcedArrayConversionIsa forced { HdCyclesArrayConversionIsa::Scalar };
+            CHECK(forced.supported);
+            CHECK(HdCyclesGetArrayConversionIsa() == HdCyclesArrayConversionIsa::Scalar);
+        }
+
+#if defined(__x86_64__) || defined(_M_X64)
+        {
+            ForcedArrayConversionIsa forced { HdCyclesArrayConversionIsa::SSE };
+            CHECK(forced.supported);
+            CHECK(HdCyclesGetArrayConversionIsa() == HdCyclesArrayConversionIsa::SSE);
+        }
+#endif
+    }
+
+    TEST_CASE("GfVec3f to float3 matches scalar reference")
+    {
+        ForEachArrayConversionIsa([&]() {
+            for (size_t offset = 0; offset <= max_offset; ++offset) {
+                for (size_t size = 0; size < max_size; ++size) {
+                    VtVec3fArray src(size + offset);
+                    for (size_t i = 0; i < src.size(); ++i) {
+                        const auto value = static_cast<float>(i);
+                        src[i] = GfVec3f { value - 7.0f, value * 0.25f, 1.0f / (1.0f + value) };
+                    }
+
+                    std::vector<ccl::float3> dst(size + offset);
+                    vec3f_to_float3(src.cdata() + offset, dst.data() + offset, size);
+
+                    for (size_t i = offset; i < src.size(); ++i) {
+                        CHECK(dst[i].x == src[i][0]);
+                        CHECK(dst[i].y == src[i][1]);
+                        CHECK(dst[i].z == src[i][2]);
+                    }
+                }
+            }
+        });
+    }
+
+    TEST_CASE("GfVec4f to float3 matches scalar reference")
+    {
+        ForEachArrayConversionIsa([&]() {
+            for (size_t offset = 0; offset <= max_offset; ++offset) {
+                for (size_t size = 0; size < max_size; ++size) {
+                    VtVec4fArray src(size + offset);
+                    for (size_t i = 0; i < src.size(); ++i) {
+                        const auto value = static_cast<float>(i);
+                        src[i] = GfVec4f { value, -value, value * 0.5f, value + 2.0f };
+                    }
+
+                    std::vector<ccl::float3> dst(size + offset);
+                    vec4f_to_float3(src.cdata() + offset, dst.data() + offset, size);
+
+                    for (size_t i = offset; i < src.size(); ++i) {
+                        CHECK(dst[i].x == src[i][0]);
+                        CHECK(dst[i].y == src[i][1]);
+                        CHECK(dst[i].z == src[i][2]);
+                    }
+                }
+            }
+        });
+    }
+
+    TEST_CASE("half to float matches scalar reference")
+    {
+        ForEachArrayConversionIsa([&]() {
+            for (size_t offset = 0; offset <= max_offset; ++offset) {
+                for (size_t size = 0; size < max_size; ++size) {
+                    VtHalfArray src(size + offset);
+                    for (size_t i = 0; i < src.size(); ++i) {
+                        src[i] = GfHalf { static_cast<float>(i) * 0.37f - 5.0f };
+                    }
+
+                    std::vector<float> dst(size + offset, -1.0f);
+                    half_to_float(src.cdata() + offset, dst.data() + offset, size);
+
+                    for (size_t i = 0; i < offset; ++i) {
+                        CHECK(dst[i] == -1.0f);
+                    }
+                    for (size_t i = offset; i < src.size(); ++i) {
+                        CHECK(dst[i] == static_cast<float>(src[i]));
+                    }
+                }
+            }
+        });
+    }
+
+    TEST_CASE("double to float matches scalar reference")
+    {
+        ForEachArrayConversionIsa([&]() {
+            for (size_t offset = 0; offset <= max_offset; ++offset) {
+                for (size_t size = 0; size < max_size; ++size) {
+                    VtDoubleArray src(size + offset);
+                    for (size_t i = 0; i < src.size(); ++i) {
+                        src[i] = static_cast<double>(i) * 1.1 - 1e10 / (1.0 + static_cast<double>(i));
+                    }
+
+                    std::vector<float> dst(size + offset, -1.0f);
+                    double_to_float(src.cdata() + offset, dst.data() + offset, size);
+
+                    for (size_t i = 0; i < offset; ++i) {
+                        CHECK(dst[i] == -1.0f);
+                    }
+                    for (size_t i = offset; i < src.size(); ++i) {
+                        CHECK(dst[i] == static_cast<float>(src[i]));
+                    }
+                }
+            }
+        });
+    }
+
+    TEST_CASE("float to half matches scalar reference")
+    {
+        ForEachArrayConversionIsa([&]() {
+            for (size_t offset = 0; offset <= max_offset; ++offset) {
+                for (size_t size = 0; size < max_size; ++size) {
+                    std::vector<float> src(size + offset);
+                    for (size_t i = 0; i < src.size(); ++i) {
+                        src[i] = static_cast<float>(i) * 0.37f - 3.0f;
+                    }
+
+                    std::vector<GfHalf> dst(size + offset);
+                    float_to_half(src.data() + offset, dst.data() + offset, size);
+
+                    for (size_t i = offset; i < src.size(); ++i) {
+                        CHECK(dst[i].bits() == GfHalf { src[i] }.bits());
+                    }
+                }
+            }
+        });
+    }
+
+    TEST_CASE("float to unorm8 matches scalar reference")
+    {
+        ForEachArrayConversionIsa([&]() {
+            for (size_t offset = 0; offset <= max_offset; ++offset) {
+                for (size_t size = 0; size < max_size; ++size) {
+                    std::vector<float> src(size + offset);
+                    for (size_t i = 0; i < src.size(); ++i) {
+                        src[i] = static_cast<float>(i) / 32.0f - 0.1f;
+                    }
+                    if (size > 0) {
+                        src[offset] = std::numeric_limits<float>::quiet_NaN();
+                    }
+
+                    std::vector<uint8_t> dst(size + offset, 7);
+                    float_to_unorm8(src.data() + offset, dst.data() + offset, size);
+
+                    for (size_t i = 0; i < offset; ++i) {
+                        CHECK(dst[i] == 7);
+                    }
+                    if (size > 0) {
+                        CHECK(dst[offset] == 0);
+                    }
+                    for (size_t i = offset + 1; i < src.size(); ++i) {
+                        const float value = std::min(std::max(src[i], 0.0f), 1.0f);
+                        CHECK(dst[i] == static_cast<uint8_t>(value * 255.0f));
+                    }
+                }
+            }
+        });
+    }
+
+    TEST_CASE("offset int32 matches scalar reference")
+    {
+        ForEachArrayConversionIsa([&]() {
+            for (size_t offset = 0; offset <= max_offset; ++offset) {
+                for (size_t size = 0; size < max_size; ++size) {
+                    std::vector<int32_t> data(size + offset);
+                    for (size_t i = 0; i < data.size(); ++i) {
+                        data[i] = static_cast<int32_t>(i) - 3;
+                    }
+
+                    offset_int32(data.data() + offset, -1, size);
+
+                    for (size_t i = 0; i < data.size(); ++i) {
+                        CHECK(data[i] == static_cast<int32_t>(i) - 3 - (i < offset ? 0 : 1));
+                    }
+                }
+            }
+        });
+    }
+
+    TEST_CASE("double and half arrays to float arrays")
+    {
+        ForEachArrayConversionIsa([&]() {
+            for (size_t size = 0; size < max_size; ++size) {
+                VtVec3dArray src3d(size);
+                VtVec2hArray src2h(size);
+                VtDoubleArray src1d(size);
+                for (size_t i = 0; i < size; ++i) {
+                    const auto value = static_cast<double>(i);
+                    src3d[i] = GfVec3d { value * 1.1, -value, value / 3.0 };
+                    src2h[i] = GfVec2h { GfHalf { static_cast<float>(value) * 0.5f }, GfHalf { -1.0f } };
+                    src1d[i] = value * 0.1;
+                }
+
+                VtValue value3f = array_to_float_array(VtValue { src3d });
+                VtValue value2f = array_to_float_array(VtValue { src2h });
+                VtValue value1f = array_to_float_array(VtValue { src1d });
+
+                // empty arrays are left as they are
+                if (size == 0) {
+                    CHECK(value3f.IsHolding<VtVec3dArray>());
+                    continue;
+                }
+
+                REQUIRE(value3f.IsHolding<VtVec3fArray>());
+                REQUIRE(value2f.IsHolding<VtVec2fArray>());
+                REQUIRE(value1f.IsHolding<VtFloatArray>());
+
+                const auto& dst3f = value3f.UncheckedGet<VtVec3fArray>();
+                const auto& dst2f = value2f.UncheckedGet<VtVec2fArray>();
+                const auto& dst1f = value1f.UncheckedGet<VtFloatArray>();
+                REQUIRE(dst3f.size() == size);
+                REQUIRE(dst2f.size() == size);
+                REQUIRE(dst1f.size() == size);
+
+                for (size_t i = 0; i < size; ++i) {
+                    for (size_t c = 0; c < 3; ++c) {
+                        CHECK(dst3f[i][c] == static_cast<float>(src3d[i][c]));
+                    }
+                    for (size_t c = 0; c < 2; ++c) {
+                        CHECK(dst2f[i][c] == static_cast<float>(src2h[i][c]));
+                    }
+                    CHECK(dst1f[i] == static_cast<float>(src1d[i]));
+                }
+            }
+        });
+    }
+
+    TEST_CASE("non double and half values are not converted")
+    {
+        const VtIntArray ints(3, 1);
+        CHECK(array_to_float_array(VtValue { ints }).IsHolding<VtIntArray>());
+
+        const VtVec3fArray floats(3, GfVec3f { 1.0f });
+        CHECK(array_to_float_array(VtValue { floats }).IsHolding<VtVec3fArray>());
+
+        CHECK(array_to_float_array(VtValue { 1.0 }).IsHolding<double>());
+    }
+}